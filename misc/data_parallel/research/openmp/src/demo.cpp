@@ -16,6 +16,7 @@
 #include "particle.h"
 #include "airfoil.h"
 #include "world.h"
+#include "tuner.h"
 
 using namespace std;
 using namespace wingworks;
@@ -42,7 +43,8 @@ namespace {
         return outs.str();
     }
 
-    void write_foil_forces(const size_t step_num, const World& world) {
+    template <typename Real, typename Species>
+    void write_foil_forces(const size_t step_num, const BasicWorld<Real, Species>& world) {
         ofstream outf(foil_force_file_name(step_num));
         world.write_force_on_foil(outf);
         outf.close();
@@ -54,14 +56,170 @@ namespace {
         return outs.str();
     }
 
-    void write_positions(const size_t step_num, const World& world) {
+    template <typename Real, typename Species>
+    void write_positions(const size_t step_num, const BasicWorld<Real, Species>& world) {
         ofstream outf(pos_file_name(step_num));
         world.write_particle_positions(outf);
         outf.close();
     }
+
+    string cell_stats_file_name(const size_t step_num) {
+        ostringstream outs;
+        outs << "cell_stats_" << setfill('0') << setw(4) << step_num << ".csv";
+        return outs.str();
+    }
+
+    template <typename Real, typename Species>
+    void write_cell_stats(const size_t step_num, const BasicWorld<Real, Species>& world) {
+        ofstream outf(cell_stats_file_name(step_num));
+        world.write_cell_stats(outf);
+        outf.close();
+    }
+
+    struct DemoArgs {
+        WorldOptions options;
+        // If set, calibrate and write the resulting profile here.
+        string calibrate_path;
+        // Store particles as float rather than double.
+        bool single_precision = false;
+    };
+
+    // Usage: demo [--cell-stats] [--cell-extent <extent>]
+    //             [--fused [--tile-columns <n>]]
+    //             [--neighbor-lists [--skin <distance>] | --incremental-cells]
+    //             [--reorder <steps>]
+    //             [--profile <path> | --calibrate <path>] [--single]
+    //             [--balance-cells [--balance-interval <steps>]] [--huge-pages]
+    //             [--frame-channel <name>] [--dsmc [--dsmc-weight <molecules>]]
+    //             [--coarsen [--coarsen-interval <steps>] [--refine-margin <distance>]]
+    //             [--open [--freestream-walls]]
+    DemoArgs parse_args(int argc, char **argv) {
+        DemoArgs result;
+        WorldOptions& options(result.options);
+        for (int i = 1; i < argc; ++i) {
+            const string arg(argv[i]);
+            if (arg == "--cell-stats") {
+                options.collect_cell_stats = true;
+            } else if ((arg == "--cell-extent") && (i + 1 < argc)) {
+                options.cell_extent = ::atof(argv[++i]);
+            } else if (arg == "--fused") {
+                options.executor = StepExecutor::Fused;
+            } else if ((arg == "--tile-columns") && (i + 1 < argc)) {
+                options.tile_columns = ::atoi(argv[++i]);
+            } else if (arg == "--neighbor-lists") {
+                options.neighbor_lists = true;
+            } else if (arg == "--incremental-cells") {
+                options.incremental_cells = true;
+            } else if ((arg == "--reorder") && (i + 1 < argc)) {
+                options.reorder_interval = ::atoi(argv[++i]);
+            } else if (arg == "--balance-cells") {
+                options.balance_cells = true;
+            } else if ((arg == "--balance-interval") && (i + 1 < argc)) {
+                options.balance_interval = ::atoi(argv[++i]);
+            } else if ((arg == "--frame-channel") && (i + 1 < argc)) {
+                options.frame_channel = argv[++i];
+            } else if (arg == "--dsmc") {
+                options.collisions = CollisionModel::DSMC;
+            } else if ((arg == "--dsmc-weight") && (i + 1 < argc)) {
+                options.dsmc_weight = ::atof(argv[++i]);
+            } else if (arg == "--coarsen") {
+                options.coarsen = true;
+            } else if ((arg == "--coarsen-interval") && (i + 1 < argc)) {
+                options.coarsen_interval = ::atoi(argv[++i]);
+            } else if ((arg == "--refine-margin") && (i + 1 < argc)) {
+                options.refine_margin = ::atof(argv[++i]);
+            } else if (arg == "--open") {
+                options.boundaries = BoundaryModel::Open;
+            } else if (arg == "--freestream-walls") {
+                options.side_walls = SideWalls::Freestream;
+            } else if (arg == "--huge-pages") {
+                options.huge_pages = true;
+            } else if (arg == "--single") {
+                result.single_precision = true;
+            } else if ((arg == "--skin") && (i + 1 < argc)) {
+                options.neighbor_skin = ::atof(argv[++i]);
+            } else if ((arg == "--profile") && (i + 1 < argc)) {
+                ifstream inf(argv[++i]);
+                if (!inf) {
+                    throw invalid_argument("Cannot read tuning profile " + string(argv[i]));
+                }
+                TuningProfile::read(inf).apply_to(options);
+            } else if ((arg == "--calibrate") && (i + 1 < argc)) {
+                result.calibrate_path = argv[++i];
+            } else {
+                throw invalid_argument("Unknown argument: " + arg);
+            }
+        }
+        return result;
+    }
+
+    template <typename Real, typename Species = UniformSpecies>
+    void run(
+        const Airfoil& airfoil, const double world_width, const double world_height,
+        const double max_particle_speed, const Point& wind_vel, const WorldOptions& options)
+    {
+        BasicWorld<Real, Species> world(
+            airfoil, world_width, world_height, max_particle_speed, wind_vel,
+            options);
+
+        Vector total_foil_force;
+
+
+        const size_t movie_seconds = 20;
+        const size_t fps = 30;
+        const size_t steps_per_frame = 10;
+
+        size_t index = 0;
+        double mv_prev = 0.0;
+        steady_clock::time_point t0 = steady_clock::now();
+        for (size_t sec = 1; sec <= movie_seconds; ++sec) {
+            for (size_t iframe = 1; iframe <= fps; iframe++) {
+                world.step_many(steps_per_frame);
+
+                index += 1;
+                write_positions(index, world);
+
+                write_foil_forces(index, world);
+                total_foil_force.add(world.force_on_foil());
+
+                world.reset_force_on_foil();
+
+                if (options.collect_cell_stats) {
+                    write_cell_stats(index, world);
+                    world.reset_cell_stats();
+                }
+
+                steady_clock::time_point tf = steady_clock::now();
+                duration<double> dt = duration_cast<duration<double>>(tf - t0);
+                t0 = tf;
+
+                const double mv = world.momentum();
+                const double dmv = mv - mv_prev;
+                mv_prev = mv;
+
+                cout
+                    << sec << "." << iframe << "/" << movie_seconds 
+                    << ": net mv = " << mv
+                    << ", Δmv = " << dmv;
+                if (options.coarsen) {
+                    cout << ", particles = " << world.num_particles();
+                }
+                cout
+                    << "; dt = " << dt.count() << " seconds"
+                    << endl;
+            }
+        }
+        // The direction of the force is backwards, hence the scale:
+        cout
+            << "Summed force on foil: "
+            << total_foil_force.scaled(-1.0).to_str() << endl;
+    }
 }
 
 int main(int argc, char **argv) {
+    DemoArgs args(parse_args(argc, argv));
+    WorldOptions& options(args.options);
+
     const double world_width = 128.0;
     const double world_height = 72.0;
 
@@ -76,52 +234,30 @@ int main(int argc, char **argv) {
     const double max_particle_speed = 0.0005;
     const Point wind_vel = Point(0.11, 0.0);
 
-    World world(
-        airfoil, world_width, world_height, max_particle_speed, wind_vel);
-
-    Vector total_foil_force;
-
-
-    const size_t movie_seconds = 20;
-    const size_t fps = 30;
-    const size_t steps_per_frame = 10;
-
-    size_t index = 0;
-    double mv_prev = 0.0;
-    steady_clock::time_point t0 = steady_clock::now();
-    for (size_t sec = 1; sec <= movie_seconds; ++sec) {
-        for (size_t iframe = 1; iframe <= fps; iframe++) {
-            for (size_t istep = 1; istep <= steps_per_frame; ++istep) {
-                world.step();
-            }
-
-            index += 1;
-            write_positions(index, world);
-
-            write_foil_forces(index, world);
-            total_foil_force.add(world.force_on_foil());
-
-            world.reset_force_on_foil();
-
-            steady_clock::time_point tf = steady_clock::now();
-            duration<double> dt = duration_cast<duration<double>>(tf - t0);
-            t0 = tf;
-
-            const double mv = world.momentum();
-            const double dmv = mv - mv_prev;
-            mv_prev = mv;
+    if (!args.calibrate_path.empty()) {
+        Tuner tuner([&](const WorldOptions& trial_options) {
+            return unique_ptr<World>(new World(
+                airfoil, world_width, world_height, max_particle_speed,
+                wind_vel, trial_options));
+        });
+        const TuningProfile profile(tuner.calibrate(options, cout));
+        ofstream outf(args.calibrate_path);
+        profile.write(outf);
+        outf.close();
+        profile.apply_to(options);
+    }
 
-            cout
-                << sec << "." << iframe << "/" << movie_seconds 
-                << ": net mv = " << mv
-                << ", Δmv = " << dmv
-                << "; dt = " << dt.count() << " seconds"
-                << endl;
-        }
+    // Coarsening needs weighted particles.
+    if (options.coarsen && args.single_precision) {
+        run<float, WeightedSpecies>(
+            airfoil, world_width, world_height, max_particle_speed, wind_vel, options);
+    } else if (options.coarsen) {
+        run<double, WeightedSpecies>(
+            airfoil, world_width, world_height, max_particle_speed, wind_vel, options);
+    } else if (args.single_precision) {
+        run<float>(airfoil, world_width, world_height, max_particle_speed, wind_vel, options);
+    } else {
+        run<double>(airfoil, world_width, world_height, max_particle_speed, wind_vel, options);
     }
-    // The direction of the force is backwards, hence the scale:
-    cout
-        << "Summed force on foil: "
-        << total_foil_force.scaled(-1.0).to_str() << endl;
     return 0;
 }
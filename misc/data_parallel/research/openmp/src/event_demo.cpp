@@ -0,0 +1,75 @@
+#include <iostream>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <stdexcept>
+#include <string>
+
+#include "point.h"
+#include "airfoil.h"
+#include "event_world.h"
+
+using namespace std;
+using namespace wingworks;
+using namespace std::chrono;
+
+// Run the demo's world with an EventWorld, at a density low enough for
+// particles to be placed without overlap, reporting the force on the
+// foil, the events processed and the time per frame.
+//
+// Usage: event_demo [--density <particles per unit area>] [--frames <n>]
+//                   [--frame-interval <steps>]
+namespace {
+    struct EventDemoArgs {
+        double density = 0.2;
+        size_t frames = 30;
+        double frame_interval = 10.0;
+    };
+
+    EventDemoArgs parse_args(int argc, char **argv) {
+        EventDemoArgs result;
+        for (int i = 1; i < argc; ++i) {
+            const string arg(argv[i]);
+            if ((arg == "--density") && (i + 1 < argc)) {
+                result.density = ::atof(argv[++i]);
+            } else if ((arg == "--frames") && (i + 1 < argc)) {
+                result.frames = ::atoi(argv[++i]);
+            } else if ((arg == "--frame-interval") && (i + 1 < argc)) {
+                result.frame_interval = ::atof(argv[++i]);
+            } else {
+                throw invalid_argument("Unknown argument: " + arg);
+            }
+        }
+        return result;
+    }
+}
+
+int main(int argc, char **argv) {
+    const EventDemoArgs args(parse_args(argc, argv));
+    const double world_width = 128.0;
+    const double world_height = 72.0;
+    const Airfoil airfoil(
+        world_width / 8.0, world_height / 2.0,
+        world_width / 4.0,
+        10.0 * M_PI / 180.0
+    );
+    const size_t num_particles = args.density * world_width * world_height;
+    EventWorld world(
+        airfoil, world_width, world_height, num_particles, 0.0005, Point(0.11, 0.0), 1);
+    cout << "Number of particles: " << world.num_particles() << endl;
+
+    steady_clock::time_point t0 = steady_clock::now();
+    world.for_each_frame(args.frame_interval, args.frames, [&](EventWorld& w) {
+        const duration<double> dt = duration_cast<duration<double>>(steady_clock::now() - t0);
+        const EventCounts& counts(w.counts());
+        cout << "Time " << w.time()
+             << ": force on foil = " << w.force_on_foil().scaled(-1.0).to_str()
+             << ", collisions = " << counts.pair_collisions << " + " << counts.foil_collisions
+             << " with foil, cell crossings = " << counts.cell_crossings
+             << ", predictions = " << counts.predictions
+             << "; dt = " << dt.count() << " seconds" << endl;
+        w.reset_force_on_foil();
+        t0 = steady_clock::now();
+    });
+    return 0;
+}
@@ -0,0 +1,45 @@
+#include <iostream>
+#include <chrono>
+#include <cmath>
+#include <thread>
+
+#include "frame_channel.h"
+
+using namespace std;
+using namespace wingworks;
+
+// Follow a running demo's frame channel, printing a line for each new
+// frame: its step, the force on the foil, and the mean particle speed.
+// A stand-in for a real viewer, and an example of how to write one.
+//
+// Usage: demo --frame-channel /wingworks & frame_monitor /wingworks
+int main(int argc, char **argv) {
+    if (argc != 2) {
+        cerr << "Usage: frame_monitor <channel-name>" << endl;
+        return 1;
+    }
+    FrameReader reader(argv[1]);
+
+    Frame frame;
+    uint64_t last_seen = 0;
+    for (;;) {
+        if (reader.frames_published() == last_seen) {
+            this_thread::sleep_for(chrono::milliseconds(10));
+            continue;
+        }
+        if (!reader.read_latest(frame)) {
+            continue;
+        }
+        last_seen = frame.frame + 1;
+
+        double speed_sum = 0.0;
+        for (size_t i = 0; i < frame.vel_x.size(); ++i) {
+            speed_sum += ::hypot(frame.vel_x[i], frame.vel_y[i]);
+        }
+        const double mean_speed = frame.vel_x.empty() ? 0.0 : speed_sum / frame.vel_x.size();
+        cout << "Frame " << frame.frame << ", step " << frame.step
+             << ": " << frame.pos_x.size() << " particles"
+             << ", force on foil = " << frame.force.scaled(-1.0).to_str()
+             << ", mean speed = " << mean_speed << endl;
+    }
+}
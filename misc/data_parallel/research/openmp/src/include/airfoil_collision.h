@@ -20,8 +20,14 @@ public:
 
     bool is_colliding(const Particle& particle, Vector& recoil_vec_result);
     
-    Vector resolve_collision(Particle& particle, Vector& recoil_vec) const;
-    double accel_from_foil(const Particle& particle, const Vector& normal) const;
+
+    // These work in double for particles of either precision.  The
+    // returned impulse is double, too.
+    template <typename Real, typename Species>
+    Vector resolve_collision(BasicParticle<Real, Species>& particle, Vector& recoil_vec) const;
+    template <typename Real, typename Species>
+    double accel_from_foil(
+        const BasicParticle<Real, Species>& particle, const Vector& normal) const;
 };
 
 }
\ No newline at end of file
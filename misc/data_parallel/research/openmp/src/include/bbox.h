@@ -5,23 +5,24 @@
 #include <string>
 
 namespace wingworks {
-    class BBox {
+    template <typename Real>
+    class BasicBBox {
     private:
-        double xmin_m, ymin_m, xmax_m, ymax_m;
+        Real xmin_m, ymin_m, xmax_m, ymax_m;
 
     public:
-        BBox(double xmin, double ymin, double xmax, double ymax)
+        BasicBBox(Real xmin, Real ymin, Real xmax, Real ymax)
         : xmin_m(xmin), ymin_m(ymin), xmax_m(xmax), ymax_m(ymax)
         {}
 
-        BBox(): BBox(0.0, 0.0, 0.0, 0.0) {}
-        BBox(const BBox& src) {
+        BasicBBox(): BasicBBox(0.0, 0.0, 0.0, 0.0) {}
+        BasicBBox(const BasicBBox& src) {
             xmin_m = src.xmin_m;
             xmax_m = src.xmax_m;
             ymin_m = src.ymin_m;
             ymax_m = src.ymax_m;
         }
-        BBox& operator=(const BBox& src) {
+        BasicBBox& operator=(const BasicBBox& src) {
             xmin_m = src.xmin_m;
             xmax_m = src.xmax_m;
             ymin_m = src.ymin_m;
@@ -29,7 +30,7 @@ namespace wingworks {
             return *this;
         }
 
-        void update(double xmin, double ymin, double xmax, double ymax) {
+        void update(Real xmin, Real ymin, Real xmax, Real ymax) {
             // Caller must ensure xmin <= xmax, etc.
             xmin_m = xmin;
             ymin_m = ymin;
@@ -37,20 +38,20 @@ namespace wingworks {
             ymax_m = ymax;
         }
 
-        double xmin() const { return xmin_m; }
-        double ymin() const { return ymin_m; }
-        double width() const { return xmax_m - xmin_m; }
-        double height() const { return ymax_m - ymin_m; }
+        Real xmin() const { return xmin_m; }
+        Real ymin() const { return ymin_m; }
+        Real width() const { return xmax_m - xmin_m; }
+        Real height() const { return ymax_m - ymin_m; }
 
-        bool contains(const Point& p) const {
-            const double x = p.x(), y = p.y();
+        bool contains(const BasicPoint<Real>& p) const {
+            const Real x = p.x(), y = p.y();
             return ((xmin_m <= x) && (x < xmax_m)
                     && (ymin_m <= y) && (y < ymax_m));
         }
 
         // Extend this BBox as needed to contain point p.
-        void enclose(const Point& p) {
-            const double x = p.x(), y = p.y();
+        void enclose(const BasicPoint<Real>& p) {
+            const Real x = p.x(), y = p.y();
             if (x < xmin_m) {
                 xmin_m = x;
             }
@@ -65,18 +66,20 @@ namespace wingworks {
             }
         }
 
-        void extend_bounds(const double fraction) {
-            const double w_delta = width() * fraction / 2.0;
+        void extend_bounds(const Real fraction) {
+            const Real w_delta = width() * fraction / 2.0;
             xmin_m -= w_delta;
             xmax_m += w_delta;
 
-            const double h_delta = height() * fraction / 2.0;
+            const Real h_delta = height() * fraction / 2.0;
             ymin_m -= h_delta;
             ymax_m += h_delta;
         }
 
-        bool overlaps(const BBox& other) const;
+        bool overlaps(const BasicBBox& other) const;
 
         std::string to_str() const;
     };
+
+    using BBox = BasicBBox<double>;
 }
\ No newline at end of file
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <atomic>
+#include <cstdlib>
+#include <vector>
+
+#include <omp.h>
+
+#include "world_cells.h"
+
+namespace wingworks {
+
+// CellBalancer divides the cells of a CellSpan among threads by their
+// estimated cost, rather than by their number.  Particles crowd in front
+// of the airfoil, and the pair search of a cell grows with the square of
+// its occupancy, so an even split by index leaves most threads waiting
+// on the few that got the crowded cells.
+//
+// plan() cuts the span into contiguous chunks of about equal cost, a few
+// per thread, and deals each thread a contiguous run of them.  Costs are
+// only estimates, so a thread that finishes its own chunks steals the
+// rest of other threads' chunks, one at a time.
+class CellBalancer {
+public:
+    // Each thread is dealt chunks_per_thread chunks; more chunks give
+    // stealing finer pieces to work with.
+    CellBalancer(const size_t num_threads, const size_t chunks_per_thread);
+    ~CellBalancer();
+
+    CellBalancer(const CellBalancer&) = delete;
+    CellBalancer& operator=(const CellBalancer&) = delete;
+
+    // The estimated cost of a cell's pair search.
+    static double cell_cost(const size_t occupancy) {
+        // The constant is the cost of visiting an empty cell and its
+        // neighbors, in units of a pair test.
+        return 4.0 + double(occupancy) * double(occupancy);
+    }
+
+    // Plan chunks for span's cells, costed by their current occupancy.
+    // Not thread-safe, and must not overlap for_each_chunk.
+    void plan(const WorldCells& cells, const CellSpan& span);
+
+    size_t num_chunks() const { return chunk_begin_m.size() - 1; }
+    // Chunk c covers span cells [chunk_begin(c), chunk_end(c)).
+    size_t chunk_begin(const size_t c) const { return chunk_begin_m[c]; }
+    size_t chunk_end(const size_t c) const { return chunk_begin_m[c + 1]; }
+
+    // Call f(k_begin, k_end) for every chunk of the plan, each exactly
+    // once, sharing the chunks among the calling team.  Every thread of
+    // the team must call it, or call it outside a parallel region to run
+    // every chunk serially.  Like an omp for, it ends with a barrier.
+    template <typename F>
+    void for_each_chunk(F f) {
+        const size_t thread = omp_get_thread_num();
+        const size_t team_size = omp_get_num_threads();
+        // Each thread restarts its own queue, and those of any planned
+        // threads missing from a smaller team.  Until a queue restarts it
+        // is still exhausted from the last call -- the barrier ending that
+        // call saw to it -- so no thief can take a chunk twice.
+        for (size_t q = thread; q < num_threads_m; q += team_size) {
+            next_m[q].chunk.store(q * chunks_per_thread_m, std::memory_order_relaxed);
+        }
+        // Threads beyond the planned number have no queue of their own;
+        // they, like any thread that runs out, steal.
+        for (size_t i = 0; i < num_threads_m; ++i) {
+            const size_t victim = (thread + i) % num_threads_m;
+            const size_t end = (victim + 1) * chunks_per_thread_m;
+            for (;;) {
+                const size_t c = next_m[victim].chunk.fetch_add(1, std::memory_order_relaxed);
+                if (c >= end) {
+                    break;
+                }
+                f(chunk_begin_m[c], chunk_begin_m[c + 1]);
+            }
+        }
+        #pragma omp barrier
+    }
+
+private:
+    // A thread's next unclaimed chunk, alone on its cache line.
+    struct alignas(64) Cursor {
+        std::atomic<size_t> chunk;
+    };
+
+    const size_t num_threads_m;
+    const size_t chunks_per_thread_m;
+    std::vector<size_t> chunk_begin_m;
+    Cursor *next_m;
+};
+
+}
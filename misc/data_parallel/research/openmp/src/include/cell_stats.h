@@ -0,0 +1,71 @@
+#pragma once
+
+#include <cstdlib>
+#include <vector>
+#include <iostream>
+
+#include "world_cells.h"
+
+namespace wingworks {
+
+// CellStats accumulates, over some number of steps, how the cell grid
+// is loaded: how many particles each cell holds, how many candidate
+// pairs the collision search tests versus how many actually collide,
+// and where in the world those pair tests happen.
+//
+// The hot-spot map coarsens the grid into square blocks of cells, so a
+// per-frame dump stays small.
+class CellStats {
+private:
+    const size_t num_horiz_m;
+    const size_t num_vert_m;
+    const double cell_extent_m;
+    const size_t block_size_m;
+    const size_t blocks_horiz_m;
+    const size_t blocks_vert_m;
+
+    size_t num_steps_m;
+    // occupancy_m[k]: number of (cell, step) samples holding k particles.
+    // The last bin counts cells holding max_particles_per_cell or more.
+    std::vector<size_t> occupancy_m;
+    size_t pairs_tested_m;
+    size_t pairs_colliding_m;
+    // Pair tests per block, row-major from the bottom-left block.
+    std::vector<size_t> hot_spots_m;
+
+public:
+    CellStats(const WorldCells& cells, const size_t block_size = 8);
+
+    void reset();
+
+    void record_step() { num_steps_m += 1; }
+    void record_occupancy(const WorldCells& cells);
+    // Cells are searched in parallel, so this may be called concurrently.
+    void record_pairs(const size_t cell_index, const size_t tested, const size_t colliding) {
+        size_t& hot_spot(hot_spots_m[block_of(cell_index)]);
+        #pragma omp atomic
+        pairs_tested_m += tested;
+        #pragma omp atomic
+        pairs_colliding_m += colliding;
+        #pragma omp atomic
+        hot_spot += tested;
+    }
+
+    size_t num_steps() const { return num_steps_m; }
+    size_t pairs_tested() const { return pairs_tested_m; }
+    size_t pairs_colliding() const { return pairs_colliding_m; }
+    const std::vector<size_t>& occupancy() const { return occupancy_m; }
+    const std::vector<size_t>& hot_spots() const { return hot_spots_m; }
+
+    // Write one "name,values..." record per line.
+    void write(std::ostream& outs) const;
+
+private:
+    size_t block_of(const size_t cell_index) const {
+        const size_t col = (cell_index % num_horiz_m) / block_size_m;
+        const size_t row = (cell_index / num_horiz_m) / block_size_m;
+        return row * blocks_horiz_m + col;
+    }
+};
+
+}
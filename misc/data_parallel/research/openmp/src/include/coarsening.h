@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstdlib>
+
+#include "particle.h"
+#include "species.h"
+#include "vector.h"
+
+namespace wingworks {
+
+// Merging and splitting weighted particles (see WeightedSpecies), the
+// operations behind WorldOptions::coarsen.  Both conserve total weight,
+// momentum and kinetic energy exactly, up to rounding to Real.
+
+template <typename Real>
+using WeightedParticle = BasicParticle<Real, WeightedSpecies>;
+
+// Replace particles[indices[0, n)], n >= 2, by two particles, each of
+// half their total weight, written to particles[indices[0]] and
+// particles[indices[1]]; the caller disposes of the rest.
+//
+// One particle can't carry both the group's momentum and its kinetic
+// energy, but two can: they move at the group's mean velocity V, plus
+// and minus d * direction, with d chosen so that their kinetic energy
+// about V is the group's.  They sit at the group's center of mass,
+// plus and minus its RMS distance from it along direction.  direction
+// must be a unit vector; drawing it at random keeps merges from
+// favoring any direction.
+template <typename Real>
+void merge_particles(
+    WeightedParticle<Real> *particles, const size_t *indices, const size_t n,
+    const Vector& direction);
+
+// Split p into two particles, each of half its weight and with its
+// velocity: p itself, moved by offset, and half, moved by -offset.
+template <typename Real>
+void split_particle(WeightedParticle<Real>& p, WeightedParticle<Real>& half, const Vector& offset);
+
+}
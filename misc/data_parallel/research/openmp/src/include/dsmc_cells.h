@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstdlib>
+#include <vector>
+
+#include "world_cells.h"
+
+namespace wingworks {
+
+// DsmcCells keeps the per-cell state of Bird's no-time-counter (NTC)
+// scheme for Direct Simulation Monte Carlo collisions.
+//
+// Rather than search for overlapping pairs, each step a cell of N
+// particles and area A draws
+//     N (N - 1) W (sigma c_r)_max / (2 A)
+// candidate pairs at random, where W is the number of molecules a
+// particle stands for, sigma the pair's collision cross-section -- in
+// two dimensions, the sum of the radii -- and c_r their relative speed,
+// in world units per step.  Each candidate collides with probability
+// sigma c_r / (sigma c_r)_max.  On average that collides every pair at
+// the rate a hard-sphere gas would, at a cost linear in N.  The
+// fractional part of the candidate count carries over to the cell's
+// next step, and a cell's maximum grows whenever a candidate exceeds it.
+//
+// Areas are those of the cells' parts inside the world.  The foil's
+// area is not subtracted, so cells it covers collide a little less
+// often than they should.
+class DsmcCells {
+public:
+    // weight is W.  max_sigma_cr is each cell's initial (sigma c_r)_max;
+    // too low only costs accuracy until it grows, too high costs
+    // candidates that are mostly rejected.
+    DsmcCells(
+        const WorldCells& cells, const double world_width, const double world_height,
+        const double weight, const double max_sigma_cr);
+
+    double area(const size_t cell_index) const { return area_m[cell_index]; }
+    double max_sigma_cr(const size_t cell_index) const { return max_sigma_cr_m[cell_index]; }
+
+    // The methods below may be called concurrently for different cells.
+
+    // How many candidate pairs to draw this step from a cell of
+    // num_particles particles.
+    size_t num_candidates(const size_t cell_index, const size_t num_particles);
+    // Whether to collide a candidate pair of the cell, given its
+    // sigma c_r and a uniform draw from [0, 1).
+    bool accept(const size_t cell_index, const double sigma_cr, const double draw);
+
+private:
+    const double weight_m;
+    std::vector<double> area_m;
+    std::vector<double> max_sigma_cr_m;
+    std::vector<double> remainder_m;
+};
+
+}
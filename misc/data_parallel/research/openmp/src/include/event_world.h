@@ -0,0 +1,184 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <limits>
+#include <vector>
+
+#include "airfoil.h"
+#include "particle.h"
+#include "vector.h"
+#include "world_cells.h"
+
+namespace wingworks {
+
+// What an EventWorld has done so far.
+struct EventCounts {
+    size_t pair_collisions = 0;
+    size_t foil_collisions = 0;
+    size_t cell_crossings = 0;
+    size_t recycles = 0;
+    // Events found to be out of date when their time came.
+    size_t stale_events = 0;
+    // Candidate events computed: one per pair, foil edge or vertex, and
+    // cell wall considered.
+    size_t predictions = 0;
+};
+
+// EventWorld is an event-driven alternative to World for dilute flows.
+// Rather than move every particle a full step and then look for
+// overlaps, it computes when each particle will next hit another
+// particle, hit the foil, or cross into another cell, and jumps from
+// one such event to the next.  Collisions happen at their exact times,
+// particles never overlap, and a particle costs nothing between events.
+// When collisions are rare, that is far less work than testing every
+// nearby pair at every step.
+//
+// Time is in World steps: a particle moves by its velocity in one unit.
+// Particles move in straight lines between events, so each is stored as
+// of the time of its last event and brought up to date only when needed;
+// advance_to brings them all up to date, to sample the World at a frame
+// time.
+//
+// Each cell keeps a calendar -- a heap -- of the events of its
+// particles, and a heap of cells orders the calendars by their earliest
+// events.  An event goes out of date when either particle's course
+// changes; rather than search calendars for it, each particle counts its
+// changes of course, and an event whose counts no longer match is
+// dropped when it comes up.
+//
+// Events happen one after another, so EventWorld is serial.  Particles
+// are uniform hard spheres of the default species, and particles that
+// leave the world are recycled much as World recycles them, at places
+// where they overlap nothing.
+class EventWorld {
+public:
+    using Particle = BasicParticle<double>;
+
+    // Place num_particles particles at random, without overlap, moving
+    // at max_speed in random directions, plus the wind.  cell_extent
+    // must be at least a particle diameter.  Throws if the particles
+    // can't be placed without overlap.
+    EventWorld(
+        const Airfoil& foil, const double width, const double height,
+        const size_t num_particles, const double max_speed, const Vector& wind,
+        const uint64_t seed, const double cell_extent = 1.0);
+    // Start from the given particles, which must not overlap each other
+    // or the foil.
+    EventWorld(
+        const Airfoil& foil, const double width, const double height,
+        const std::vector<Particle>& particles, const double max_speed, const Vector& wind,
+        const uint64_t seed, const double cell_extent = 1.0);
+
+    EventWorld(const EventWorld&) = delete;
+    EventWorld& operator=(const EventWorld&) = delete;
+
+    size_t num_particles() const { return particles_m.size(); }
+    double time() const { return time_m; }
+
+    // Process every event up to time t, then bring every particle's
+    // state up to t.
+    void advance_to(const double t);
+    // Call f(*this) at each of num_frames frame times, frame_interval
+    // apart, starting one interval from now.
+    template <typename F>
+    void for_each_frame(const double frame_interval, const size_t num_frames, F f) {
+        const double start = time_m;
+        for (size_t frame = 1; frame <= num_frames; ++frame) {
+            advance_to(start + frame * frame_interval);
+            f(*this);
+        }
+    }
+
+    // The state of a particle as of time(), its ID being its index in
+    // the initial particles.
+    const Particle& particle(const size_t id) const { return particles_m[id]; }
+
+    const Vector& force_on_foil() const { return net_force_on_foil_m; }
+    void reset_force_on_foil() { net_force_on_foil_m.update(0.0, 0.0); }
+    double momentum() const;
+    const EventCounts& counts() const { return counts_m; }
+
+    void write_particle_positions(std::ostream& outs) const;
+
+private:
+    enum class EventKind : uint8_t {
+        Pair,
+        Foil,
+        // Leaving a cell, or the world.
+        Wall
+    };
+    struct Event {
+        double time;
+        size_t a;
+        // Pair: the other particle.  Foil: an edge, or num_edges plus a
+        // vertex.  Wall: 0-3 for left, right, bottom and top.
+        size_t b;
+        uint64_t course_a;
+        uint64_t course_b;
+        EventKind kind;
+    };
+    // Orders calendars as min-heaps.
+    struct Later {
+        bool operator()(const Event& e1, const Event& e2) const { return e1.time > e2.time; }
+    };
+
+    const Airfoil airfoil_m;
+    const double world_width_m;
+    const double world_height_m;
+    const double max_speed_m;
+    const Vector wind_vel_m;
+    const uint64_t seed_m;
+    double time_m;
+
+    std::vector<Particle> particles_m;
+    // When each particle's stored state was current.
+    std::vector<double> updated_m;
+    // How many times each particle has changed course.
+    std::vector<uint64_t> course_m;
+    std::vector<size_t> cell_of_m;
+    WorldCells cells_m;
+
+    // One calendar per cell, and a heap of cells by earliest event.
+    std::vector<std::vector<Event>> calendars_m;
+    std::vector<size_t> cell_queue_m;
+    std::vector<size_t> queue_pos_m;
+
+    Vector net_force_on_foil_m;
+    EventCounts counts_m;
+
+    void place_randomly(const size_t num_particles);
+    void start();
+
+    // Bring a particle's state up to time_m.
+    void update(const size_t i);
+    // Where particle i is at time_m, without updating it.
+    Vector position_now(const size_t i) const;
+
+    // Forget particle i's events, and schedule its next ones.  It must
+    // be up to date.
+    void predict(const size_t i);
+    // The time until particle i, at pos with velocity vel, touches the
+    // foil, or infinity.  Sets feature to the edge or vertex it touches.
+    double foil_contact(const Vector& pos, const Vector& vel, const double radius, size_t& feature);
+    void schedule(const size_t cell_index, const Event& event);
+
+    void handle(const Event& event);
+    void collide_pair(const size_t i, const size_t j);
+    void collide_with_foil(const size_t i, const size_t feature);
+    void cross_wall(const size_t i, const size_t wall);
+    void recycle(const size_t i);
+    // Whether a particle of the given radius at pos would overlap any
+    // particle or the foil.
+    bool overlaps(const Vector& pos, const double radius, const size_t except) const;
+
+    // The cell-queue heap.
+    double earliest(const size_t cell_index) const {
+        const std::vector<Event>& calendar(calendars_m[cell_index]);
+        return calendar.empty() ? std::numeric_limits<double>::infinity() : calendar.front().time;
+    }
+    void requeue(const size_t cell_index);
+};
+
+}
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <cstdlib>
+#include <vector>
+
+#include "particle.h"
+#include "rng.h"
+#include "vector.h"
+#include "world_options.h"
+
+namespace wingworks {
+
+// A particle arriving through an open edge of the world.
+struct Arrival {
+    Vector pos;
+    Vector vel;
+};
+
+// FlowBoundaries gives a World open edges, in place of recycling.
+// Outside each open edge lies a reservoir of freestream gas: particles
+// at the World's initial density, with velocities drawn from a
+// Maxwellian about the wind.  Each step, each reservoir sends in as many
+// particles as would cross its edge in a step -- the carried-over
+// fraction counting toward the next -- and a particle that leaves
+// through an open edge is gone.  The left edge is the inflow; the right
+// is an outflow sink, sending nothing in, since the wind blows away
+// from it.  The top and bottom are either specular walls, reflecting
+// particles, or open to the freestream like the left edge.
+//
+// With edges that behave like the freestream, the world need only be
+// big enough to hold the disturbance the foil makes, not so big that
+// recycling's artifacts die out before they reach it.
+//
+// In two dimensions a Maxwellian's components are independent normals.
+// A reservoir of density n whose velocities along an edge's inward
+// normal have mean u and standard deviation sigma sends
+//     n (sigma phi(u / sigma) + u Phi(u / sigma))
+// particles a step through each unit of the edge, phi and Phi being the
+// standard normal density and distribution.  Their normal speeds are
+// distributed in proportion to v times the Maxwellian, and they are
+// spread uniformly along the edge and over the distances they could
+// have come since crossing it during the step.
+class FlowBoundaries {
+public:
+    enum Edge { Left, Right, Bottom, Top, NumEdges };
+
+    // density is in particles per unit area, and sigma is the standard
+    // deviation of each velocity component about the wind.
+    FlowBoundaries(
+        const double width, const double height, const double density,
+        const Vector& wind, const double sigma, const SideWalls walls);
+
+    // Apply the boundaries to a particle that has just moved, reflecting
+    // it off any wall it has passed.  Returns false if it has left the
+    // world.
+    template <typename Real, typename Species>
+    bool keep(BasicParticle<Real, Species>& p) const {
+        if (walls_m == SideWalls::Specular) {
+            if (p.pos_y() < 0) {
+                p.move_to(p.pos_x(), -p.pos_y());
+                p.set_vel(p.vel().x(), -p.vel().y());
+            } else if (p.pos_y() >= height_m) {
+                p.move_to(p.pos_x(), 2 * height_m - p.pos_y());
+                p.set_vel(p.vel().x(), -p.vel().y());
+            }
+        }
+        return ((0 <= p.pos_x()) && (p.pos_x() < width_m)
+                && (0 <= p.pos_y()) && (p.pos_y() < height_m));
+    }
+
+    // Expected arrivals a step through an edge.
+    double arrival_rate(const Edge edge) const { return rate_m[edge]; }
+
+    // Draw this step's arrivals, edge by edge, appending them to
+    // arrivals.
+    void draw_arrivals(CounterRNG& gen, std::vector<Arrival>& arrivals);
+
+private:
+    const double width_m;
+    const double height_m;
+    const Vector wind_m;
+    const double sigma_m;
+    const SideWalls walls_m;
+    double rate_m[NumEdges];
+    double remainder_m[NumEdges];
+
+    void draw_arrival(const Edge edge, CounterRNG& gen, std::vector<Arrival>& arrivals) const;
+};
+
+}
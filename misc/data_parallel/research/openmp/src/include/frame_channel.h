@@ -0,0 +1,131 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include "vector.h"
+
+namespace wingworks {
+
+// A frame channel carries snapshots of a World -- particle positions
+// and velocities, and the force on the foil -- to viewers in other
+// processes on the same machine, through a POSIX shared-memory object.
+// Nothing touches the disk, and the simulation never waits for a viewer.
+//
+// The object holds a ring of frame slots.  The publisher writes each
+// frame into the next slot, guarded by that slot's sequence lock: the
+// sequence is odd while the slot is being written.  A reader checks the
+// sequence before and after reading a slot, and if it changed, the
+// publisher lapped it and it must try again.  Particle data is stored
+// as structure-of-arrays floats, in particle ID order, so that a viewer
+// can hand the arrays straight to a plotting library.
+
+// Laid out at the start of the shared-memory object.
+struct FrameChannelHeader {
+    uint64_t magic;
+    uint32_t version;
+    uint32_t num_slots;
+    // Most particles a slot holds.
+    uint64_t capacity;
+    // Bytes from one slot to the next.
+    uint64_t slot_bytes;
+    // How many frames have been published.  The newest is in slot
+    // (frames_published - 1) % num_slots.
+    std::atomic<uint64_t> frames_published;
+};
+
+// Laid out at the start of each slot, followed by the x, y, vx and vy
+// arrays, capacity floats each.
+struct FrameSlotHeader {
+    // Odd while the slot is being written.
+    std::atomic<uint64_t> sequence;
+    uint64_t frame;
+    uint64_t step;
+    uint64_t num_particles;
+    double force_x;
+    double force_y;
+};
+
+// Creates a frame channel and publishes frames into it.  Only one
+// publisher may use a channel.
+class FramePublisher {
+public:
+    // name is a shared-memory object name, like "/wingworks".  An
+    // existing object of that name is replaced.  More slots give slow
+    // readers longer to finish reading a frame.
+    FramePublisher(const std::string& name, const size_t capacity, const size_t num_slots = 4);
+    // Removes the channel; viewers that have it mapped keep what they
+    // have.
+    ~FramePublisher();
+
+    FramePublisher(const FramePublisher&) = delete;
+    FramePublisher& operator=(const FramePublisher&) = delete;
+
+    const std::string& name() const { return name_m; }
+    size_t capacity() const { return header_m->capacity; }
+    uint64_t frames_published() const { return header_m->frames_published.load(); }
+
+    // Start the next frame.  Until end_frame, fill its arrays, from any
+    // number of threads.
+    void begin_frame(const uint64_t step, const size_t num_particles, const Vector& force);
+    float *pos_x() const { return arrays_m; }
+    float *pos_y() const { return arrays_m + capacity(); }
+    float *vel_x() const { return arrays_m + 2 * capacity(); }
+    float *vel_y() const { return arrays_m + 3 * capacity(); }
+    void end_frame();
+
+private:
+    const std::string name_m;
+    size_t mapped_bytes_m;
+    FrameChannelHeader *header_m;
+    FrameSlotHeader *slot_m;  // The slot being written
+    float *arrays_m;
+};
+
+// A frame, copied out of a channel.
+struct Frame {
+    uint64_t frame = 0;
+    uint64_t step = 0;
+    Vector force;
+    std::vector<float> pos_x, pos_y, vel_x, vel_y;
+};
+
+// Maps a frame channel, read-only, for a viewer.
+class FrameReader {
+public:
+    // Throws if there is no such channel.
+    explicit FrameReader(const std::string& name);
+    ~FrameReader();
+
+    FrameReader(const FrameReader&) = delete;
+    FrameReader& operator=(const FrameReader&) = delete;
+
+    uint64_t frames_published() const { return header_m->frames_published.load(); }
+
+    // Copy the newest frame.  Returns false if nothing has been
+    // published yet.
+    bool read_latest(Frame& result) const;
+
+    // To read without copying, take a view of the newest frame, read its
+    // arrays where they are, then check that it is still intact.  If it
+    // isn't, the publisher overwrote the slot meanwhile, and what was
+    // read must be discarded.
+    struct View {
+        const FrameSlotHeader *slot;
+        uint64_t sequence;
+        const float *pos_x, *pos_y, *vel_x, *vel_y;
+        size_t num_particles;
+    };
+    // Returns false if nothing has been published yet.
+    bool latest(View& view) const;
+    bool intact(const View& view) const;
+
+private:
+    size_t mapped_bytes_m;
+    const FrameChannelHeader *header_m;
+};
+
+}
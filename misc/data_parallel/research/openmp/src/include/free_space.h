@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstdlib>
+#include <vector>
+
+#include "point.h"
+#include "polygon.h"
+
+namespace wingworks {
+
+// FreeSpace places particles uniformly in the part of a width x height
+// world that an obstacle polygon leaves free, without rejection: each
+// draw costs one uniform number per coordinate and a short table lookup,
+// never a polygon test.
+//
+// The world is cut into columns at the x coordinates of the polygon's
+// vertices.  Within a column, the same edges cross every vertical line,
+// in the same order, so the polygon covers a fixed list of intervals,
+// each bounded below and above by an edge -- a line in x.  A column's
+// table holds those lines; at a given x, the free intervals are what
+// lies between them, and a uniform draw over their total length maps to
+// y by stepping over the covered intervals below it.
+class FreeSpace {
+public:
+    FreeSpace(const Polygon& obstacle, const double width, const double height);
+
+    // Map u in [0, 1) to a y in [0, height), uniformly over the free
+    // part of the vertical line through x, 0 <= x <= width.
+    double sample_y(const double x, const double u) const;
+
+    // Map u1, u2, u3 in [0, 1) to a point uniformly over the free area.
+    // u1 picks the column, in proportion to its free area; u2 an x in it,
+    // in proportion to the free height there; u3 the y.
+    Point sample(const double u1, const double u2, const double u3) const;
+
+    // The free height of the vertical line through x.
+    double free_height(const double x) const;
+
+private:
+    // A covered interval: y0 + slope0 * dx to y1 + slope1 * dx, dx being
+    // measured from the left of its column.
+    struct Span {
+        double y0, slope0;
+        double y1, slope1;
+    };
+
+    const double height_m;
+    // Column c spans [column_x_m[c], column_x_m[c + 1]), and its spans
+    // are spans_m[first_span_m[c], first_span_m[c + 1]), in increasing y.
+    std::vector<double> column_x_m;
+    std::vector<size_t> first_span_m;
+    std::vector<Span> spans_m;
+    // Free area of columns [0, c].
+    std::vector<double> cumulative_area_m;
+
+    size_t column_of(const double x) const;
+    // The free height dx past the left of column c.
+    double free_height_in(const size_t c, const double dx) const;
+};
+
+}
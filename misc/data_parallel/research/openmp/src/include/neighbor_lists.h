@@ -0,0 +1,100 @@
+#pragma once
+
+#include <cstdlib>
+#include <vector>
+
+#include "particle.h"
+#include "point.h"
+#include "vector.h"
+#include "world_cells.h"
+
+namespace wingworks {
+
+// NeighborLists are Verlet lists: for each particle, the particles in
+// its home cell or forward cells (see WorldCells) that were within
+// touching distance plus a skin when the lists were built.  While no
+// particle has moved more than half the skin, every pair that can touch
+// is still on the lists, and the lists hold far fewer pairs than a cell
+// search tests.
+//
+// Displacement is measured relative to a uniform drift -- the wind --
+// since only particles' motion relative to each other can bring a new
+// pair into range.  Otherwise the wind alone would force a rebuild
+// every few steps.
+//
+// Particles that have moved farther than half the skin, and recycled
+// particles, which jump across the world, become "strays".  They are
+// left off the lists, and World finds their collisions by searching
+// the cells around them.  A few particles bouncing off the airfoil thus
+// don't force a rebuild; the lists are rebuilt once strays exceed
+// max_stray_fraction of all particles.
+class NeighborLists {
+public:
+    constexpr static double max_stray_fraction = 1.0 / 32.0;
+
+private:
+    const size_t num_particles_m;
+    const double skin_m;
+    const Vector drift_m;
+
+    // neighbors_m[i]: i's forward neighbors, in cell search order.
+    std::vector<size_t> *neighbors_m;
+    Point *built_pos_m;
+    std::vector<char> is_stray_m;
+    // Room for every particle, so that collecting strays never allocates.
+    std::vector<size_t> strays_m;
+    size_t num_strays_m;
+    size_t steps_since_build_m;
+    size_t num_builds_m;
+    bool is_built_m;
+
+public:
+    NeighborLists(const size_t num_particles, const double skin, const Vector& drift);
+    ~NeighborLists();
+
+    NeighborLists(const NeighborLists&) = delete;
+    NeighborLists& operator=(const NeighborLists&) = delete;
+
+    double skin() const { return skin_m; }
+    size_t num_builds() const { return num_builds_m; }
+
+    // Turn particles that moved too far into strays, collect the strays,
+    // and decide whether the lists must be rebuilt before this step's
+    // collisions.  Contains orphaned worksharing constructs; every
+    // thread of the team must call it, and all get the same answer.
+    template <typename Real, typename Species>
+    bool update(const BasicParticle<Real, Species> *particles);
+
+    // Rebuild the lists from cells built from the particles' current
+    // positions.  interaction_range is the touching distance.
+    // Orphaned worksharing, as for update().
+    template <typename Real, typename Species>
+    void build(
+        const WorldCells& cells, const BasicParticle<Real, Species> *particles,
+        const double interaction_range);
+
+    // Force a rebuild at the next update(), e.g. because particles were
+    // renumbered.  Not thread-safe.
+    void invalidate() { is_built_m = false; }
+
+    // Call at the end of every step.  Not thread-safe.
+    void finish_step() { steps_since_build_m += 1; }
+
+    // Recycling may run concurrently for different particles.
+    void mark_stray(const size_t index) { is_stray_m[index] = 1; }
+
+    bool is_stray(const size_t index) const { return is_stray_m[index] != 0; }
+    // Strays, in index order, as of the last update().
+    const size_t *strays() const { return strays_m.data(); }
+    size_t num_strays() const { return num_strays_m; }
+    const std::vector<size_t>& neighbors(const size_t index) const { return neighbors_m[index]; }
+
+    // Where a particle that was not a stray would have been when the
+    // lists were built, were it carried along by the drift alone.  Its
+    // home cell then was no farther than half the skin from there.
+    Point undrifted(const Point& pos) const {
+        return pos.adding(drift_m.scaled(-double(steps_since_build_m)));
+    }
+};
+
+}
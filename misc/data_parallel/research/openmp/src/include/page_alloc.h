@@ -0,0 +1,23 @@
+#pragma once
+
+#include <cstdlib>
+
+namespace wingworks {
+
+// Raw storage for large per-particle and per-cell arrays.  It is left
+// uninitialized, so that the threads that will use each part of it can
+// be the first to touch it; see World::first_touch.
+//
+// With huge_pages, the storage is aligned to, and padded out to, a 2 MiB
+// huge page, and the kernel is asked to back it with huge pages.  That
+// cuts TLB misses on arrays much larger than the cache.  Without, it is
+// aligned to a cache line.
+void *allocate_pages(const size_t bytes, const bool huge_pages);
+void free_pages(void *storage);
+
+template <typename T>
+T *allocate_array(const size_t count, const bool huge_pages) {
+    return static_cast<T*>(allocate_pages(count * sizeof(T), huge_pages));
+}
+
+}
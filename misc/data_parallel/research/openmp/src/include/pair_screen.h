@@ -0,0 +1,86 @@
+#pragma once
+
+#include <cstdlib>
+#include <vector>
+
+#include "particle.h"
+
+namespace wingworks {
+
+// PairScreen finds which of a cell search's candidate pairs touch,
+// before any of them collide.  A cell search stages the positions and
+// radii of its neighborhood -- the cell, then each forward neighbor --
+// in arrays of their own, and asks, for one particle at a time, which
+// staged particles in a range touch it.
+//
+// Pair collisions change only velocities, so whether two particles
+// touch doesn't depend on which pairs collided first, and can be found
+// up front.  The test runs down contiguous arrays with no branch on its
+// outcome; in a dense gas about 40% of candidate pairs touch, which
+// leaves a branch on it mispredicted about as often as not.  The test
+// repeats Particle::is_colliding_with operation for operation, so it
+// finds exactly the same pairs.
+//
+// Staging grows its arrays as needed, and keeps them, so one PairScreen
+// per thread soon stops allocating.
+template <typename Real>
+class PairScreen {
+public:
+    void clear() {
+        num_staged_m = 0;
+    }
+
+    template <typename Species>
+    void stage(const BasicParticle<Real, Species>& particle, const size_t particle_index) {
+        if (num_staged_m == index_m.size()) {
+            grow();
+        }
+        x_m[num_staged_m] = particle.pos_x();
+        y_m[num_staged_m] = particle.pos_y();
+        radius_m[num_staged_m] = particle.radius();
+        index_m[num_staged_m] = particle_index;
+        num_staged_m += 1;
+    }
+
+    size_t size() const { return num_staged_m; }
+
+    // Find the staged particles in [begin, end) that touch particle, in
+    // staging order.  Returns how many there are.
+    template <typename Species>
+    size_t find_touching(const BasicParticle<Real, Species>& particle, const size_t begin, const size_t end) {
+        const Real x = particle.pos_x();
+        const Real y = particle.pos_y();
+        const Real radius = particle.radius();
+        size_t num_hits = 0;
+        for (size_t k = begin; k < end; ++k) {
+            const Real coll_dist = radius + radius_m[k];
+            const Real dx = x - x_m[k];
+            const Real dy = y - y_m[k];
+            hits_m[num_hits] = index_m[k];
+            num_hits += ((dx * dx) + (dy * dy) <= (coll_dist * coll_dist)) ? 1 : 0;
+        }
+        return num_hits;
+    }
+
+    // The h'th touching particle's index, as staged.
+    size_t hit(const size_t h) const { return hits_m[h]; }
+
+private:
+    std::vector<Real> x_m;
+    std::vector<Real> y_m;
+    std::vector<Real> radius_m;
+    std::vector<size_t> index_m;
+    std::vector<size_t> hits_m;
+    size_t num_staged_m = 0;
+
+    void grow() {
+        const size_t capacity = (index_m.size() > 32) ? 2 * index_m.size() : 64;
+        x_m.resize(capacity);
+        y_m.resize(capacity);
+        radius_m.resize(capacity);
+        index_m.resize(capacity);
+        hits_m.resize(capacity);
+    }
+};
+
+}
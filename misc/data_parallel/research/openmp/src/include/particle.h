@@ -3,63 +3,74 @@
 #include "vector.h"
 #include "bbox.h"
 #include "dot_min_max.h"
+#include "species.h"
 
 namespace wingworks {
-    class Particle {
+    // A particle whose state is stored as Real -- float or double.
+    // Quantities that are summed over many particles, like momentum(),
+    // are returned as double whatever the storage type.  Its mass and
+    // radius come from its Species policy; see species.h.
+    template <typename Real, typename Species = UniformSpecies>
+    class BasicParticle : public Species {
     private:
-        const double mass_m = 1.0;
-        const double radius_m = 0.5;
-
-        Point pos_m;
-        Point vel_m;
+        BasicPoint<Real> pos_m;
+        BasicPoint<Real> vel_m;
 
     public:
-        Particle(){}
-        Particle(const Particle& src)
-        : pos_m(src.pos_m), vel_m(src.vel_m) {}
+        BasicParticle(){}
 
-        void move_to(const double x, const double y) {
+        void move_to(const Real x, const Real y) {
             pos_m.update(x, y);
         }
 
-        void move_to(const Point& p) {
-            pos_m = p;
+        // Points of the other precision are rounded to this one.
+        template <typename Other>
+        void move_to(const BasicPoint<Other>& p) {
+            pos_m = BasicPoint<Real>(p);
         }
 
-        void set_vel(const double vx, const double vy) {
+        void set_vel(const Real vx, const Real vy) {
             vel_m.update(vx, vy);
         }
 
-        void accelerate(const Vector& a) {
-            vel_m.add(a);
+        template <typename Other>
+        void accelerate(const BasicVector<Other>& a) {
+            vel_m.add(BasicVector<Real>(a));
         }
 
-        double dist_sqr(const Particle& other) const {
+        Real dist_sqr(const BasicParticle& other) const {
             return pos_m.dist_sqr(other.pos_m);
         }
 
-        bool is_colliding_with(const Particle& other) const {
-            const double coll_dist = radius_m + other.radius_m;
+        bool is_colliding_with(const BasicParticle& other) const {
+            const Real coll_dist = radius() + other.radius();
             return pos_m.dist_sqr(other.pos_m) <= (coll_dist * coll_dist);
         }
 
-        const BBox bbox() const {
-            const double x = pos_m.x();
-            const double y = pos_m.y();
-            return BBox(x - radius_m, y - radius_m, x + radius_m, y + radius_m);
+        const BasicBBox<Real> bbox() const {
+            const Real x = pos_m.x();
+            const Real y = pos_m.y();
+            const Real r = radius();
+            return BasicBBox<Real>(x - r, y - r, x + r, y + r);
         }
 
         /**
          * Find the new velocities of two particles after they have collided.
          */
         void resolve_collision_with(
-            const Particle& other, Point& v_result, Point& other_v_result
+            const BasicParticle& other, BasicPoint<Real>& v_result, BasicPoint<Real>& other_v_result
         ) const;
 
         /**
          * Collide with another particle, updating velocities of both.
          */
-        void collide_with(Particle& other);
+        void collide_with(BasicParticle& other);
+
+        /**
+         * Collide with another particle as though they touched along the
+         * given unit normal, wherever they are.
+         */
+        void collide_along(BasicParticle& other, const BasicPoint<Real>& normal);
 
         /**
          * Update position based on velocity.
@@ -68,21 +79,23 @@ namespace wingworks {
             pos_m.add(vel_m);
         }
 
-        double mass() const { return mass_m; }
-        double radius() const { return radius_m; }
-        double pos_x() const { return pos_m.x(); }
-        double pos_y() const { return pos_m.y(); }
-        const Point& pos() const { return pos_m; }
-        const Point& vel() const { return vel_m; }
+        Real mass() const { return Species::mass(); }
+        Real radius() const { return Species::radius(); }
+        Real pos_x() const { return pos_m.x(); }
+        Real pos_y() const { return pos_m.y(); }
+        const BasicPoint<Real>& pos() const { return pos_m; }
+        const BasicPoint<Real>& vel() const { return vel_m; }
 
-        double momentum() const { return mass_m * vel().magnitude(); }
+        double momentum() const { return double(mass()) * Vector(vel()).magnitude(); }
 
         DotMinMax projected_extrema(const Vector& unit_vec) const {
-            const double center_dot = pos_m.dot(unit_vec);
-            return DotMinMax(center_dot - radius_m, center_dot + radius_m);
+            const double center_dot = Vector(pos_m).dot(unit_vec);
+            return DotMinMax(center_dot - radius(), center_dot + radius());
         }
 
     private:
-        double calc_impulse_with(const Particle& other, const Point& normal) const;
+        Real calc_impulse_with(const BasicParticle& other, const BasicPoint<Real>& normal) const;
     };
-}
\ No newline at end of file
+
+    using Particle = BasicParticle<double>;
+}
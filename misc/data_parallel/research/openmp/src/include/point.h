@@ -4,71 +4,75 @@
 #include <string>
 
 namespace wingworks {
-    class Point {
+    // A point in the plane, with coordinates of type Real -- float or
+    // double.  Points of one type convert to the other only explicitly.
+    template <typename Real>
+    class BasicPoint {
     private:
-        double x_m;
-        double y_m;
+        Real x_m;
+        Real y_m;
 
     public:
-        Point(double x, double y): x_m(x), y_m(y) {}
-        Point(): x_m(0.0), y_m(0.0) {}
-        Point(const Point& src): x_m(src.x_m), y_m(src.y_m) {}
-        Point& operator=(const Point& src) {
-            x_m = src.x_m;
-            y_m = src.y_m;
-            return *this;
-        }
-
-        void update(const double x, const double y) {
+        BasicPoint(Real x, Real y): x_m(x), y_m(y) {}
+        BasicPoint(): x_m(0.0), y_m(0.0) {}
+        // Trivial copies let particles be copied, and sent between MPI
+        // ranks, as plain bytes.
+        BasicPoint(const BasicPoint& src) = default;
+        template <typename Other>
+        explicit BasicPoint(const BasicPoint<Other>& src): x_m(src.x()), y_m(src.y()) {}
+        BasicPoint& operator=(const BasicPoint& src) = default;
+
+        void update(const Real x, const Real y) {
             x_m = x;
             y_m = y;
         }
 
-        double dist_sqr(const Point& other) const {
-            const double dx = x_m - other.x_m;
-            const double dy = y_m - other.y_m;
+        Real dist_sqr(const BasicPoint& other) const {
+            const Real dx = x_m - other.x_m;
+            const Real dy = y_m - other.y_m;
             return (dx * dx) + (dy * dy);
         }
 
-        Point offset(const Point& other) const {
-            return Point(x_m - other.x_m, y_m - other.y_m);
+        BasicPoint offset(const BasicPoint& other) const {
+            return BasicPoint(x_m - other.x_m, y_m - other.y_m);
         }
 
-        void add(const Point& other) {
+        void add(const BasicPoint& other) {
             x_m += other.x_m;
             y_m += other.y_m;
         }
 
-        Point adding(const Point& other) const {
-            return Point(x_m + other.x_m, y_m + other.y_m);
+        BasicPoint adding(const BasicPoint& other) const {
+            return BasicPoint(x_m + other.x_m, y_m + other.y_m);
         }
 
-        Point scaled(const double s) const {
-            return Point(x_m * s, y_m * s);
+        BasicPoint scaled(const Real s) const {
+            return BasicPoint(x_m * s, y_m * s);
         }
 
-        inline double dot(const Point& other) const {
+        inline Real dot(const BasicPoint& other) const {
             return (x_m * other.x_m) + (y_m * other.y_m);
         }
 
-        Point normal() const {
-            return Point(-y_m, x_m);
+        BasicPoint normal() const {
+            return BasicPoint(-y_m, x_m);
         }
 
-        double mag_sqr() const {
+        Real mag_sqr() const {
             return (x_m * x_m + y_m * y_m);
         }
 
-        double magnitude() const {
-            return ::sqrt(mag_sqr());
+        Real magnitude() const {
+            return std::sqrt(mag_sqr());
         }
 
-        Point unit() const;
+        BasicPoint unit() const;
 
-        double x() const { return x_m; }
-        double y() const { return y_m; }
+        Real x() const { return x_m; }
+        Real y() const { return y_m; }
 
         std::string to_str() const;
     };
 
-}
\ No newline at end of file
+    using Point = BasicPoint<double>;
+}
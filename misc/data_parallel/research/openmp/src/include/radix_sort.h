@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdlib>
+#include <vector>
+
+namespace wingworks {
+
+// RadixSorter sorts unsigned 64-bit keys, least significant byte first,
+// splitting each pass among the threads of the calling team.  Each
+// thread counts the digits of its own contiguous chunk of keys; a
+// prefix sum over (digit, thread) then gives each thread a private
+// range of the output for every digit, so the scatter needs no locks
+// and every pass is stable.
+class RadixSorter {
+public:
+    // capacity: most keys to sort.  max_threads: largest team that
+    // will call sort.  With huge_pages, the scratch space is aligned to,
+    // and backed by, huge pages.
+    RadixSorter(const size_t capacity, const size_t max_threads, const bool huge_pages = false);
+    ~RadixSorter();
+
+    RadixSorter(const RadixSorter&) = delete;
+    RadixSorter& operator=(const RadixSorter&) = delete;
+
+    size_t capacity() const { return capacity_m; }
+    size_t max_threads() const { return max_threads_m; }
+
+    // Write the scratch space once, split evenly among the team, so that
+    // under a first-touch policy each thread's share is placed near it.
+    // Orphaned worksharing.
+    void first_touch();
+
+    // Sort keys[0, num_keys) by their low key_bits bits.  Higher bits
+    // must be zero.  Contains orphaned worksharing constructs: every
+    // thread of the team must call it, or call it outside a parallel
+    // region to sort serially.  num_keys must not exceed capacity(),
+    // nor the team max_threads(); the caller checks, since throwing
+    // from within a parallel region would terminate the program.
+    void sort(uint64_t *keys, const size_t num_keys, const unsigned key_bits);
+
+private:
+    const size_t capacity_m;
+    const size_t max_threads_m;
+    uint64_t *scratch_m;
+    // counts_m[thread * radix + digit]
+    std::vector<size_t> counts_m;
+};
+
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstdint>
+#include <limits>
+
+namespace wingworks {
+
+// CounterRNG is a small, cheap-to-construct random bit generator
+// (SplitMix64).  It can be seeded from a (seed, step, particle) triple,
+// so each particle draws from its own stream no matter which thread
+// happens to process it.  That keeps runs reproducible under OpenMP,
+// which a single shared std::mt19937 cannot do.
+//
+// It satisfies UniformRandomBitGenerator, so it can drive the
+// <random> distributions.
+class CounterRNG {
+private:
+    uint64_t state_m;
+
+    static uint64_t mix(uint64_t z) {
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+        return z ^ (z >> 31);
+    }
+
+public:
+    using result_type = uint64_t;
+
+    explicit CounterRNG(uint64_t seed)
+    : state_m(mix(seed))
+    {}
+
+    CounterRNG(uint64_t seed, uint64_t step, uint64_t index)
+    : state_m(mix(mix(mix(seed) ^ step) ^ index))
+    {}
+
+    static constexpr result_type min() { return 0; }
+    static constexpr result_type max() {
+        return std::numeric_limits<result_type>::max();
+    }
+
+    result_type operator()() {
+        state_m += 0x9e3779b97f4a7c15ULL;
+        return mix(state_m);
+    }
+};
+
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <cstdlib>
+#include <vector>
+
+#include "particle.h"
+#include "polygon.h"
+#include "simd_level.h"
+#include "vector.h"
+
+namespace wingworks {
+
+// SATPolyBatch does SATPolyCollision's work for many particles, several
+// per vector instruction.
+//
+// A polygon's projection onto its own edge normals doesn't depend on
+// the particle, so it is worked out once, up front, rather than once
+// per particle and axis.  Each group of particles is then projected
+// onto every cached axis, and onto the axis through its nearest polygon
+// vertex.  A lane drops out as soon as an axis separates its particle
+// from the polygon, and a group stops once all of its lanes have
+// dropped out.  The kernels repeat SATPolyCollision's arithmetic
+// operation for operation, so the normals are bitwise the same.
+class SATPolyBatch {
+public:
+    SATPolyBatch(const Polygon& poly, const SimdLevel level = best_simd_level());
+
+    SimdLevel level() const { return level_m; }
+
+    // For each of particles[indices[0, n)], find the collision normal
+    // as SATPolyCollision::find_collision_normal would.  Returns how
+    // many particles collide.  Single-precision particles are tested
+    // in double, as if they had been converted to Particles.
+    template <typename Real, typename Species>
+    size_t find_collision_normals(
+        const BasicParticle<Real, Species> *particles, const size_t *indices, const size_t n);
+
+    // For the h'th colliding particle: its position in indices, and its
+    // collision normal.
+    size_t hit(const size_t h) const { return hits_m[h]; }
+    const Vector& normal(const size_t h) const { return normals_m[h]; }
+
+private:
+    const SimdLevel level_m;
+
+    // The polygon's vertices, and its edge normals along with the
+    // polygon's projected extrema on each.
+    std::vector<double> vertex_x_m;
+    std::vector<double> vertex_y_m;
+    std::vector<double> axis_x_m;
+    std::vector<double> axis_y_m;
+    std::vector<double> axis_min_m;
+    std::vector<double> axis_max_m;
+
+    // The particles being tested, and for each the smallest overlap
+    // (-1: none) and the axis it was found on.
+    enum Row { X, Y, RADIUS, OVERLAP, NORMAL_X, NORMAL_Y, NUM_ROWS };
+    std::vector<double> stage_m[NUM_ROWS];
+
+    std::vector<size_t> hits_m;
+    std::vector<Vector> normals_m;
+};
+
+}
@@ -40,7 +40,7 @@ public:
 
         // If the line is nearly vertical, pretend the intersection
         // lies to the left of the point.
-        if (::abs(dx) < 1.0e-6) {
+        if (::fabs(dx) < 1.0e-6) {
             return p.x() - 1.0;
         }
         // What to do if the line is nearly horizontal?
@@ -0,0 +1,16 @@
+#pragma once
+
+namespace wingworks {
+
+// Vector instruction sets the batched kernels can use.  Kernels work on
+// doubles, so the widths are in doubles.
+enum class SimdLevel {
+    Scalar,
+    AVX2,    // 4 lanes
+    AVX512   // 8 lanes
+};
+
+// The widest level this CPU supports.
+SimdLevel best_simd_level();
+
+}
@@ -0,0 +1,169 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdlib>
+#include <vector>
+
+#include <mpi.h>
+
+#include "vector.h"
+#include "particle.h"
+#include "world_cells.h"
+#include "airfoil.h"
+#include "free_space.h"
+#include "world_options.h"
+#include "sat_poly_batch.h"
+
+namespace wingworks {
+
+// A SlabWorld is a World spread across the ranks of an MPI communicator,
+// so that it can outgrow one node's memory.  The grid of cells is cut
+// into horizontal slabs of whole rows, one per rank, and each rank owns
+// the particles whose home cells lie in its slab.
+//
+// Every step, each rank gathers ghost copies of the particles in the
+// rows just past its slab, searches its slab and those rows for pairs,
+// and throws the ghosts away.  Only its own particles are then collided
+// with the airfoil -- and only if the foil reaches into its slab -- and
+// integrated.  Particles whose home cells have left the slab, including
+// recycled ones, migrate to their new owners.
+//
+// The halo is deeper than the search's reach of one cell.  Cells are
+// searched one color at a time, and each color can carry a collision's
+// effect reach rows further, so the halo is as deep as that effect can
+// travel in a step: reach * (reach + 1) rows, rounded out so that slabs
+// keep the World's coloring.  With it, a SlabWorld computes the very
+// same particles as a World of the same size and seed, on any number of
+// ranks; only the force on the foil, summed in a different order, may
+// differ in the last bits.
+//
+// Within a rank the step loops use OpenMP threads.  The World's other
+// options -- executors, neighbor lists, batching and so on -- don't
+// apply; only seed, cell_extent and num_threads are used.
+//
+// Methods marked collective must be called by every rank.
+template <typename Real, typename Species = UniformSpecies>
+class BasicSlabWorld {
+public:
+    using Particle = BasicParticle<Real, Species>;
+
+    // Collective.  The communicator is duplicated, so the caller may
+    // free its own.
+    BasicSlabWorld(
+        MPI_Comm comm,
+        const Airfoil& foil,
+        const double width, const double height,
+        const double max_particle_speed,
+        const Vector& wind_vel,
+        const WorldOptions& options = WorldOptions()
+    );
+    ~BasicSlabWorld();
+
+    BasicSlabWorld(const BasicSlabWorld&) = delete;
+    BasicSlabWorld& operator=(const BasicSlabWorld&) = delete;
+
+    // Collective.
+    void step() {
+        step_many(1);
+    }
+    void step_many(const size_t num_steps);
+
+    size_t num_particles() const { return num_particles_m; }
+    // Particles this rank owns.
+    size_t num_local_particles() const { return num_owned_m; }
+    size_t step_count() const { return step_count_m; }
+
+    int rank() const { return rank_m; }
+    int num_ranks() const { return num_ranks_m; }
+    // This rank's slab: cell rows [first_row(), end_row()).
+    size_t first_row() const { return first_row_m[rank_m]; }
+    size_t end_row() const { return first_row_m[rank_m + 1]; }
+    // Rows of ghosts gathered past each side of a slab.
+    size_t halo_rows() const { return halo_rows_m; }
+
+    // Collective.  Sums over all ranks.
+    Vector force_on_foil() const;
+    void reset_force_on_foil() {
+        local_force_m.update(0.0, 0.0);
+    }
+    double momentum() const;
+
+    // Collective.  Gather every particle, in ID order, to rank 0.  Other
+    // ranks get an empty vector.  For tests and output of small worlds.
+    std::vector<Particle> gather_particles() const;
+
+private:
+    // A particle on its way to another rank.
+    struct Entry {
+        uint64_t id;
+        Particle particle;
+    };
+
+    MPI_Comm comm_m;
+    int rank_m;
+    int num_ranks_m;
+
+    Airfoil airfoil_m;
+    const double world_width_m;
+    const double world_height_m;
+    // Where the airfoil leaves room for particles.
+    const FreeSpace free_space_m;
+    const size_t num_particles_m;
+    const double max_speed_m;
+    const Vector wind_vel_m;
+    const uint64_t seed_m;
+    const double cell_extent_m;
+    const double interaction_range_m;
+    const size_t num_threads_m;
+    size_t step_count_m;
+
+    // The grid of the whole world, and how it is cut: rank r owns rows
+    // [first_row_m[r], first_row_m[r + 1]), and searches rows
+    // [grid_begin(r), grid_end(r)).
+    size_t num_horiz_m;
+    size_t num_vert_m;
+    size_t reach_m;
+    size_t halo_rows_m;
+    std::vector<size_t> first_row_m;
+    // Whether particles of this slab can reach the airfoil.
+    bool near_airfoil_m;
+
+    // Owned particles and their IDs; ghosts are appended for the pair
+    // search, then dropped.
+    std::vector<Particle> particles_m;
+    std::vector<uint64_t> ids_m;
+    size_t num_owned_m;
+    // Cells of rows [grid_begin(rank_m), grid_end(rank_m)).  Replaced by
+    // larger ones if particles outgrow them.
+    WorldCells *cells_m;
+    size_t cells_capacity_m;
+    std::vector<SATPolyBatch*> foil_batches_m;
+    // Per destination rank.
+    std::vector<std::vector<Entry>> outgoing_m;
+    std::vector<Entry> incoming_m;
+    Vector local_force_m;
+
+    size_t grid_begin(const size_t rank) const;
+    size_t grid_end(const size_t rank) const;
+    // As WorldCells::row_index, for the whole world's grid.
+    size_t row_of(const double y) const;
+    size_t owner_of_row(const size_t row) const;
+
+    void randomize();
+    void recycle(Particle& p, const size_t step, const uint64_t id);
+
+    // Send outgoing_m[r] to rank r, for every r, and receive into
+    // incoming_m.  Collective.
+    void exchange();
+    void gather_ghosts();
+    void assign_to_cells();
+    void collide_cell_particles(const size_t i_cell);
+    void collide_particles();
+    void collide_with_airfoil();
+    void integrate();
+    void migrate();
+};
+
+using SlabWorld = BasicSlabWorld<double>;
+
+}
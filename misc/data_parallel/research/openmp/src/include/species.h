@@ -0,0 +1,98 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+namespace wingworks {
+
+// Species policies give BasicParticle its mass and radius.  A particle
+// derives from its policy, so a policy can keep per-particle state, and
+// one that keeps none takes no space.
+
+// Every particle has the same mass and radius, known at compile time,
+// so arithmetic on them folds away.
+struct UniformSpecies {
+    static constexpr double mass() { return 1.0; }
+    static constexpr double radius() { return 0.5; }
+    static constexpr double max_radius() { return radius(); }
+
+    static constexpr size_t species() { return 0; }
+    // Pick a species for a new particle.
+    template <typename Gen>
+    void draw_species(Gen&) {}
+};
+
+struct SpeciesInfo {
+    double mass;
+    double radius;
+    // Share of the particles that draw_species gives this species.
+    double fraction;
+};
+
+// Each particle keeps a one-byte index into a table of species, shared
+// by all particles, so that a World can hold a gas mixture.  Until
+// set_table is called there is one species, just like UniformSpecies.
+class MixedSpecies {
+public:
+    static const size_t max_species = 16;
+
+    // Replace the species table.  Not thread-safe: set it up before
+    // creating particles, and leave it alone while they are in use.
+    static void set_table(const std::vector<SpeciesInfo>& table);
+    static size_t num_species() { return num_species_m; }
+    static double max_radius() { return max_radius_m; }
+
+    double mass() const { return mass_m[species_m]; }
+    double radius() const { return radius_m[species_m]; }
+
+    size_t species() const { return species_m; }
+    void set_species(const size_t species);
+    template <typename Gen>
+    void draw_species(Gen& gen) {
+        std::uniform_real_distribution<> frand(0.0, 1.0);
+        const double f = frand(gen);
+        size_t s = 0;
+        while ((s + 1 < num_species_m) && (f >= cumulative_m[s])) {
+            s += 1;
+        }
+        species_m = s;
+    }
+
+private:
+    uint8_t species_m = 0;
+
+    static size_t num_species_m;
+    static double max_radius_m;
+    static double mass_m[max_species];
+    static double radius_m[max_species];
+    // Running totals of the normalized fractions.
+    static double cumulative_m[max_species];
+};
+
+// Each particle stands for weight() molecules of the default species:
+// a particle of weight 4 has four times the mass, but the same radius.
+// Weights let a World spend fewer particles where the flow is dull
+// (see WorldOptions::coarsen).  Weights start at 1, and a World never
+// lets one fall below 1.
+class WeightedSpecies {
+public:
+    static constexpr double radius() { return UniformSpecies::radius(); }
+    static constexpr double max_radius() { return radius(); }
+
+    double mass() const { return weight_m; }
+    double weight() const { return weight_m; }
+    void set_weight(const double weight) { weight_m = float(weight); }
+
+    static constexpr size_t species() { return 0; }
+    template <typename Gen>
+    void draw_species(Gen&) {}
+
+private:
+    // Float keeps particles small; merges and splits only halve sums of
+    // weights, which float holds exactly for a good many merges.
+    float weight_m = 1.0f;
+};
+
+}
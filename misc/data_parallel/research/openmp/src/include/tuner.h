@@ -0,0 +1,92 @@
+#pragma once
+
+#include <cstdlib>
+#include <functional>
+#include <memory>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "world.h"
+#include "world_options.h"
+
+namespace wingworks {
+
+// A TuningProfile records the step-loop settings that ran fastest on
+// one kind of machine, so later runs there can reuse them instead of
+// calibrating again.
+//
+// Profiles are text, one "key=value" per line:
+//     cell_extent=1
+//     num_threads=16
+//     schedule=dynamic
+//     chunk_size=64
+//     steps_per_second=41.7
+// Lines starting with '#' are comments.
+struct TuningProfile {
+    double cell_extent;
+    size_t num_threads;
+    LoopSchedule schedule;
+    size_t chunk_size;
+    // Measured during calibration; informational.
+    double steps_per_second;
+
+    TuningProfile();
+    explicit TuningProfile(const WorldOptions& options);
+
+    void apply_to(WorldOptions& options) const;
+
+    void write(std::ostream& outs) const;
+    // Throws std::invalid_argument if the profile is malformed.
+    static TuningProfile read(std::istream& ins);
+};
+
+std::string to_string(LoopSchedule schedule);
+// Throws std::invalid_argument for an unknown name.
+LoopSchedule loop_schedule_named(const std::string& name);
+
+// Tuner times short runs of a World under candidate settings and picks
+// the fastest.  It searches one setting at a time -- cell extent, then
+// schedule and chunk size, then thread count -- keeping the best value
+// of each before moving to the next, so calibration takes a few dozen
+// short runs rather than the full cross product.
+//
+// Each trial times step_many(timed_steps), the loop a run calls once per
+// frame, several times over on one World, and scores the median, so that
+// one lucky or unlucky run doesn't decide it.
+class Tuner {
+public:
+    // Builds a World like the one to be tuned, with the given options.
+    using WorldFactory = std::function<std::unique_ptr<World>(const WorldOptions&)>;
+
+    struct ScheduleChoice {
+        LoopSchedule schedule;
+        size_t chunk_size;
+    };
+
+    // Throws std::invalid_argument if repetitions is less than 3.
+    Tuner(
+        WorldFactory make_world, const size_t warmup_steps = 2,
+        const size_t timed_steps = 10, const size_t repetitions = 3);
+
+    void set_cell_extents(const std::vector<double>& extents) { cell_extents_m = extents; }
+    void set_schedules(const std::vector<ScheduleChoice>& schedules) { schedules_m = schedules; }
+    void set_thread_counts(const std::vector<size_t>& counts) { thread_counts_m = counts; }
+
+    // Calibrate starting from base, logging each trial.
+    TuningProfile calibrate(const WorldOptions& base, std::ostream& log) const;
+
+private:
+    WorldFactory make_world_m;
+    const size_t warmup_steps_m;
+    const size_t timed_steps_m;
+    const size_t repetitions_m;
+
+    std::vector<double> cell_extents_m;
+    std::vector<ScheduleChoice> schedules_m;
+    std::vector<size_t> thread_counts_m;
+
+    double steps_per_second(const WorldOptions& options) const;
+};
+
+}
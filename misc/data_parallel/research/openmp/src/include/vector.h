@@ -5,5 +5,7 @@
 namespace wingworks {
     // Alias: a Vector has a direction and a magnitude and can be
     // represented as a Point.
+    template <typename Real>
+    using BasicVector = BasicPoint<Real>;
     using Vector = Point;
-}
\ No newline at end of file
+}
@@ -1,33 +1,99 @@
 #pragma once
 
 #include <cstdlib>
+#include <memory>
 #include <random>
 #include <iostream>
+#include <vector>
 
 #include "vector.h"
 #include "particle.h"
 #include "world_cells.h"
+#include "cell_balancer.h"
+#include "cell_stats.h"
+#include "dsmc_cells.h"
+#include "flow_boundaries.h"
+#include "free_space.h"
+#include "neighbor_lists.h"
+#include "pair_screen.h"
+#include "radix_sort.h"
 #include "airfoil.h"
 #include "bbox.h"
+#include "world_options.h"
+#include "airfoil_collision.h"
+#include "sat_poly_batch.h"
+#include "frame_channel.h"
 
 namespace wingworks {
 
-class World {
+// A World whose particles are stored as Real: double, or float to halve
+// the memory traffic of every phase.  Sums over all particles -- the
+// force on the foil and the momentum -- are kept in double either way.
+// The two kinds of World start from the same random state, so they can
+// be compared.
+template <typename Real, typename Species = UniformSpecies>
+class BasicWorld {
 public:
-    World(
+    using Particle = BasicParticle<Real, Species>;
+
+    BasicWorld(
         const Airfoil& foil,
         const double width, const double height, 
         const double max_particle_speed,
-        const Vector& wind_vel
+        const Vector& wind_vel,
+        const WorldOptions& options = WorldOptions()
     );
-    ~World();
+    ~BasicWorld();
+
+    // World owns raw particle and stats arrays.
+    BasicWorld(const BasicWorld&) = delete;
+    BasicWorld& operator=(const BasicWorld&) = delete;
 
     void step() {
-        assign_to_cells();
-        collide_particles();
-        collide_with_airfoil();
-        integrate();
+        step_many(1);
+    }
+
+    // Advance num_steps steps inside a single OpenMP parallel region,
+    // with barriers between the phases of each step, rather than
+    // forking and joining a team for every phase of every step.
+    void step_many(const size_t num_steps);
+
+    size_t num_particles() const { return num_particles_m; }
+    // How many particles a World of this size starts with.
+    static size_t particle_count(const double width, const double height) {
+        // Use a little secret knowledge of particle size to calculate max
+        // number of particles without overlap.  Assume square grid rather
+        // than hex packing.  Assume no airfoil.
+        // Apply an over-density fudge factor (FF).
+        const double ff = 10.0;
+        return width * height * ff;  // Particle radius: 0.5
     }
+    // Particles are identified by their initial index, which does not
+    // change when the World reorders its particle storage.  A World that
+    // coarsens (see WorldOptions::coarsen), or has open boundaries,
+    // changes its number of particles and renumbers them.
+    const Particle& particle(const size_t id) const { return particles_m[slot_of_m[id]]; }
+    // Particle storage itself, for views that avoid copying: slot i
+    // holds the particle whose ID is storage_ids()[i].  Both change when
+    // the World reorders its storage, so fetch them again after
+    // stepping.
+    const Particle *particle_storage() const { return particles_m; }
+    const size_t *storage_ids() const { return id_of_m; }
+    size_t step_count() const { return step_count_m; }
+    // How many times NeighborLists were built, or 0 if not in use.
+    size_t neighbor_list_builds() const {
+        return neighbor_lists_m ? neighbor_lists_m->num_builds() : 0;
+    }
+    // How many times, with incremental cells, a particle changed cells.
+    size_t cell_migrations() const { return num_migrations_m; }
+    // How many particles each thread recycled in the last Phased step.
+    const std::vector<size_t>& recycled_per_thread() const { return recycled_per_thread_m; }
+    // How many particles, with open boundaries, arrived to find no room
+    // left in particle storage, and were turned away.
+    size_t turned_away() const { return num_turned_away_m; }
+    // How many particles, with open boundaries, would have arrived
+    // inside the foil, where it reaches an open edge, and were dropped.
+    size_t blocked_arrivals() const { return num_blocked_m; }
 
     const Vector& force_on_foil() const {
         return net_force_on_foil_m;
@@ -38,42 +104,220 @@ public:
 
     double momentum() const {
         double result = 0.0;
-        for (size_t i = 0; i < num_particles_m; ++i) {
-            result += particles_m[i].momentum();
+        for (size_t id = 0; id < num_particles_m; ++id) {
+            result += particle(id).momentum();
         }
         return result;
     }
 
+    // Cell statistics are collected only if WorldOptions asked for them;
+    // otherwise this returns nullptr.
+    const CellStats* cell_stats() const { return cell_stats_m; }
+    void reset_cell_stats() {
+        if (cell_stats_m) {
+            cell_stats_m->reset();
+        }
+    }
+
     void write_particle_positions(std::ostream& outs) const;
     void write_force_on_foil(std::ostream& outs) const;
+    void write_cell_stats(std::ostream& outs) const;
 
 private:
     Airfoil airfoil_m;
     const double world_width_m;
     const double world_height_m;
+    // Where the airfoil leaves room for particles.
+    const FreeSpace free_space_m;
 
-    const size_t num_particles_m;
+    // Particles in use, and room for them.  Coarsening never exceeds the
+    // initial count: it conserves total weight, and keeps every
+    // particle's weight at least 1.  Open boundaries can, so they get
+    // room to spare.
+    size_t num_particles_m;
+    const size_t max_particles_m;
 
     const double max_speed_m;  // ignoring wind, maximum speed
 
     const Vector wind_vel_m;
+    const uint64_t seed_m;
+    size_t step_count_m;
+
+    const size_t num_threads_m;
+    const LoopSchedule schedule_m;
+    const size_t chunk_size_m;
+    const StepExecutor executor_m;
+    const bool huge_pages_m;
+    const size_t tile_columns_m;
 
+    // Particle storage.  particles_m[slot] is the particle whose ID is
+    // id_of_m[slot], and slot_of_m maps IDs back to slots.  Everything
+    // that must not depend on storage order -- the order of particles
+    // in a cell, and recycling's random streams -- goes by ID.
     Particle *particles_m;
+    size_t *id_of_m;
+    size_t *slot_of_m;
+    const size_t reorder_interval_m;
+    size_t next_reorder_step_m;
+    Particle *reorder_buffer_m;
+    uint64_t *reorder_keys_m;
+    RadixSorter *sorter_m;
+    const size_t balance_interval_m;
     WorldCells cells_m;
-    const BBox world_bbox_m;
+    // One per thread, kept across steps so that stepping doesn't
+    // allocate.
+    std::vector<SATPolyBatch*> foil_batches_m;
+    std::vector<PairScreen<Real>> pair_screens_m;
+    // One per color, if pair searches are balanced by cell cost.
+    std::vector<CellBalancer*> balancers_m;
+    // Per-cell state, if pair collisions are DSMC's.
+    DsmcCells *dsmc_m;
+    // Coarsening state; an interval of 0 disables it.  Particles merge
+    // outside merge_zone_m and split inside refine_zone_m.
+    const size_t coarsen_interval_m;
+    const double merge_gradient_m;
+    const double max_weight_m;
+    const BBox refine_zone_m;
+    const BBox merge_zone_m;
+    // Each cell's total weight and mean velocity.
+    std::vector<double> cell_weight_m;
+    std::vector<Vector> cell_vel_m;
+    // Per thread, the cell being merged, lightest first.
+    std::vector<std::vector<size_t>> merge_order_m;
+    // Halves of split particles, waiting for slots.
+    std::vector<Particle> split_halves_m;
+    // Slots of particles that left the world this step, in no particular
+    // order, with room for every particle; and how many each thread then
+    // recycled.
+    std::vector<size_t> exits_m;
+    size_t num_exits_m;
+    std::vector<size_t> recycled_per_thread_m;
+    // Open boundary state: the particles arriving.
+    FlowBoundaries *boundaries_m;
+    std::vector<Arrival> inflow_m;
+    size_t num_turned_away_m;
+    size_t num_blocked_m;
+    CellStats *cell_stats_m;
+    NeighborLists *neighbor_lists_m;
+    // With neighbor lists, each step's strays, binned like cells_m by
+    // their undrifted positions.
+    WorldCells *stray_cells_m;
+    std::unique_ptr<FramePublisher> frame_publisher_m;
+
+    // Incremental cell state: each particle's home cell in cells_m, and
+    // per-thread queues of particles that have left their home cells.
+    struct Migration {
+        size_t index;
+        size_t from_cell;
+        size_t to_cell;
+    };
+    const bool incremental_cells_m;
+    bool cells_filled_m;
+    size_t *home_cell_m;
+    std::vector<std::vector<Migration>> migrations_m;
+    size_t num_migrations_m;
+    const BasicBBox<Real> world_bbox_m;
     Vector net_force_on_foil_m;
 
     void randomize();
     // Recycle a particle -- bring it back into the world.
-    void recycle(Particle& p, size_t index);
+    // Recycling draws from a random stream keyed by step and index.
+    void recycle(Particle& p, const size_t step, const size_t index);
 
     bool is_out_of_world(const Particle& p) const;
 
+    // Make the step loops use this World's schedule.  Every thread calls
+    // it at the start of a parallel region.
+    void apply_loop_settings() const;
+    // Initialize particle and cell storage in parallel, so that each
+    // part of it is placed near the thread that will use it.  Orphaned
+    // worksharing.
+    void first_touch();
+
+    // Orders slots by the IDs of the particles in them.
+    auto by_id() const {
+        return [this](const size_t slot1, const size_t slot2) {
+            return id_of_m[slot1] < id_of_m[slot2];
+        };
+    }
+    // If reordering is due, sort particle storage by Morton order of
+    // home cells.  Orphaned worksharing, like the step phases.
+    void reorder_if_due();
+    void reorder_particles();
+
+    // The step phases.  Each contains orphaned worksharing constructs,
+    // so every thread of step_many's team must call each of them.
     void assign_to_cells();
-    void collide_cell_particles(const Cell& cell);    
+    void collide_cell_particles(const WorldCells& cells, const size_t i_cell);
+    // Collide the particles of a span of cells that may be searched in
+    // parallel -- part of a color.
+    void collide_span(const WorldCells& cells, const CellSpan& span);
+    // Collide the particles of span's cells [k_begin, k_end), on the
+    // calling thread alone.
+    void collide_span_cells(
+        const WorldCells& cells, const CellSpan& span, const size_t k_begin, const size_t k_end);
     void collide_particles();
+    // DSMC pair collisions, in place of collide_particles.
+    void collide_dsmc();
+    void collide_dsmc_cell(const size_t i_cell);
+    // Merge and split weighted particles, if coarsening is due, leaving
+    // them renumbered and the cells to be refilled.
+    void coarsen_if_due();
+    void coarsen();
     void collide_with_airfoil();
+    // Move the particles, then recycle those that left the world in a
+    // separate pass, spread evenly over the threads.
     void integrate();
+    // Note that the particle in slot i left the world.  Thread-safe.
+    void note_exit(const size_t i);
+    // With open boundaries, remove the particles that left and add those
+    // that arrived.  Called by one thread.
+    void exchange_through_boundaries();
+    void finish_step();
+    // Publish the World's state to frame_publisher_m.  Orphaned
+    // worksharing.
+    void publish_frame();
+    // The Fused executor's replacement for the last three phases.
+    void fused_sweep();
+
+    // Pair collisions using neighbor_lists_m, rebuilding them as needed.
+    void collide_listed_particles();
+    void collide_listed_cell(const size_t i_cell);
+    void collide_strays();
+    void collide_stray_cell(const size_t i_cell);
+
+    // How a Fused sweep divides the grid into tiles.
+    struct SweepGeometry {
+        const long num_horiz;
+        const long reach;
+        const long num_colors;
+        const long tile;
+        // Columns by which integration trails the sweep front.
+        const long lag;
+        const long num_tiles;
+
+        SweepGeometry(const WorldCells& cells, const size_t tile_columns);
+    };
+    // Do the pair collisions of sweep tile t.
+    void collide_tile(const WorldCells& cells, const SweepGeometry& geom, const long t);
+    // Get the cells whose particles are ready to integrate after tile t.
+    CellSpan finished_cells(const WorldCells& cells, const SweepGeometry& geom, const long t) const;
+
+    // Per-particle pieces of the phases, shared by the executors.
+    // Collide particles_m[indices[0, n)] with the foil, in order.  Any
+    // impulse the foil imparts is added to force.
+    void collide_with_airfoil(
+        AirfoilCollision& collider, SATPolyBatch& batch,
+        const size_t *indices, const size_t n, Vector& force);
+    // Returns true if the particle was recycled.
+    bool integrate(Particle& particle, const size_t step, const size_t index);
+    // With incremental cells, queue the particle to move if it has left
+    // its home cell.
+    void track_migration(const Particle& particle, const size_t index);
+    void apply_migrations();
+    void add_force_on_foil(const Vector& force);
 };
 
-}
\ No newline at end of file
+using World = BasicWorld<double>;
+
+}
@@ -1,55 +1,365 @@
 #pragma once
+#include <cstdint>
 #include <cstdlib>
+#include <algorithm>
 #include <cmath>
 #include <vector>
 #include <stdexcept>
 #include <sstream>
 #include <iostream>
 
+#include "page_alloc.h"
 #include "particle.h"
 
 namespace wingworks {
-// 2D: should be more like 4, with extras for adding particles
-// that really belong to up to 8 neighbors.
-// A problem: particles may be randomized in such a way that they overlap.
-const static size_t max_particles_per_cell = 128; 
+// Without overlap a unit cell holds only a particle or two.
+// A problem: particles may be randomized in such a way that they overlap,
+// and World packs them densely.  CellStats' occupancy histogram shows how
+// far past this guess real runs go.  This bounds the histogram only;
+// WorldCells sizes its own storage.
+const static size_t max_particles_per_cell = 128;
 
-using Cell = std::vector<size_t>;
+// A view of the indices of the particles in one cell.  It stays valid
+// until particles are next added to or moved between cells.
+class Cell {
+private:
+    const size_t *begin_m;
+    size_t size_m;
+
+public:
+    Cell(const size_t *begin, const size_t size): begin_m(begin), size_m(size) {}
+
+    size_t size() const { return size_m; }
+    bool empty() const { return size_m == 0; }
+    const size_t *data() const { return begin_m; }
+    const size_t *begin() const { return begin_m; }
+    const size_t *end() const { return begin_m + size_m; }
+    size_t operator[](const size_t i) const { return begin_m[i]; }
+};
+
+// A CellSpan is a regular lattice of cells: num_rows x num_cols cells
+// starting at (row0, col0), row_step rows and col_step columns apart.
+// Its cells are numbered 0 <= k < size(), row-major.
+struct CellSpan {
+    size_t row0, col0;
+    size_t row_step, col_step;
+    size_t num_rows, num_cols;
+    size_t num_horiz;  // Width of the whole grid
+
+    size_t size() const { return num_rows * num_cols; }
+    size_t cell(const size_t k) const {
+        const size_t row = row0 + (k / num_cols) * row_step;
+        const size_t col = col0 + (k % num_cols) * col_step;
+        return row * num_horiz + col;
+    }
+};
 
+// WorldCells bins particles by their home cell -- the cell containing
+// the particle's center.  Particles that can touch each other have home
+// cells no more than reach() cells apart, so a pair search needs only to
+// visit each cell and its "forward" neighbors (see forward_neighbors()).
+//
+// All cells share storage allocated up front, so that filling them
+// never allocates.  Each cell has a fixed number of slots in one slab,
+// a couple of times the mean occupancy.  A cell that outgrows its slots
+// moves to a larger region of a shared overflow area.  Overflow regions
+// are handed out in order and all given back by clear().  If the area
+// fills up between clears -- as it can with incremental cells, which are
+// never cleared -- it is compacted.  It is big enough that compaction
+// always makes room for max_particles particles.
 class WorldCells {
 private:
     double cell_extent_m;
     size_t num_horiz_m;
     size_t num_vert_m;
     size_t num_cells_m;
-    Cell *cells_m;
+    size_t reach_m;
+    // Color strides: a forward search spans reach + 1 rows and
+    // 2 * reach + 1 columns.
+    size_t color_rows_m;
+    size_t color_cols_m;
+
+    size_t max_particles_m;
+    size_t slab_capacity_m;  // Slots per cell in slab_m
+    size_t *slab_m;
+    size_t overflow_capacity_m;
+    size_t overflow_used_m;
+    size_t *overflow_m;
+    // Where each cell's indices are, how many there are, and room for how
+    // many.
+    size_t **begin_m;
+    size_t *size_m;
+    size_t *capacity_m;
+    // Scratch space for compaction.
+    size_t *compact_order_m;
 
 public:
+    // interaction_range is the largest center-to-center distance at
+    // which two particles can touch.  max_particles is the most particles
+    // the cells will hold at once.  With huge_pages, the slab and
+    // overflow area are aligned to, and backed by, huge pages.
     WorldCells(
         const double world_width, const double world_height,
-        const double cell_extent)
+        const double cell_extent, const double interaction_range,
+        const size_t max_particles, const bool huge_pages = false)
     {
+        if (cell_extent <= 0.0) {
+            throw std::invalid_argument("Cell extent must be positive.");
+        }
         cell_extent_m = cell_extent;
         num_horiz_m = ::ceil(world_width / cell_extent);
         num_vert_m = ::ceil(world_height / cell_extent);
         num_cells_m = num_horiz_m * num_vert_m;
-        cells_m = new Cell[num_cells_m];
+        reach_m = ::ceil(interaction_range / cell_extent);
+        color_rows_m = reach_m + 1;
+        color_cols_m = 2 * reach_m + 1;
+
+        max_particles_m = max_particles;
+        const size_t mean_occupancy = (max_particles + num_cells_m - 1) / num_cells_m;
+        slab_capacity_m = (2 * mean_occupancy > 4) ? 2 * mean_occupancy : 4;
+        slab_m = allocate_array<size_t>(num_cells_m * slab_capacity_m, huge_pages);
+        // A cell grows by doubling.  After compaction at most
+        // max_particles slots are in use, and growing one cell needs at
+        // most twice its size more.
+        overflow_capacity_m = 3 * max_particles;
+        overflow_used_m = 0;
+        overflow_m = allocate_array<size_t>(overflow_capacity_m, huge_pages);
+        begin_m = new size_t*[num_cells_m];
+        size_m = new size_t[num_cells_m];
+        capacity_m = new size_t[num_cells_m];
+        compact_order_m = new size_t[num_cells_m];
+        for (size_t i = 0; i < num_cells_m; ++i) {
+            reset_cell(i);
+        }
     }
 
     ~WorldCells() {
-        delete [] cells_m;
+        delete [] compact_order_m;
+        delete [] capacity_m;
+        delete [] size_m;
+        delete [] begin_m;
+        free_pages(overflow_m);
+        free_pages(slab_m);
     }
 
+    // WorldCells owns raw storage.
+    WorldCells(const WorldCells&) = delete;
+    WorldCells& operator=(const WorldCells&) = delete;
+
+    // Adding and moving particles is not thread-safe; clearing and
+    // sorting cells is.
     void clear();
-    void add(const Particle& particle, const size_t particle_index);
+    // Write every slot once, as clear() and the step loops divide the
+    // cells among threads, so that under a first-touch policy each
+    // thread's cells are placed near it.  Leaves the cells cleared.
+    void first_touch();
+    template <typename Real, typename Species>
+    void add(const BasicParticle<Real, Species>& particle, const size_t particle_index) {
+        // Assign the particle only to its home cell.  Inserting it into
+        // every cell it overlapped made neighboring cells share particles,
+        // so a pair that straddled a cell boundary collided once per
+        // shared cell.
+        add_to(index_of(particle.pos_x(), particle.pos_y()), particle_index);
+    }
+    // Add a particle to a known cell.  Cells filled this way need not
+    // be in particle order until sort_cell puts them back in it.
+    void add_to(const size_t cell_index, const size_t particle_index) {
+        make_room(cell_index);
+        begin_m[cell_index][size_m[cell_index]++] = particle_index;
+    }
+    // Put a cell's particles in order, as given by less(index1, index2).
+    template <typename Less>
+    void sort_cell(const size_t cell_index, Less less) {
+        size_t *begin = begin_m[cell_index];
+        std::sort(begin, begin + size_m[cell_index], less);
+    }
+    // Move a particle between cells that are in the order given by less,
+    // keeping them so.
+    template <typename Less>
+    void move(const size_t particle_index, const size_t from_cell, const size_t to_cell, Less less) {
+        size_t *from_end = begin_m[from_cell] + size_m[from_cell];
+        size_t *gone = std::find(begin_m[from_cell], from_end, particle_index);
+        std::copy(gone + 1, from_end, gone);
+        size_m[from_cell] -= 1;
+
+        make_room(to_cell);
+        size_t *to = begin_m[to_cell];
+        size_t *to_end = to + size_m[to_cell];
+        size_t *pos = std::lower_bound(to, to_end, particle_index, less);
+        std::copy_backward(pos, to_end, to_end + 1);
+        *pos = particle_index;
+        size_m[to_cell] += 1;
+    }
     size_t size() const { return num_cells_m; }
+    size_t slab_capacity() const { return slab_capacity_m; }
+    // Overflow slots in use, including those left behind by cells that
+    // have since grown again.
+    size_t overflow_used() const { return overflow_used_m; }
+
+    double cell_extent() const { return cell_extent_m; }
+    size_t num_horiz() const { return num_horiz_m; }
+    size_t num_vert() const { return num_vert_m; }
+    size_t reach() const { return reach_m; }
+
+    size_t col_of(const size_t cell_index) const { return cell_index % num_horiz_m; }
+    size_t row_of(const size_t cell_index) const { return cell_index / num_horiz_m; }
+
+    // Get the Morton (Z-order) code of a cell: its column and row bits,
+    // interleaved.  Cells close in Z-order are close in space.
+    uint64_t morton_of(const size_t cell_index) const {
+        return spread_bits(col_of(cell_index)) | (spread_bits(row_of(cell_index)) << 1);
+    }
+    // Bits needed to hold any cell's Morton code.
+    unsigned morton_bits() const {
+        const size_t max_coord = ((num_horiz_m > num_vert_m) ? num_horiz_m : num_vert_m) - 1;
+        unsigned bits = 0;
+        while ((size_t(1) << bits) <= max_coord) {
+            bits += 1;
+        }
+        return 2 * bits;
+    }
+
+    // Get the index of the cell containing a point.  Points outside
+    // the grid are clamped to the nearest edge cell.
+    size_t index_of(const double x, const double y) const {
+        return row_index(y) * num_horiz_m + col_index(x);
+    }
+
+    // Call f(neighbor_index) for each cell whose particles may touch
+    // particles in cell_index, and which lies after it in a row-major
+    // sweep: the rest of its row within reach, and the full width of
+    // the next reach rows.  Visiting each cell together with its forward
+    // neighbors covers every candidate pair exactly once.
+    template <typename F>
+    void for_each_forward_neighbor(const size_t cell_index, F f) const {
+        const long col = col_of(cell_index);
+        const long row = row_of(cell_index);
+        const long reach = reach_m;
+        const long num_horiz = num_horiz_m;
+        const long num_vert = num_vert_m;
 
-    const Cell& cell(size_t cell_index) const {
+        for (long dc = 1; (dc <= reach) && (col + dc < num_horiz); ++dc) {
+            f(cell_index + dc);
+        }
+        for (long r = row + 1; (r <= row + reach) && (r < num_vert); ++r) {
+            const long c_min = (col > reach) ? col - reach : 0;
+            const long c_max = (col + reach < num_horiz) ? col + reach : num_horiz - 1;
+            for (long c = c_min; c <= c_max; ++c) {
+                f(size_t(r * num_horiz + c));
+            }
+        }
+    }
+
+    // Call f(neighbor_index) for each cell within reach of cell_index,
+    // in every direction, including cell_index itself.
+    template <typename F>
+    void for_each_nearby(const size_t cell_index, F f) const {
+        const long col = col_of(cell_index);
+        const long row = row_of(cell_index);
+        const long reach = reach_m;
+        const long c_min = (col > reach) ? col - reach : 0;
+        const long c_max = (col + reach < long(num_horiz_m)) ? col + reach : num_horiz_m - 1;
+        const long r_min = (row > reach) ? row - reach : 0;
+        const long r_max = (row + reach < long(num_vert_m)) ? row + reach : num_vert_m - 1;
+        for (long r = r_min; r <= r_max; ++r) {
+            for (long c = c_min; c <= c_max; ++c) {
+                f(size_t(r * num_horiz_m + c));
+            }
+        }
+    }
+
+    // Cells are colored so that the pair searches of any two cells
+    // of the same color -- each cell plus its forward neighbors -- touch
+    // disjoint sets of particles.  The cells of one color can therefore
+    // be searched in parallel, one color after another.  Because the
+    // result does not depend on the order within a color, it does not
+    // depend on the number of threads either.
+    size_t num_colors() const { return color_rows_m * color_cols_m; }
+    // Get the cells of a color, optionally only those in columns
+    // [col_begin, col_end).
+    CellSpan color_span(const size_t color) const {
+        return color_span(color, 0, num_horiz_m);
+    }
+    CellSpan color_span(const size_t color, const size_t col_begin, const size_t col_end) const;
+    // A coarser coloring for searches of every cell within reach (see
+    // for_each_nearby): cells of one such color are 2 * reach + 1 apart
+    // in both directions, so their searches touch disjoint cells.
+    size_t num_nearby_colors() const { return color_cols_m * color_cols_m; }
+    CellSpan nearby_color_span(const size_t color) const;
+
+    // Get all cells in columns [col_begin, col_end).
+    CellSpan column_span(const size_t col_begin, const size_t col_end) const;
+
+    Cell cell(size_t cell_index) const {
         if (cell_index >= num_cells_m) {
             throw std::invalid_argument("Cell index is out of range.");
         }
-        return cells_m[cell_index];
+        return Cell(begin_m[cell_index], size_m[cell_index]);
+    }
+
+private:
+    void reset_cell(const size_t cell_index) {
+        begin_m[cell_index] = slab_m + cell_index * slab_capacity_m;
+        size_m[cell_index] = 0;
+        capacity_m[cell_index] = slab_capacity_m;
+    }
+
+    // Only cells that have outgrown their slots have more room.
+    bool in_overflow(const size_t cell_index) const {
+        return capacity_m[cell_index] > slab_capacity_m;
+    }
+
+    // Make room in a cell for one more particle.
+    void make_room(const size_t cell_index) {
+        if (size_m[cell_index] < capacity_m[cell_index]) {
+            return;
+        }
+        size_t new_capacity = 2 * capacity_m[cell_index];
+        if (overflow_used_m + new_capacity > overflow_capacity_m) {
+            compact_overflow();
+            if (size_m[cell_index] < capacity_m[cell_index]) {
+                return;
+            }
+            new_capacity = 2 * capacity_m[cell_index];
+            if (overflow_used_m + new_capacity > overflow_capacity_m) {
+                throw std::invalid_argument("Cells hold more particles than they were sized for.");
+            }
+        }
+        size_t *region = overflow_m + overflow_used_m;
+        std::copy(begin_m[cell_index], begin_m[cell_index] + size_m[cell_index], region);
+        overflow_used_m += new_capacity;
+        begin_m[cell_index] = region;
+        capacity_m[cell_index] = new_capacity;
+    }
+
+    void compact_overflow();
+
+    // Spread the low 32 bits of v to the even bits of the result.
+    static uint64_t spread_bits(uint64_t v) {
+        v &= 0xffffffffULL;
+        v = (v | (v << 16)) & 0x0000ffff0000ffffULL;
+        v = (v | (v << 8)) & 0x00ff00ff00ff00ffULL;
+        v = (v | (v << 4)) & 0x0f0f0f0f0f0f0f0fULL;
+        v = (v | (v << 2)) & 0x3333333333333333ULL;
+        v = (v | (v << 1)) & 0x5555555555555555ULL;
+        return v;
+    }
+
+    size_t col_index(const double x) const {
+        const double col = ::floor(x / cell_extent_m);
+        if (col < 0.0) {
+            return 0;
+        }
+        return (col < num_horiz_m) ? size_t(col) : num_horiz_m - 1;
+    }
+
+    size_t row_index(const double y) const {
+        const double row = ::floor(y / cell_extent_m);
+        if (row < 0.0) {
+            return 0;
+        }
+        return (row < num_vert_m) ? size_t(row) : num_vert_m - 1;
     }
 };
 
-}
\ No newline at end of file
+}
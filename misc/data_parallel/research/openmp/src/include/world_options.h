@@ -0,0 +1,205 @@
+#pragma once
+
+#include <cstdint>
+#include <random>
+#include <string>
+
+namespace wingworks {
+
+// How World's parallel loops divide their iterations among threads.
+// These map onto the OpenMP schedule kinds.
+enum class LoopSchedule {
+    Static,
+    Dynamic,
+    Guided
+};
+
+// How World::step_many orders the work of a step.
+enum class StepExecutor {
+    // One pass over all particles or cells per phase: pair collisions,
+    // then airfoil collisions, then integration.
+    Phased,
+    // One sweep over tiles of cell columns, doing all three phases for
+    // each tile before moving on.  Same results as Phased.
+    Fused
+};
+
+// How World::step_many collides particles with each other.
+enum class CollisionModel {
+    // Deterministic hard spheres: every overlapping pair found by a
+    // search of each cell and its neighbors collides.
+    HardSpheres,
+    // Direct Simulation Monte Carlo: each cell draws candidate pairs
+    // from its own particles and collides them with a probability that
+    // gives a hard-sphere gas's collision rate (see DsmcCells).
+    DSMC
+};
+
+// What happens to particles that leave the world.
+enum class BoundaryModel {
+    // Bring them back in: wrap them around horizontally, at a random
+    // height and velocity.  The world must be big enough for the
+    // artifacts to die out before they reach the foil.
+    Recycle,
+    // Open edges backed by freestream reservoirs (see FlowBoundaries):
+    // an inflow on the left, an outflow on the right.
+    Open
+};
+
+// With open boundaries, what the top and bottom edges do.
+enum class SideWalls {
+    // Reflect particles.  The world is a channel, and a foil that fills
+    // much of its height chokes the flow.
+    Specular,
+    // Let them leave, and let freestream particles in.
+    Freestream
+};
+
+// Run-time knobs for a World.  Defaults reproduce the demo's behavior.
+struct WorldOptions {
+    // Seed for initial particle placement and for recycling.
+    // Set explicitly to get reproducible runs.
+    uint64_t seed;
+
+    // Width and height of a WorldCells cell, in world units.
+    // Cells narrower than a particle diameter make the pair search
+    // visit more neighbors; wider cells make it test more pairs.
+    double cell_extent;
+
+    // Collect CellStats while stepping.
+    bool collect_cell_stats;
+
+    // Threads for the step loops; 0 means the OpenMP default.
+    //
+    // On a multi-socket machine, bind the threads to cores, e.g. with
+    //     OMP_PLACES=cores OMP_PROC_BIND=close
+    // World initializes its particles and cells with the step loops'
+    // own schedule, so that each page lands on the socket of the thread
+    // that works on it (see World::first_touch).  With a static schedule
+    // each thread then keeps to a fixed slab of particles, and -- once
+    // particles are reordered (reorder_interval) -- those particles are
+    // a contiguous region of space.  Unbound threads may migrate between
+    // sockets and lose that locality; dynamic and guided schedules give
+    // it up as well.  "close" keeps neighboring regions, which exchange
+    // particles and share cell searches, on the same socket.
+    size_t num_threads;
+
+    // Schedule for the step loops.  A chunk size of 0 means the
+    // schedule's default chunking.
+    LoopSchedule schedule;
+    size_t chunk_size;
+
+    StepExecutor executor;
+    // Width, in cell columns, of a Fused tile.  A tile's particles, plus
+    // those of the columns the sweep lags behind it, should fit in cache.
+    size_t tile_columns;
+
+    // Find colliding pairs from NeighborLists rather than by searching
+    // the cells every step.  Phased executor only.  The skin is in world
+    // units; a wider skin means fewer rebuilds but longer lists.
+    bool neighbor_lists;
+    double neighbor_skin;
+
+    // Keep cell membership from step to step, moving only the particles
+    // whose home cell changed, rather than rebuilding the cells every
+    // step.  Phased and Fused executors, without neighbor lists.
+    bool incremental_cells;
+
+    // Every this many steps, re-sort particle storage into Morton order
+    // of the particles' home cells, so that particles near each other in
+    // space are near each other in memory.  0 disables reordering.
+    size_t reorder_interval;
+
+    // Divide each color's pair searches among threads by their estimated
+    // cost, from cell occupancy, rather than by cell count, re-planning
+    // every balance_interval steps (see CellBalancer).  Helps when
+    // particles crowd, as they do in front of the airfoil.  Phased
+    // executor, without neighbor lists.  Same results either way.
+    bool balance_cells;
+    size_t balance_interval;
+
+    // How particles collide with each other.  DSMC needs the Phased
+    // executor, without neighbor lists or balanced cells.
+    // Its cells should be no wider than a mean free path, and its
+    // dsmc_weight is the number of gas molecules each particle stands
+    // for: the collision rate scales with it.
+    CollisionModel collisions;
+    double dsmc_weight;
+
+    // Coarsen the flow where nothing much happens: every
+    // coarsen_interval steps, merge a cell's particles four at a time,
+    // lightest first, into pairs of half their weight, if the cell is far
+    // from the foil and its mean velocity differs from each neighbor's by
+    // at most merge_gradient; and halve particles of weight 2 or more
+    // within refine_margin of the foil's bounding box.  No merge makes a
+    // particle heavier than max_weight.
+    // Particles merge only outside twice refine_margin, so that they
+    // don't merge and split over and over at the zone's edge, and the
+    // margin should be wider than the wind carries a particle between
+    // coarsenings.  A particle recycled through the top or bottom keeps
+    // its weight, and may land near the foil until the next coarsening
+    // halves it.  Needs a World of WeightedSpecies and the Phased
+    // executor, without neighbor lists, incremental cells, reordering
+    // or DSMC.  Particles are renumbered by every coarsening.
+    // The default merge_gradient is about the noise in a cell's mean
+    // velocity at a few particles per cell; much less, and few cells
+    // ever count as smooth.  A heavy particle has the radius of a light
+    // one, so coarse gas pushes back less, and the force on the foil
+    // falls as max_weight rises; at the default it stays within 5% of
+    // an uncoarsened World's.
+    bool coarsen;
+    size_t coarsen_interval;
+    double refine_margin;
+    double merge_gradient;
+    double max_weight;
+
+    // What happens at the edges of the world.  Open boundaries let the
+    // number of particles vary, renumbering them every step, and need
+    // the Phased executor, without neighbor lists, incremental cells or
+    // reordering.  The reservoirs' density is the World's initial
+    // density, and their thermal speed its maximum particle speed, as
+    // the RMS speed about the wind.  Where the foil reaches an open edge,
+    // nothing comes in through it; World::blocked_arrivals counts the
+    // arrivals dropped there.
+    BoundaryModel boundaries;
+    SideWalls side_walls;
+
+    // Align particle and cell arrays to 2 MiB huge pages, and ask the
+    // kernel to back them with huge pages, to cut TLB misses on large
+    // worlds.
+    bool huge_pages;
+
+    // If set, the name of a POSIX shared-memory object -- "/wingworks",
+    // say -- into which every step_many publishes the World's state as a
+    // frame, for viewers in other processes (see FramePublisher).
+    std::string frame_channel;
+
+    WorldOptions()
+    : seed(std::random_device()())
+    , cell_extent(1.0)
+    , collect_cell_stats(false)
+    , num_threads(0)
+    , schedule(LoopSchedule::Static)
+    , chunk_size(0)
+    , executor(StepExecutor::Phased)
+    , tile_columns(16)
+    , neighbor_lists(false)
+    , neighbor_skin(0.5)
+    , incremental_cells(false)
+    , reorder_interval(0)
+    , balance_cells(false)
+    , balance_interval(1)
+    , collisions(CollisionModel::HardSpheres)
+    , dsmc_weight(1.0)
+    , coarsen(false)
+    , coarsen_interval(10)
+    , refine_margin(4.0)
+    , merge_gradient(0.05)
+    , max_weight(2.0)
+    , boundaries(BoundaryModel::Recycle)
+    , side_walls(SideWalls::Specular)
+    , huge_pages(false)
+    {}
+};
+
+}
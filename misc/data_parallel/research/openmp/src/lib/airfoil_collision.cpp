@@ -8,11 +8,12 @@ namespace wingworks {
         return collider.find_collision_normal(particle, recoil_vec_result);
     }
 
+    template <typename Real, typename Species>
     Vector AirfoilCollision::resolve_collision(
-        Particle& particle, Vector& recoil_vec
+        BasicParticle<Real, Species>& particle, Vector& recoil_vec
     ) const
     {
-        particle.move_to(particle.pos().adding(recoil_vec));
+        particle.move_to(Vector(particle.pos()).adding(recoil_vec));
         Vector n = recoil_vec.unit();
         double accel_mag = accel_from_foil(particle, n);
         Vector particle_accel = n.scaled(-accel_mag);
@@ -20,17 +21,31 @@ namespace wingworks {
         return particle_accel.scaled(particle.mass());
     }
 
+    template <typename Real, typename Species>
     double AirfoilCollision::accel_from_foil(
-        const Particle& particle, const Vector& normal
+        const BasicParticle<Real, Species>& particle, const Vector& normal
     ) const
     {
             // e is the coefficient of restitution.  Set to 1 for
             // a perfectly elastic collision, I think.
             const double e = 1.0;
             // Relative collision velocity:
-            Vector vr = foil_m.vel().offset(particle.vel());
+            Vector vr = foil_m.vel().offset(Vector(particle.vel()));
             // Ignore rotational inertia.  Treat the airfoil as
             // being infinitely massive.
             return -(1.0 + e) * vr.dot(normal);
     }
-}
\ No newline at end of file
+
+    template Vector AirfoilCollision::resolve_collision(BasicParticle<float>&, Vector&) const;
+    template Vector AirfoilCollision::resolve_collision(BasicParticle<double>&, Vector&) const;
+    template Vector AirfoilCollision::resolve_collision(BasicParticle<float, MixedSpecies>&, Vector&) const;
+    template Vector AirfoilCollision::resolve_collision(BasicParticle<double, MixedSpecies>&, Vector&) const;
+    template Vector AirfoilCollision::resolve_collision(BasicParticle<float, WeightedSpecies>&, Vector&) const;
+    template Vector AirfoilCollision::resolve_collision(BasicParticle<double, WeightedSpecies>&, Vector&) const;
+    template double AirfoilCollision::accel_from_foil(const BasicParticle<float>&, const Vector&) const;
+    template double AirfoilCollision::accel_from_foil(const BasicParticle<double>&, const Vector&) const;
+    template double AirfoilCollision::accel_from_foil(const BasicParticle<float, MixedSpecies>&, const Vector&) const;
+    template double AirfoilCollision::accel_from_foil(const BasicParticle<double, MixedSpecies>&, const Vector&) const;
+    template double AirfoilCollision::accel_from_foil(const BasicParticle<float, WeightedSpecies>&, const Vector&) const;
+    template double AirfoilCollision::accel_from_foil(const BasicParticle<double, WeightedSpecies>&, const Vector&) const;
+}
@@ -4,7 +4,8 @@
 namespace wingworks {
     using namespace std;
 
-    bool BBox::overlaps(const BBox& other) const {
+    template <typename Real>
+    bool BasicBBox<Real>::overlaps(const BasicBBox& other) const {
         if ((xmax_m < other.xmin_m) 
             || (xmin_m > other.xmax_m)
             || (ymax_m < other.ymin_m)
@@ -15,11 +16,15 @@ namespace wingworks {
         return true;
     }
 
-    std::string BBox::to_str() const {
+    template <typename Real>
+    std::string BasicBBox<Real>::to_str() const {
         ostringstream outs;
         outs
             << "(xmin=" << xmin_m << ", ymin=" << ymin_m 
             << ", xmax=" << xmax_m << ", ymax=" << ymax_m << ")";
         return outs.str();
     }
-}
\ No newline at end of file
+
+    template class BasicBBox<float>;
+    template class BasicBBox<double>;
+}
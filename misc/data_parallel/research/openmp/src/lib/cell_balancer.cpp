@@ -0,0 +1,54 @@
+#include "cell_balancer.h"
+
+#include <stdexcept>
+
+namespace wingworks {
+
+    CellBalancer::CellBalancer(const size_t num_threads, const size_t chunks_per_thread)
+    : num_threads_m(num_threads)
+    , chunks_per_thread_m(chunks_per_thread)
+    , chunk_begin_m(num_threads * chunks_per_thread + 1, 0)
+    , next_m(nullptr)
+    {
+        if ((num_threads == 0) || (chunks_per_thread == 0)) {
+            throw std::invalid_argument("A CellBalancer needs at least one thread and chunk.");
+        }
+        next_m = new Cursor[num_threads_m];
+        // Start every queue exhausted, as for_each_chunk leaves them.
+        for (size_t t = 0; t < num_threads_m; ++t) {
+            next_m[t].chunk.store((t + 1) * chunks_per_thread_m, std::memory_order_relaxed);
+        }
+    }
+
+    CellBalancer::~CellBalancer() {
+        delete [] next_m;
+    }
+
+    // Chunk c ends at the first cell at which the running cost reaches
+    // (c + 1) / num_chunks of the total.  A single cell costlier than a
+    // chunk's share gets a chunk to itself, and leaves the chunks after
+    // it empty.
+    void CellBalancer::plan(const WorldCells& cells, const CellSpan& span) {
+        const size_t num_cells = span.size();
+        double total = 0.0;
+        for (size_t k = 0; k < num_cells; ++k) {
+            total += cell_cost(cells.cell(span.cell(k)).size());
+        }
+
+        const size_t num_chunks = this->num_chunks();
+        double running = 0.0;
+        size_t k = 0;
+        chunk_begin_m[0] = 0;
+        for (size_t c = 0; c < num_chunks; ++c) {
+            const double target = total * double(c + 1) / double(num_chunks);
+            while ((k < num_cells) && (running < target)) {
+                running += cell_cost(cells.cell(span.cell(k)).size());
+                k += 1;
+            }
+            chunk_begin_m[c + 1] = k;
+        }
+        // Rounding must not leave cells out.
+        chunk_begin_m[num_chunks] = num_cells;
+    }
+
+}
@@ -0,0 +1,62 @@
+#include "cell_stats.h"
+
+#include <algorithm>
+
+namespace wingworks {
+    using namespace std;
+
+    CellStats::CellStats(const WorldCells& cells, const size_t block_size)
+    : num_horiz_m(cells.num_horiz())
+    , num_vert_m(cells.num_vert())
+    , cell_extent_m(cells.cell_extent())
+    , block_size_m(block_size)
+    , blocks_horiz_m((num_horiz_m + block_size - 1) / block_size)
+    , blocks_vert_m((num_vert_m + block_size - 1) / block_size)
+    , occupancy_m(max_particles_per_cell + 1)
+    , hot_spots_m(blocks_horiz_m * blocks_vert_m)
+    {
+        reset();
+    }
+
+    void CellStats::reset() {
+        num_steps_m = 0;
+        pairs_tested_m = 0;
+        pairs_colliding_m = 0;
+        fill(occupancy_m.begin(), occupancy_m.end(), 0);
+        fill(hot_spots_m.begin(), hot_spots_m.end(), 0);
+    }
+
+    void CellStats::record_occupancy(const WorldCells& cells) {
+        const size_t last_bin = occupancy_m.size() - 1;
+        for (size_t i = 0; i < cells.size(); ++i) {
+            const size_t count = cells.cell(i).size();
+            occupancy_m[(count < last_bin) ? count : last_bin] += 1;
+        }
+    }
+
+    void CellStats::write(ostream& outs) const {
+        outs << "steps," << num_steps_m << endl
+             << "cell_extent," << cell_extent_m << endl;
+
+        // Drop empty high-occupancy bins; they are the common case.
+        size_t num_bins = occupancy_m.size();
+        while ((num_bins > 1) && (occupancy_m[num_bins - 1] == 0)) {
+            num_bins -= 1;
+        }
+        outs << "occupancy";
+        for (size_t i = 0; i < num_bins; ++i) {
+            outs << "," << occupancy_m[i];
+        }
+        outs << endl;
+
+        outs << "pairs_tested," << pairs_tested_m << endl
+             << "pairs_colliding," << pairs_colliding_m << endl;
+
+        outs << "hot_spots," << block_size_m << ","
+             << blocks_horiz_m << "," << blocks_vert_m;
+        for (const size_t tested : hot_spots_m) {
+            outs << "," << tested;
+        }
+        outs << endl;
+    }
+}
@@ -0,0 +1,65 @@
+#include "coarsening.h"
+
+#include <cmath>
+
+namespace wingworks {
+
+    template <typename Real>
+    void merge_particles(
+        WeightedParticle<Real> *particles, const size_t *indices, const size_t n,
+        const Vector& direction)
+    {
+        // Sums in double, whatever the storage type.
+        double weight = 0.0;
+        Vector pos_sum;
+        Vector vel_sum;
+        for (size_t k = 0; k < n; ++k) {
+            const WeightedParticle<Real>& p(particles[indices[k]]);
+            weight += p.weight();
+            pos_sum.add(Vector(p.pos()).scaled(p.weight()));
+            vel_sum.add(Vector(p.vel()).scaled(p.weight()));
+        }
+        const Vector center(pos_sum.scaled(1.0 / weight));
+        const Vector mean_vel(vel_sum.scaled(1.0 / weight));
+
+        // Twice the kinetic energy about the mean velocity, and the
+        // weighted squared distance from the center.
+        double thermal = 0.0;
+        double spread = 0.0;
+        for (size_t k = 0; k < n; ++k) {
+            const WeightedParticle<Real>& p(particles[indices[k]]);
+            thermal += p.weight() * Vector(p.vel()).offset(mean_vel).mag_sqr();
+            spread += p.weight() * Vector(p.pos()).offset(center).mag_sqr();
+        }
+        // Two particles of weight W / 2 at V +/- d have energy W d^2 / 2
+        // about V.
+        const double d = ::sqrt(thermal / weight);
+        const double s = ::sqrt(spread / weight);
+
+        const double half = 0.5 * weight;
+        const Vector dv(direction.scaled(d));
+        const Vector dx(direction.scaled(s));
+        WeightedParticle<Real>& p0(particles[indices[0]]);
+        WeightedParticle<Real>& p1(particles[indices[1]]);
+        p0.set_weight(half);
+        p0.move_to(center.adding(dx));
+        p0.set_vel(mean_vel.x() + dv.x(), mean_vel.y() + dv.y());
+        p1.set_weight(half);
+        p1.move_to(center.offset(dx));
+        p1.set_vel(mean_vel.x() - dv.x(), mean_vel.y() - dv.y());
+    }
+
+    template <typename Real>
+    void split_particle(WeightedParticle<Real>& p, WeightedParticle<Real>& half, const Vector& offset) {
+        const Vector pos(p.pos());
+        p.set_weight(0.5 * p.weight());
+        half = p;
+        p.move_to(pos.adding(offset));
+        half.move_to(pos.offset(offset));
+    }
+
+    template void merge_particles(WeightedParticle<float> *, const size_t *, const size_t, const Vector&);
+    template void merge_particles(WeightedParticle<double> *, const size_t *, const size_t, const Vector&);
+    template void split_particle(WeightedParticle<float>&, WeightedParticle<float>&, const Vector&);
+    template void split_particle(WeightedParticle<double>&, WeightedParticle<double>&, const Vector&);
+}
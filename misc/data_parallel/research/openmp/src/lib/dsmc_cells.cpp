@@ -0,0 +1,54 @@
+#include "dsmc_cells.h"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+namespace wingworks {
+
+    DsmcCells::DsmcCells(
+        const WorldCells& cells, const double world_width, const double world_height,
+        const double weight, const double max_sigma_cr)
+    : weight_m(weight)
+    , area_m(cells.size(), 0.0)
+    , max_sigma_cr_m(cells.size(), max_sigma_cr)
+    , remainder_m(cells.size(), 0.0)
+    {
+        if (weight <= 0.0) {
+            throw std::invalid_argument("DSMC weight must be positive.");
+        }
+        if (max_sigma_cr <= 0.0) {
+            throw std::invalid_argument("DSMC's initial maximum sigma c_r must be positive.");
+        }
+        // The last column and row of cells may stick out of the world.
+        const double extent = cells.cell_extent();
+        for (size_t i = 0; i < cells.size(); ++i) {
+            const double left = cells.col_of(i) * extent;
+            const double bottom = cells.row_of(i) * extent;
+            const double w = std::min(extent, world_width - left);
+            const double h = std::min(extent, world_height - bottom);
+            area_m[i] = w * h;
+        }
+    }
+
+    size_t DsmcCells::num_candidates(const size_t cell_index, const size_t num_particles) {
+        if (num_particles < 2) {
+            return 0;
+        }
+        const double n = num_particles;
+        const double expected =
+            0.5 * n * (n - 1.0) * weight_m * max_sigma_cr_m[cell_index] / area_m[cell_index]
+            + remainder_m[cell_index];
+        const double whole = ::floor(expected);
+        remainder_m[cell_index] = expected - whole;
+        return size_t(whole);
+    }
+
+    bool DsmcCells::accept(const size_t cell_index, const double sigma_cr, const double draw) {
+        double& max_sigma_cr(max_sigma_cr_m[cell_index]);
+        if (sigma_cr > max_sigma_cr) {
+            max_sigma_cr = sigma_cr;
+        }
+        return draw * max_sigma_cr < sigma_cr;
+    }
+}
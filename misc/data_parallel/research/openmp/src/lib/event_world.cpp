@@ -0,0 +1,468 @@
+#include "event_world.h"
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <stdexcept>
+
+#include "airfoil_collision.h"
+#include "rng.h"
+
+namespace wingworks {
+    namespace {
+        const double infinity = std::numeric_limits<double>::infinity();
+
+        // Tries at placing a particle where it overlaps nothing.
+        const size_t max_placement_tries = 1000;
+        const size_t max_recycle_tries = 100;
+
+        // The time until two discs, dr apart and closing at dv, first
+        // touch, or infinity if they don't.  Discs that already overlap
+        // touch now if they are closing.
+        double contact_time(const Vector& dr, const Vector& dv, const double sigma) {
+            const double b = dr.dot(dv);
+            if (b >= 0.0) {
+                return infinity;
+            }
+            const double gap = dr.mag_sqr() - sigma * sigma;
+            if (gap <= 0.0) {
+                return 0.0;
+            }
+            const double dv2 = dv.mag_sqr();
+            const double d = b * b - dv2 * gap;
+            if (d < 0.0) {
+                return infinity;
+            }
+            // Written so as not to lose precision when b * b >> dv2 * gap.
+            return gap / (-b + std::sqrt(d));
+        }
+
+        double segment_dist_sqr(const Point& p, const Point& a, const Point& b) {
+            const Vector ab(b.offset(a));
+            const double len_sqr = ab.mag_sqr();
+            double f = (len_sqr > 0.0) ? p.offset(a).dot(ab) / len_sqr : 0.0;
+            f = std::min(1.0, std::max(0.0, f));
+            return p.offset(a.adding(ab.scaled(f))).mag_sqr();
+        }
+
+        bool less_index(const size_t i, const size_t j) {
+            return i < j;
+        }
+    }
+
+    EventWorld::EventWorld(
+        const Airfoil& foil, const double width, const double height,
+        const size_t num_particles, const double max_speed, const Vector& wind,
+        const uint64_t seed, const double cell_extent)
+    : airfoil_m(foil)
+    , world_width_m(width)
+    , world_height_m(height)
+    , max_speed_m(max_speed)
+    , wind_vel_m(wind)
+    , seed_m(seed)
+    , time_m(0.0)
+    , particles_m(num_particles)
+    , cells_m(width, height, cell_extent, 2.0 * UniformSpecies::max_radius(), num_particles)
+    {
+        place_randomly(num_particles);
+        start();
+    }
+
+    EventWorld::EventWorld(
+        const Airfoil& foil, const double width, const double height,
+        const std::vector<Particle>& particles, const double max_speed, const Vector& wind,
+        const uint64_t seed, const double cell_extent)
+    : airfoil_m(foil)
+    , world_width_m(width)
+    , world_height_m(height)
+    , max_speed_m(max_speed)
+    , wind_vel_m(wind)
+    , seed_m(seed)
+    , time_m(0.0)
+    , particles_m(particles)
+    , cells_m(width, height, cell_extent, 2.0 * UniformSpecies::max_radius(), particles.size())
+    {
+        updated_m.assign(particles_m.size(), 0.0);
+        cell_of_m.resize(particles_m.size());
+        for (size_t i = 0; i < particles_m.size(); ++i) {
+            const Particle& p(particles_m[i]);
+            if (overlaps(Vector(p.pos()), p.radius(), i)) {
+                throw std::invalid_argument("EventWorld particles must not overlap.");
+            }
+            cell_of_m[i] = cells_m.index_of(p.pos_x(), p.pos_y());
+            cells_m.add_to(cell_of_m[i], i);
+        }
+        start();
+    }
+
+    // Like World::randomize, but a particle that would overlap another
+    // is placed again.
+    void EventWorld::place_randomly(const size_t num_particles) {
+        std::mt19937 gen(seed_m);
+        std::uniform_real_distribution<> sxrand(0.0, world_width_m);
+        std::uniform_real_distribution<> syrand(0.0, world_height_m);
+        std::uniform_real_distribution<> vrand(-max_speed_m, max_speed_m);
+
+        updated_m.assign(num_particles, 0.0);
+        cell_of_m.resize(num_particles);
+        for (size_t i = 0; i < num_particles; ++i) {
+            Particle& p(particles_m[i]);
+            size_t tries = 0;
+            Vector pos;
+            do {
+                if (++tries > max_placement_tries) {
+                    throw std::invalid_argument("Too many particles to place without overlap.");
+                }
+                pos = Vector(sxrand(gen), syrand(gen));
+            } while (overlaps(pos, p.radius(), i));
+            p.move_to(pos);
+            const Vector vel(
+                wind_vel_m.adding(Vector(vrand(gen), vrand(gen)).unit().scaled(max_speed_m)));
+            p.set_vel(vel.x(), vel.y());
+
+            cell_of_m[i] = cells_m.index_of(pos.x(), pos.y());
+            cells_m.add_to(cell_of_m[i], i);
+        }
+    }
+
+    void EventWorld::start() {
+        if (cells_m.reach() > 1) {
+            throw std::invalid_argument("EventWorld cells must be at least a particle diameter wide.");
+        }
+        course_m.assign(particles_m.size(), 0);
+        calendars_m.resize(cells_m.size());
+        cell_queue_m.resize(cells_m.size());
+        queue_pos_m.resize(cells_m.size());
+        for (size_t c = 0; c < cells_m.size(); ++c) {
+            cell_queue_m[c] = c;
+            queue_pos_m[c] = c;
+        }
+        for (size_t i = 0; i < particles_m.size(); ++i) {
+            predict(i);
+        }
+    }
+
+    double EventWorld::momentum() const {
+        double result = 0.0;
+        for (const Particle& p : particles_m) {
+            result += p.momentum();
+        }
+        return result;
+    }
+
+    void EventWorld::advance_to(const double t) {
+        if (t < time_m) {
+            throw std::invalid_argument("An EventWorld cannot go back in time.");
+        }
+        while (!cell_queue_m.empty()) {
+            const size_t c = cell_queue_m.front();
+            if (earliest(c) > t) {
+                break;
+            }
+            std::vector<Event>& calendar(calendars_m[c]);
+            std::pop_heap(calendar.begin(), calendar.end(), Later());
+            const Event event(calendar.back());
+            calendar.pop_back();
+            requeue(c);
+            handle(event);
+        }
+        time_m = t;
+        for (size_t i = 0; i < particles_m.size(); ++i) {
+            update(i);
+        }
+    }
+
+    void EventWorld::update(const size_t i) {
+        particles_m[i].move_to(position_now(i));
+        updated_m[i] = time_m;
+    }
+
+    Vector EventWorld::position_now(const size_t i) const {
+        const Particle& p(particles_m[i]);
+        return Vector(p.pos()).adding(Vector(p.vel()).scaled(time_m - updated_m[i]));
+    }
+
+    void EventWorld::predict(const size_t i) {
+        course_m[i] += 1;
+        const Particle& p(particles_m[i]);
+        const Vector pos(p.pos());
+        const Vector vel(p.vel());
+        const size_t c = cell_of_m[i];
+
+        // The particle's course changes when it leaves its cell, so
+        // nothing after that need be scheduled.
+        const double extent = cells_m.cell_extent();
+        const double x0 = cells_m.col_of(c) * extent;
+        const double y0 = cells_m.row_of(c) * extent;
+        const double x1 = std::min(x0 + extent, world_width_m);
+        const double y1 = std::min(y0 + extent, world_height_m);
+        double horizon = infinity;
+        size_t wall = 0;
+        if (vel.x() != 0.0) {
+            horizon = (vel.x() > 0.0) ? (x1 - pos.x()) / vel.x() : (x0 - pos.x()) / vel.x();
+            wall = (vel.x() > 0.0) ? 1 : 0;
+        }
+        if (vel.y() != 0.0) {
+            const double t_y = (vel.y() > 0.0) ? (y1 - pos.y()) / vel.y() : (y0 - pos.y()) / vel.y();
+            if (t_y < horizon) {
+                horizon = t_y;
+                wall = (vel.y() > 0.0) ? 3 : 2;
+            }
+        }
+        horizon = std::max(0.0, horizon);
+        counts_m.predictions += 2;
+        if (horizon < infinity) {
+            schedule(c, Event {time_m + horizon, i, wall, course_m[i], 0, EventKind::Wall});
+        }
+
+        cells_m.for_each_nearby(c, [&](const size_t c_other) {
+            for (const size_t j : cells_m.cell(c_other)) {
+                if (j == i) {
+                    continue;
+                }
+                counts_m.predictions += 1;
+                const Particle& q(particles_m[j]);
+                const double dt = contact_time(
+                    pos.offset(position_now(j)), vel.offset(Vector(q.vel())),
+                    p.radius() + q.radius());
+                if (dt < horizon) {
+                    schedule(c, Event {time_m + dt, i, j, course_m[i], course_m[j], EventKind::Pair});
+                }
+            }
+        });
+
+        // Most particles can't reach the foil before leaving their cells.
+        const BBox& foil_box(airfoil_m.shape().bbox());
+        const Vector end(pos.adding(vel.scaled(horizon)));
+        const double r = p.radius();
+        if ((horizon < infinity)
+            && (std::max(pos.x(), end.x()) + r >= foil_box.xmin())
+            && (std::min(pos.x(), end.x()) - r <= foil_box.xmin() + foil_box.width())
+            && (std::max(pos.y(), end.y()) + r >= foil_box.ymin())
+            && (std::min(pos.y(), end.y()) - r <= foil_box.ymin() + foil_box.height())) {
+            size_t feature = 0;
+            const double dt = foil_contact(pos, vel, r, feature);
+            if (dt < horizon) {
+                schedule(c, Event {time_m + dt, i, feature, course_m[i], 0, EventKind::Foil});
+            }
+        }
+    }
+
+    // The earliest contact with any edge, or with any vertex.  Edges are
+    // tested from whichever side the particle is on.
+    double EventWorld::foil_contact(
+        const Vector& pos, const Vector& vel, const double radius, size_t& feature)
+    {
+        const std::vector<Point>& vertices(airfoil_m.shape().vertices());
+        const size_t num_edges = vertices.size();
+        counts_m.predictions += 2 * num_edges;
+        double result = infinity;
+        for (size_t k = 0; k < num_edges; ++k) {
+            const Point& a(vertices[k]);
+            const Point& b(vertices[(k + 1) % num_edges]);
+            const Vector along(b.offset(a));
+            const double len = along.magnitude();
+            const Vector u(along.scaled(1.0 / len));
+            Vector n(u.normal());
+            double s = pos.offset(a).dot(n);
+            if (s < 0.0) {
+                n = n.scaled(-1.0);
+                s = -s;
+            }
+            const double closing = -vel.dot(n);
+            if (closing > 0.0) {
+                const double dt = std::max(0.0, (s - radius) / closing);
+                const double f = pos.adding(vel.scaled(dt)).offset(a).dot(u);
+                if ((f >= 0.0) && (f <= len) && (dt < result)) {
+                    result = dt;
+                    feature = k;
+                }
+            }
+            const double dt_vertex = contact_time(pos.offset(a), vel, radius);
+            if (dt_vertex < result) {
+                result = dt_vertex;
+                feature = num_edges + k;
+            }
+        }
+        return result;
+    }
+
+    void EventWorld::schedule(const size_t cell_index, const Event& event) {
+        std::vector<Event>& calendar(calendars_m[cell_index]);
+        calendar.push_back(event);
+        std::push_heap(calendar.begin(), calendar.end(), Later());
+        requeue(cell_index);
+    }
+
+    void EventWorld::requeue(const size_t cell_index) {
+        size_t pos = queue_pos_m[cell_index];
+        const double key = earliest(cell_index);
+        const auto place = [this](const size_t at, const size_t c) {
+            cell_queue_m[at] = c;
+            queue_pos_m[c] = at;
+        };
+        while ((pos > 0) && (earliest(cell_queue_m[(pos - 1) / 2]) > key)) {
+            place(pos, cell_queue_m[(pos - 1) / 2]);
+            pos = (pos - 1) / 2;
+        }
+        const size_t size = cell_queue_m.size();
+        for (;;) {
+            size_t child = 2 * pos + 1;
+            if (child >= size) {
+                break;
+            }
+            if ((child + 1 < size)
+                && (earliest(cell_queue_m[child + 1]) < earliest(cell_queue_m[child]))) {
+                child += 1;
+            }
+            if (earliest(cell_queue_m[child]) >= key) {
+                break;
+            }
+            place(pos, cell_queue_m[child]);
+            pos = child;
+        }
+        place(pos, cell_index);
+    }
+
+    void EventWorld::handle(const Event& event) {
+        if ((course_m[event.a] != event.course_a)
+            || ((event.kind == EventKind::Pair) && (course_m[event.b] != event.course_b))) {
+            counts_m.stale_events += 1;
+            return;
+        }
+        time_m = event.time;
+        switch (event.kind) {
+            case EventKind::Pair: collide_pair(event.a, event.b); break;
+            case EventKind::Foil: collide_with_foil(event.a, event.b); break;
+            case EventKind::Wall: cross_wall(event.a, event.b); break;
+        }
+    }
+
+    void EventWorld::collide_pair(const size_t i, const size_t j) {
+        update(i);
+        update(j);
+        Particle& p_i(particles_m[i]);
+        Particle& p_j(particles_m[j]);
+        p_i.collide_along(p_j, p_i.pos().offset(p_j.pos()).unit());
+        counts_m.pair_collisions += 1;
+        predict(i);
+        predict(j);
+    }
+
+    void EventWorld::collide_with_foil(const size_t i, const size_t feature) {
+        update(i);
+        Particle& p(particles_m[i]);
+        const std::vector<Point>& vertices(airfoil_m.shape().vertices());
+        const size_t num_edges = vertices.size();
+        Vector n;
+        if (feature < num_edges) {
+            const Point& a(vertices[feature]);
+            n = vertices[(feature + 1) % num_edges].offset(a).normal().unit();
+            if (Vector(p.pos()).offset(a).dot(n) < 0.0) {
+                n = n.scaled(-1.0);
+            }
+        } else {
+            n = Vector(p.pos()).offset(vertices[feature - num_edges]).unit();
+        }
+        // As World does: the impulse on the particle is the force on the
+        // foil.
+        AirfoilCollision collider(airfoil_m);
+        const Vector particle_accel(n.scaled(-collider.accel_from_foil(p, n)));
+        p.accelerate(particle_accel);
+        net_force_on_foil_m.add(particle_accel.scaled(p.mass()));
+        counts_m.foil_collisions += 1;
+        predict(i);
+    }
+
+    // A particle moves to the neighbor across the wall, or, if the wall
+    // is the world's edge, is recycled.
+    void EventWorld::cross_wall(const size_t i, const size_t wall) {
+        update(i);
+        const size_t from = cell_of_m[i];
+        long col = cells_m.col_of(from);
+        long row = cells_m.row_of(from);
+        switch (wall) {
+            case 0: col -= 1; break;
+            case 1: col += 1; break;
+            case 2: row -= 1; break;
+            default: row += 1; break;
+        }
+        if ((col < 0) || (col >= long(cells_m.num_horiz()))
+            || (row < 0) || (row >= long(cells_m.num_vert()))) {
+            recycle(i);
+            return;
+        }
+        const size_t to = row * cells_m.num_horiz() + col;
+        cells_m.move(i, from, to, less_index);
+        cell_of_m[i] = to;
+        counts_m.cell_crossings += 1;
+        predict(i);
+    }
+
+    // Like World::recycle.  A particle is put back where it overlaps
+    // nothing if a few tries can find such a place; otherwise it starts
+    // out overlapping, and any particle it is closing on collides with
+    // it at once.
+    void EventWorld::recycle(const size_t i) {
+        Particle& p(particles_m[i]);
+        CounterRNG gen(seed_m, counts_m.recycles, i);
+        std::uniform_real_distribution<> syrand(0.0, world_height_m);
+        std::uniform_real_distribution<> vrand(-max_speed_m, max_speed_m);
+        counts_m.recycles += 1;
+
+        // A particle leaving by the right edge is exactly on it, and
+        // would leave again at once if it stayed there.
+        double x = p.pos_x();
+        while (x < 0) {
+            x += world_width_m;
+        }
+        while (x >= world_width_m) {
+            x -= world_width_m;
+        }
+        Vector pos(x, syrand(gen));
+        for (size_t tries = 1;
+             (tries < max_recycle_tries) && overlaps(pos, p.radius(), i); ++tries) {
+            pos = Vector(x, syrand(gen));
+        }
+        p.move_to(pos);
+        p.set_vel(vrand(gen) + wind_vel_m.x(), vrand(gen) + wind_vel_m.y());
+
+        const size_t to = cells_m.index_of(pos.x(), pos.y());
+        cells_m.move(i, cell_of_m[i], to, less_index);
+        cell_of_m[i] = to;
+        predict(i);
+    }
+
+    bool EventWorld::overlaps(const Vector& pos, const double radius, const size_t except) const {
+        const Polygon& shape(airfoil_m.shape());
+        if (shape.contains(pos)) {
+            return true;
+        }
+        const std::vector<Point>& vertices(shape.vertices());
+        for (size_t k = 0; k < vertices.size(); ++k) {
+            if (segment_dist_sqr(pos, vertices[k], vertices[(k + 1) % vertices.size()])
+                < radius * radius) {
+                return true;
+            }
+        }
+        bool result = false;
+        cells_m.for_each_nearby(cells_m.index_of(pos.x(), pos.y()), [&](const size_t c) {
+            for (const size_t j : cells_m.cell(c)) {
+                const double sigma = radius + particles_m[j].radius();
+                if ((j != except) && (pos.offset(position_now(j)).mag_sqr() < sigma * sigma)) {
+                    result = true;
+                }
+            }
+        });
+        return result;
+    }
+
+    void EventWorld::write_particle_positions(std::ostream& outs) const {
+        outs << "X,Y,VX,VY" << std::endl;
+        for (const Particle& p : particles_m) {
+            outs << p.pos_x() << "," << p.pos_y() << ","
+                 << p.vel().x() << "," << p.vel().y()
+                 << std::endl;
+        }
+    }
+}
@@ -0,0 +1,88 @@
+#include "flow_boundaries.h"
+
+#include <cmath>
+#include <random>
+#include <stdexcept>
+
+namespace wingworks {
+    namespace {
+        // Particles a step through each unit of an edge, from a reservoir
+        // of unit density whose normal velocities, into the world, have
+        // mean u and standard deviation sigma.
+        double flux_per_length(const double u, const double sigma) {
+            const double a = u / sigma;
+            const double phi = ::exp(-0.5 * a * a) / ::sqrt(2.0 * M_PI);
+            const double cdf = 0.5 * ::erfc(-a / ::sqrt(2.0));
+            return sigma * phi + u * cdf;
+        }
+
+        // Inward normals and tangents of the edges.
+        const Vector inward[] = {Vector(1.0, 0.0), Vector(-1.0, 0.0), Vector(0.0, 1.0), Vector(0.0, -1.0)};
+        const Vector along[] = {Vector(0.0, 1.0), Vector(0.0, 1.0), Vector(1.0, 0.0), Vector(1.0, 0.0)};
+
+        // Normal speeds beyond this many standard deviations above the
+        // mean are too rare to matter to the rejection sampler's bound.
+        const double tail_sigmas = 6.0;
+    }
+
+    FlowBoundaries::FlowBoundaries(
+        const double width, const double height, const double density,
+        const Vector& wind, const double sigma, const SideWalls walls)
+    : width_m(width)
+    , height_m(height)
+    , wind_m(wind)
+    , sigma_m(sigma)
+    , walls_m(walls)
+    {
+        if ((density <= 0.0) || (sigma <= 0.0)) {
+            throw std::invalid_argument("Open boundaries need a positive density and thermal speed.");
+        }
+        const double lengths[] = {height, height, width, width};
+        for (size_t e = 0; e < NumEdges; ++e) {
+            const bool open = (e == Left) || ((e != Right) && (walls == SideWalls::Freestream));
+            rate_m[e] = open ? density * lengths[e] * flux_per_length(wind.dot(inward[e]), sigma) : 0.0;
+            remainder_m[e] = 0.0;
+        }
+    }
+
+    void FlowBoundaries::draw_arrivals(CounterRNG& gen, std::vector<Arrival>& arrivals) {
+        for (size_t e = 0; e < NumEdges; ++e) {
+            const double expected = rate_m[e] + remainder_m[e];
+            const size_t n = size_t(expected);
+            remainder_m[e] = expected - n;
+            for (size_t k = 0; k < n; ++k) {
+                draw_arrival(Edge(e), gen, arrivals);
+            }
+        }
+    }
+
+    void FlowBoundaries::draw_arrival(const Edge edge, CounterRNG& gen, std::vector<Arrival>& arrivals) const {
+        std::normal_distribution<> nrand(0.0, sigma_m);
+        std::uniform_real_distribution<> frand(0.0, 1.0);
+
+        // Normal speeds in proportion to v times the Maxwellian, by
+        // rejection from the Maxwellian's positive part.
+        const double u = wind_m.dot(inward[edge]);
+        const double bound = ((u > 0.0) ? u : 0.0) + tail_sigmas * sigma_m;
+        double vn = 0.0;
+        do {
+            vn = u + nrand(gen);
+        } while ((vn <= 0.0) || (frand(gen) * bound > vn));
+        const double vt = wind_m.dot(along[edge]) + nrand(gen);
+
+        // Where along the edge, and how far in: never on the edge
+        // itself, which for the right and top edges is outside.
+        const double length = (edge == Left || edge == Right) ? height_m : width_m;
+        const double s = frand(gen) * length;
+        const double depth = (1.0 - frand(gen)) * vn;
+        Vector pos;
+        switch (edge) {
+            case Left: pos = Vector(depth, s); break;
+            case Right: pos = Vector(width_m - depth, s); break;
+            case Bottom: pos = Vector(s, depth); break;
+            default: pos = Vector(s, height_m - depth); break;
+        }
+        const Vector vel(inward[edge].scaled(vn).adding(along[edge].scaled(vt)));
+        arrivals.push_back(Arrival {pos, vel});
+    }
+}
@@ -0,0 +1,205 @@
+#include "frame_channel.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <stdexcept>
+#include <system_error>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace wingworks {
+    namespace {
+        const uint64_t channel_magic = 0x4d52464b5257474eULL;  // "NGWRKFRM"
+        const uint32_t channel_version = 1;
+        const size_t cache_line_size = 64;
+
+        static_assert(std::atomic<uint64_t>::is_always_lock_free,
+                      "Sequence numbers are shared between processes.");
+
+        size_t round_up(const size_t bytes) {
+            return ((bytes + cache_line_size - 1) / cache_line_size) * cache_line_size;
+        }
+
+        size_t header_bytes() {
+            return round_up(sizeof(FrameChannelHeader));
+        }
+
+        char *slot_address(const FrameChannelHeader *header, const size_t slot) {
+            return (char *)header + header_bytes() + slot * header->slot_bytes;
+        }
+
+        float *slot_arrays(FrameSlotHeader *slot) {
+            return (float *)((char *)slot + round_up(sizeof(FrameSlotHeader)));
+        }
+
+        std::system_error channel_error(const std::string& what, const std::string& name) {
+            return std::system_error(errno, std::generic_category(), what + " " + name);
+        }
+    }
+
+    FramePublisher::FramePublisher(
+        const std::string& name, const size_t capacity, const size_t num_slots)
+    : name_m(name)
+    , mapped_bytes_m(0)
+    , header_m(nullptr)
+    , slot_m(nullptr)
+    , arrays_m(nullptr)
+    {
+        if (num_slots < 2) {
+            throw std::invalid_argument("A frame channel needs at least two slots.");
+        }
+        const size_t slot_bytes =
+            round_up(sizeof(FrameSlotHeader)) + round_up(4 * capacity * sizeof(float));
+        mapped_bytes_m = header_bytes() + num_slots * slot_bytes;
+
+        // Start afresh, so that no reader sees a stale channel's frames.
+        ::shm_unlink(name_m.c_str());
+        const int fd = ::shm_open(name_m.c_str(), O_CREAT | O_EXCL | O_RDWR, 0644);
+        if (fd < 0) {
+            throw channel_error("Cannot create frame channel", name_m);
+        }
+        if (::ftruncate(fd, mapped_bytes_m) != 0) {
+            ::close(fd);
+            ::shm_unlink(name_m.c_str());
+            throw channel_error("Cannot size frame channel", name_m);
+        }
+        void *mapping = ::mmap(nullptr, mapped_bytes_m, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        ::close(fd);
+        if (mapping == MAP_FAILED) {
+            ::shm_unlink(name_m.c_str());
+            throw channel_error("Cannot map frame channel", name_m);
+        }
+
+        // A new object is zero-filled: every sequence starts even.
+        header_m = (FrameChannelHeader *)mapping;
+        header_m->version = channel_version;
+        header_m->num_slots = num_slots;
+        header_m->capacity = capacity;
+        header_m->slot_bytes = slot_bytes;
+        header_m->frames_published.store(0, std::memory_order_relaxed);
+        // Readers check the magic number last.
+        std::atomic_thread_fence(std::memory_order_release);
+        header_m->magic = channel_magic;
+    }
+
+    FramePublisher::~FramePublisher() {
+        ::munmap(header_m, mapped_bytes_m);
+        ::shm_unlink(name_m.c_str());
+    }
+
+    // The sequence lock's write side.  The fence keeps the slot's new
+    // contents from becoming visible before its odd sequence number.
+    void FramePublisher::begin_frame(
+        const uint64_t step, const size_t num_particles, const Vector& force)
+    {
+        if (num_particles > capacity()) {
+            throw std::invalid_argument("Frame has more particles than the channel holds.");
+        }
+        const uint64_t frame = header_m->frames_published.load(std::memory_order_relaxed);
+        slot_m = (FrameSlotHeader *)slot_address(header_m, frame % header_m->num_slots);
+        arrays_m = slot_arrays(slot_m);
+
+        const uint64_t sequence = slot_m->sequence.load(std::memory_order_relaxed);
+        slot_m->sequence.store(sequence + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+
+        slot_m->frame = frame;
+        slot_m->step = step;
+        slot_m->num_particles = num_particles;
+        slot_m->force_x = force.x();
+        slot_m->force_y = force.y();
+    }
+
+    void FramePublisher::end_frame() {
+        const uint64_t sequence = slot_m->sequence.load(std::memory_order_relaxed);
+        slot_m->sequence.store(sequence + 1, std::memory_order_release);
+        header_m->frames_published.store(slot_m->frame + 1, std::memory_order_release);
+    }
+
+    FrameReader::FrameReader(const std::string& name)
+    : mapped_bytes_m(0)
+    , header_m(nullptr)
+    {
+        const int fd = ::shm_open(name.c_str(), O_RDONLY, 0);
+        if (fd < 0) {
+            throw channel_error("Cannot open frame channel", name);
+        }
+        struct stat st;
+        if ((::fstat(fd, &st) != 0) || (size_t(st.st_size) < header_bytes())) {
+            ::close(fd);
+            throw std::invalid_argument("Not a frame channel: " + name);
+        }
+        mapped_bytes_m = st.st_size;
+        void *mapping = ::mmap(nullptr, mapped_bytes_m, PROT_READ, MAP_SHARED, fd, 0);
+        ::close(fd);
+        if (mapping == MAP_FAILED) {
+            throw channel_error("Cannot map frame channel", name);
+        }
+        header_m = (const FrameChannelHeader *)mapping;
+
+        const uint64_t magic = header_m->magic;
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if ((magic != channel_magic) || (header_m->version != channel_version)
+            || (header_bytes() + header_m->num_slots * header_m->slot_bytes > mapped_bytes_m)) {
+            ::munmap((void *)header_m, mapped_bytes_m);
+            throw std::invalid_argument("Not a frame channel, or not a finished one: " + name);
+        }
+    }
+
+    FrameReader::~FrameReader() {
+        ::munmap((void *)header_m, mapped_bytes_m);
+    }
+
+    // The sequence lock's read side.  An odd sequence means the slot is
+    // being rewritten, so a newer frame is on its way: look again.
+    bool FrameReader::latest(View& view) const {
+        for (;;) {
+            const uint64_t published = header_m->frames_published.load(std::memory_order_acquire);
+            if (published == 0) {
+                return false;
+            }
+            FrameSlotHeader *slot =
+                (FrameSlotHeader *)slot_address(header_m, (published - 1) % header_m->num_slots);
+            const uint64_t sequence = slot->sequence.load(std::memory_order_acquire);
+            if (sequence % 2 != 0) {
+                continue;
+            }
+            const float *arrays = slot_arrays(slot);
+            const size_t capacity = header_m->capacity;
+            view.slot = slot;
+            view.sequence = sequence;
+            view.num_particles = std::min<uint64_t>(slot->num_particles, capacity);
+            view.pos_x = arrays;
+            view.pos_y = arrays + capacity;
+            view.vel_x = arrays + 2 * capacity;
+            view.vel_y = arrays + 3 * capacity;
+            return true;
+        }
+    }
+
+    bool FrameReader::intact(const View& view) const {
+        std::atomic_thread_fence(std::memory_order_acquire);
+        return view.slot->sequence.load(std::memory_order_relaxed) == view.sequence;
+    }
+
+    bool FrameReader::read_latest(Frame& result) const {
+        View view;
+        do {
+            if (!latest(view)) {
+                return false;
+            }
+            const size_t n = view.num_particles;
+            result.frame = view.slot->frame;
+            result.step = view.slot->step;
+            result.force.update(view.slot->force_x, view.slot->force_y);
+            result.pos_x.assign(view.pos_x, view.pos_x + n);
+            result.pos_y.assign(view.pos_y, view.pos_y + n);
+            result.vel_x.assign(view.vel_x, view.vel_x + n);
+            result.vel_y.assign(view.vel_y, view.vel_y + n);
+        } while (!intact(view));
+        return true;
+    }
+}
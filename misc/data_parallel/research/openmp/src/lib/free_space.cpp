@@ -0,0 +1,134 @@
+#include "free_space.h"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+namespace wingworks {
+    namespace {
+        double clip(const double y, const double height) {
+            return (y < 0.0) ? 0.0 : ((y > height) ? height : y);
+        }
+
+        // An edge crossing a column: where it is at the column's left and
+        // middle, and its slope.
+        struct Crossing {
+            double y_mid;
+            double y_left;
+            double slope;
+        };
+    }
+
+    FreeSpace::FreeSpace(const Polygon& obstacle, const double width, const double height)
+    : height_m(height)
+    {
+        if ((width <= 0.0) || (height <= 0.0)) {
+            throw std::invalid_argument("Free space needs a positive width and height.");
+        }
+        column_x_m.push_back(0.0);
+        column_x_m.push_back(width);
+        const std::vector<Point>& vertices(obstacle.vertices());
+        for (const Point& v : vertices) {
+            if ((0.0 < v.x()) && (v.x() < width)) {
+                column_x_m.push_back(v.x());
+            }
+        }
+        std::sort(column_x_m.begin(), column_x_m.end());
+        column_x_m.erase(std::unique(column_x_m.begin(), column_x_m.end()), column_x_m.end());
+
+        // No vertex lies inside a column, so an edge either spans a
+        // column or misses it.  Vertical edges bound columns, and cover
+        // nothing inside them.
+        const size_t num_columns = column_x_m.size() - 1;
+        const size_t num_vertices = vertices.size();
+        std::vector<Crossing> crossings;
+        double area = 0.0;
+        first_span_m.push_back(0);
+        for (size_t c = 0; c < num_columns; ++c) {
+            const double left = column_x_m[c];
+            const double right = column_x_m[c + 1];
+            const double mid = 0.5 * (left + right);
+            crossings.clear();
+            for (size_t i = 0; i < num_vertices; ++i) {
+                const Point& p0(vertices[i]);
+                const Point& pf(vertices[(i + 1) % num_vertices]);
+                if ((p0.x() != pf.x())
+                    && (std::min(p0.x(), pf.x()) <= left) && (std::max(p0.x(), pf.x()) >= right)) {
+                    const double slope = (pf.y() - p0.y()) / (pf.x() - p0.x());
+                    crossings.push_back(Crossing {
+                        p0.y() + slope * (mid - p0.x()), p0.y() + slope * (left - p0.x()), slope});
+                }
+            }
+            // Inside and outside alternate along the line, bottom to top.
+            std::sort(crossings.begin(), crossings.end(), [](const Crossing& c1, const Crossing& c2) {
+                return c1.y_mid < c2.y_mid;
+            });
+            for (size_t k = 0; k + 1 < crossings.size(); k += 2) {
+                spans_m.push_back(Span {
+                    crossings[k].y_left, crossings[k].slope,
+                    crossings[k + 1].y_left, crossings[k + 1].slope});
+            }
+            first_span_m.push_back(spans_m.size());
+
+            // The free height is linear across the column, unless the
+            // obstacle crosses the top or bottom of the world within it.
+            area += 0.5 * (free_height_in(c, 0.0) + free_height_in(c, right - left)) * (right - left);
+            cumulative_area_m.push_back(area);
+        }
+    }
+
+    size_t FreeSpace::column_of(const double x) const {
+        const size_t c = std::upper_bound(column_x_m.begin(), column_x_m.end(), x) - column_x_m.begin();
+        const size_t num_columns = column_x_m.size() - 1;
+        return (c == 0) ? 0 : ((c > num_columns) ? num_columns - 1 : c - 1);
+    }
+
+    double FreeSpace::free_height(const double x) const {
+        const size_t c = column_of(x);
+        return free_height_in(c, x - column_x_m[c]);
+    }
+
+    double FreeSpace::free_height_in(const size_t c, const double dx) const {
+        double result = height_m;
+        for (size_t k = first_span_m[c]; k < first_span_m[c + 1]; ++k) {
+            const Span& s(spans_m[k]);
+            result -= clip(s.y1 + s.slope1 * dx, height_m) - clip(s.y0 + s.slope0 * dx, height_m);
+        }
+        return result;
+    }
+
+    double FreeSpace::sample_y(const double x, const double u) const {
+        const size_t c = column_of(x);
+        const double dx = x - column_x_m[c];
+        double y = u * free_height_in(c, dx);
+        for (size_t k = first_span_m[c]; k < first_span_m[c + 1]; ++k) {
+            const Span& s(spans_m[k]);
+            const double y0 = clip(s.y0 + s.slope0 * dx, height_m);
+            if (y < y0) {
+                break;
+            }
+            y += clip(s.y1 + s.slope1 * dx, height_m) - y0;
+        }
+        return y;
+    }
+
+    Point FreeSpace::sample(const double u1, const double u2, const double u3) const {
+        const double total = cumulative_area_m.back();
+        size_t c = std::upper_bound(cumulative_area_m.begin(), cumulative_area_m.end(), u1 * total)
+                   - cumulative_area_m.begin();
+        c = std::min(c, cumulative_area_m.size() - 1);
+
+        // Invert the column's free area to the left of x, a quadratic:
+        // with free height h + b t at t past its left, the area is
+        // h t + b t^2 / 2.
+        const double left = column_x_m[c];
+        const double right = column_x_m[c + 1];
+        const double h = free_height_in(c, 0.0);
+        const double b = (free_height_in(c, right - left) - h) / (right - left);
+        const double area = u2 * (cumulative_area_m[c] - ((c > 0) ? cumulative_area_m[c - 1] : 0.0));
+        const double root = h + ::sqrt(std::max(0.0, h * h + 2.0 * b * area));
+        const double t = (root > 0.0) ? std::min(2.0 * area / root, right - left) : 0.0;
+        const double x = left + t;
+        return Point(x, sample_y(x, u3));
+    }
+}
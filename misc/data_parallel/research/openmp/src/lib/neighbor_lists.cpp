@@ -0,0 +1,119 @@
+#include "neighbor_lists.h"
+
+#include <algorithm>
+
+namespace wingworks {
+    using namespace std;
+
+    NeighborLists::NeighborLists(const size_t num_particles, const double skin, const Vector& drift)
+    : num_particles_m(num_particles)
+    , skin_m(skin)
+    , drift_m(drift)
+    , neighbors_m(new vector<size_t>[num_particles])
+    , built_pos_m(new Point[num_particles])
+    , is_stray_m(num_particles, 0)
+    , strays_m(num_particles)
+    , num_strays_m(0)
+    , steps_since_build_m(0)
+    , num_builds_m(0)
+    , is_built_m(false)
+    {}
+
+    NeighborLists::~NeighborLists() {
+        delete [] built_pos_m;
+        delete [] neighbors_m;
+    }
+
+    template <typename Real, typename Species>
+    bool NeighborLists::update(const BasicParticle<Real, Species> *particles) {
+        if (!is_built_m) {
+            return true;
+        }
+
+        #pragma omp single
+        {
+            num_strays_m = 0;
+        }
+
+        // Strays land in strays_m in no particular order, and are sorted
+        // afterwards.
+        const double half_skin = 0.5 * skin_m;
+        const double max_disp_sqr = half_skin * half_skin;
+        #pragma omp for schedule(runtime)
+        for (size_t i = 0; i < num_particles_m; ++i) {
+            if (!is_stray_m[i]) {
+                const double disp_sqr = built_pos_m[i].dist_sqr(undrifted(Point(particles[i].pos())));
+                if (disp_sqr > max_disp_sqr) {
+                    is_stray_m[i] = 1;
+                }
+            }
+            if (is_stray_m[i]) {
+                size_t k;
+                #pragma omp atomic capture
+                k = num_strays_m++;
+                strays_m[k] = i;
+            }
+        }
+        #pragma omp single
+        {
+            sort(strays_m.begin(), strays_m.begin() + num_strays_m);
+        }
+
+        return num_strays_m > max_stray_fraction * num_particles_m;
+    }
+
+    template <typename Real, typename Species>
+    void NeighborLists::build(
+        const WorldCells& cells, const BasicParticle<Real, Species> *particles,
+        const double interaction_range)
+    {
+        const double range = interaction_range + skin_m;
+        const double range_sqr = range * range;
+
+        #pragma omp for schedule(runtime)
+        for (size_t i_cell = 0; i_cell < cells.size(); ++i_cell) {
+            const Cell& cell = cells.cell(i_cell);
+            for (size_t k = 0; k < cell.size(); ++k) {
+                const size_t i = cell[k];
+                const Point pos(particles[i].pos());
+                vector<size_t>& neighbors(neighbors_m[i]);
+                neighbors.clear();
+                for (size_t m = k + 1; m < cell.size(); ++m) {
+                    if (pos.dist_sqr(Point(particles[cell[m]].pos())) <= range_sqr) {
+                        neighbors.push_back(cell[m]);
+                    }
+                }
+                cells.for_each_forward_neighbor(i_cell, [&](const size_t i_other) {
+                    for (const size_t j : cells.cell(i_other)) {
+                        if (pos.dist_sqr(Point(particles[j].pos())) <= range_sqr) {
+                            neighbors.push_back(j);
+                        }
+                    }
+                });
+                built_pos_m[i] = pos;
+                is_stray_m[i] = 0;
+            }
+        }
+
+        #pragma omp single
+        {
+            num_strays_m = 0;
+            steps_since_build_m = 0;
+            num_builds_m += 1;
+            is_built_m = true;
+        }
+    }
+
+    template bool NeighborLists::update(const BasicParticle<float> *);
+    template bool NeighborLists::update(const BasicParticle<double> *);
+    template bool NeighborLists::update(const BasicParticle<float, MixedSpecies> *);
+    template bool NeighborLists::update(const BasicParticle<double, MixedSpecies> *);
+    template bool NeighborLists::update(const BasicParticle<float, WeightedSpecies> *);
+    template bool NeighborLists::update(const BasicParticle<double, WeightedSpecies> *);
+    template void NeighborLists::build(const WorldCells&, const BasicParticle<float> *, const double);
+    template void NeighborLists::build(const WorldCells&, const BasicParticle<double> *, const double);
+    template void NeighborLists::build(const WorldCells&, const BasicParticle<float, MixedSpecies> *, const double);
+    template void NeighborLists::build(const WorldCells&, const BasicParticle<double, MixedSpecies> *, const double);
+    template void NeighborLists::build(const WorldCells&, const BasicParticle<float, WeightedSpecies> *, const double);
+    template void NeighborLists::build(const WorldCells&, const BasicParticle<double, WeightedSpecies> *, const double);
+}
@@ -0,0 +1,33 @@
+#include "page_alloc.h"
+
+#include <new>
+
+#include <sys/mman.h>
+
+namespace wingworks {
+    namespace {
+        const size_t cache_line_size = 64;
+        const size_t huge_page_size = 2 * 1024 * 1024;
+    }
+
+    void *allocate_pages(const size_t bytes, const bool huge_pages) {
+        const size_t alignment = huge_pages ? huge_page_size : cache_line_size;
+        const size_t padded = ((bytes + alignment - 1) / alignment) * alignment;
+        void *result = nullptr;
+        if (::posix_memalign(&result, alignment, (padded > 0) ? padded : alignment) != 0) {
+            throw std::bad_alloc();
+        }
+#if defined(MADV_HUGEPAGE)
+        if (huge_pages) {
+            // Only a hint: without transparent huge pages this fails,
+            // and ordinary pages do.
+            ::madvise(result, padded, MADV_HUGEPAGE);
+        }
+#endif
+        return result;
+    }
+
+    void free_pages(void *storage) {
+        ::free(storage);
+    }
+}
@@ -4,35 +4,56 @@
 #include <iostream>
 
 namespace wingworks {
-    void Particle::collide_with(Particle& other) {
-        Point v_new;
-        Point other_v_new;
+    template <typename Real, typename Species>
+    void BasicParticle<Real, Species>::collide_with(BasicParticle& other) {
+        BasicPoint<Real> v_new;
+        BasicPoint<Real> other_v_new;
         resolve_collision_with(other, v_new, other_v_new);
 
         vel_m = v_new;
         other.vel_m = other_v_new;
     }
 
-    void Particle::resolve_collision_with(
-        const Particle& other, Point& v_result, Point& other_v_result
+    template <typename Real, typename Species>
+    void BasicParticle<Real, Species>::collide_along(
+        BasicParticle& other, const BasicPoint<Real>& normal
+    ) {
+        const Real jr = calc_impulse_with(other, normal);
+        vel_m = vel_m.offset(normal.scaled(-jr / mass()));
+        other.vel_m = other.vel_m.offset(normal.scaled(jr / other.mass()));
+    }
+
+    template <typename Real, typename Species>
+    void BasicParticle<Real, Species>::resolve_collision_with(
+        const BasicParticle& other, BasicPoint<Real>& v_result, BasicPoint<Real>& other_v_result
     ) const {
-        Point n = pos_m.offset(other.pos_m).unit();
-        const double jr = calc_impulse_with(other, n);
-        v_result = vel_m.offset(n.scaled(-jr / mass_m));
-        other_v_result = other.vel_m.offset(n.scaled(jr / other.mass_m));
+        BasicPoint<Real> n = pos_m.offset(other.pos_m).unit();
+        const Real jr = calc_impulse_with(other, n);
+        v_result = vel_m.offset(n.scaled(-jr / mass()));
+        other_v_result = other.vel_m.offset(n.scaled(jr / other.mass()));
     }
 
-    double Particle::calc_impulse_with(const Particle& other, const Point& normal) const {
+    template <typename Real, typename Species>
+    Real BasicParticle<Real, Species>::calc_impulse_with(
+        const BasicParticle& other, const BasicPoint<Real>& normal
+    ) const {
         // e is the coefficient of restitution.  Set to 1 for
         // a perfectly elastic collision, I think.
-        const double e = 1.0;
+        const Real e = 1.0;
         // Relative collision velocity:
-        const Point vr = vel_m.offset(other.vel_m);
-        const double numer = -(1.0 + e) * vr.dot(normal);
+        const BasicPoint<Real> vr = vel_m.offset(other.vel_m);
+        const Real numer = -(1 + e) * vr.dot(normal);
 
         // Ignore rotational inertia
-        const double denom = (1.0 / mass_m) + (1.0 / other.mass_m);
+        const Real denom = (1 / mass()) + (1 / other.mass());
 
         return numer / denom;
     }
-}
\ No newline at end of file
+
+    template class BasicParticle<float>;
+    template class BasicParticle<double>;
+    template class BasicParticle<float, MixedSpecies>;
+    template class BasicParticle<double, MixedSpecies>;
+    template class BasicParticle<float, WeightedSpecies>;
+    template class BasicParticle<double, WeightedSpecies>;
+}
@@ -2,10 +2,11 @@
 #include <sstream>
 
 namespace wingworks {
-    Point Point::unit() const {
-        Point result;
+    template <typename Real>
+    BasicPoint<Real> BasicPoint<Real>::unit() const {
+        BasicPoint result;
 
-        const double m = magnitude();
+        const Real m = magnitude();
         if (m > 0) {
             result.x_m = x_m / m;
             result.y_m = y_m / m;
@@ -13,9 +14,13 @@ namespace wingworks {
         return result;
     }
 
-    std::string Point::to_str() const {
+    template <typename Real>
+    std::string BasicPoint<Real>::to_str() const {
         std::ostringstream outs;
         outs << "(" << x_m << ", " << y_m << ")";
         return outs.str();
     }
+
+    template class BasicPoint<float>;
+    template class BasicPoint<double>;
 }
@@ -5,6 +5,10 @@ namespace wingworks {
 
     Polygon::Polygon(const std::vector<Point>& vertices) {
         const size_t num_vertices = vertices.size();
+        // Start the box at a vertex, not at the origin.
+        if (num_vertices > 0) {
+            bbox_m.update(vertices[0].x(), vertices[0].y(), vertices[0].x(), vertices[0].y());
+        }
         for (size_t i = 0; i < num_vertices; i++) {
             Segment s(vertices[i], vertices[(i + 1) % num_vertices]);
             edges_m.push_back(s);
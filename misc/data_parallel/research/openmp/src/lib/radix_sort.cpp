@@ -0,0 +1,78 @@
+#include "radix_sort.h"
+
+#include <algorithm>
+
+#include <omp.h>
+
+#include "page_alloc.h"
+
+namespace wingworks {
+    using namespace std;
+
+    namespace {
+        const unsigned digit_bits = 8;
+        const size_t radix = size_t(1) << digit_bits;
+    }
+
+    RadixSorter::RadixSorter(const size_t capacity, const size_t max_threads, const bool huge_pages)
+    : capacity_m(capacity)
+    , max_threads_m(max_threads)
+    , scratch_m(allocate_array<uint64_t>(capacity, huge_pages))
+    , counts_m(max_threads * radix)
+    {}
+
+    RadixSorter::~RadixSorter() {
+        free_pages(scratch_m);
+    }
+
+    void RadixSorter::first_touch() {
+        #pragma omp for schedule(static)
+        for (size_t i = 0; i < capacity_m; ++i) {
+            scratch_m[i] = 0;
+        }
+    }
+
+    void RadixSorter::sort(uint64_t *keys, const size_t num_keys, const unsigned key_bits) {
+        const size_t num_threads = omp_get_num_threads();
+        const size_t thread = omp_get_thread_num();
+
+        // Stability needs each thread to scatter a contiguous chunk, in
+        // order, so this divides the keys itself rather than using omp for.
+        const size_t begin = thread * num_keys / num_threads;
+        const size_t end = (thread + 1) * num_keys / num_threads;
+        size_t *counts = &counts_m[thread * radix];
+
+        uint64_t *src = keys;
+        uint64_t *dest = scratch_m;
+        for (unsigned shift = 0; shift < key_bits; shift += digit_bits) {
+            fill(counts, counts + radix, 0);
+            for (size_t i = begin; i < end; ++i) {
+                counts[(src[i] >> shift) & (radix - 1)] += 1;
+            }
+            #pragma omp barrier
+            #pragma omp single
+            {
+                size_t offset = 0;
+                for (size_t digit = 0; digit < radix; ++digit) {
+                    for (size_t t = 0; t < num_threads; ++t) {
+                        const size_t count = counts_m[t * radix + digit];
+                        counts_m[t * radix + digit] = offset;
+                        offset += count;
+                    }
+                }
+            }
+            for (size_t i = begin; i < end; ++i) {
+                dest[counts[(src[i] >> shift) & (radix - 1)]++] = src[i];
+            }
+            #pragma omp barrier
+            swap(src, dest);
+        }
+
+        if (src != keys) {
+            #pragma omp for schedule(static)
+            for (size_t i = 0; i < num_keys; ++i) {
+                keys[i] = src[i];
+            }
+        }
+    }
+}
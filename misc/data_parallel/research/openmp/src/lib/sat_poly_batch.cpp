@@ -0,0 +1,410 @@
+#include "sat_poly_batch.h"
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
+
+#include "dot_min_max.h"
+
+// Build note: this file is compiled with -ffp-contract=off, so that no
+// multiply-add is fused here that isn't fused in sat_poly_collision.cpp.
+
+namespace wingworks {
+    using namespace std;
+
+    namespace {
+        struct Shape {
+            const double *vertex_x;
+            const double *vertex_y;
+            size_t num_vertices;
+            const double *axis_x;
+            const double *axis_y;
+            const double *axis_min;
+            const double *axis_max;
+            size_t num_axes;
+        };
+
+        // SATPolyCollision::overlap_distance, given the polygon's
+        // projected extrema on the axis (ax, ay).
+        double overlap_scalar(
+            const double px, const double py, const double radius,
+            const double ax, const double ay, const double poly_min, const double poly_max)
+        {
+            const double center_dot = (px * ax) + (py * ay);
+            const double dist0 = (center_dot + radius) - poly_min;
+            const double dist1 = poly_max - (center_dot - radius);
+            const double min_dist = (dist0 < dist1) ? dist0 : dist1;
+            return (min_dist <= 0) ? -1.0 : min_dist;
+        }
+
+        // The vector kernels return how far they got, leaving any
+        // remainder that doesn't fill a vector to the scalar kernel.
+
+        // SATPolyCollision::find_collision_normal for particles
+        // [begin, end).  Stores the smallest overlap (-1: no collision)
+        // and the unit axis it was found on.
+        void normals_scalar(
+            const Shape& shape, const double *x, const double *y, const double *radius,
+            double *overlap, double *normal_x, double *normal_y,
+            const size_t begin, const size_t end)
+        {
+            for (size_t k = begin; k < end; ++k) {
+                overlap[k] = -1.0;
+                normal_x[k] = 0.0;
+                normal_y[k] = 0.0;
+
+                double best = -1.0;
+                double best_x = 0.0;
+                double best_y = 0.0;
+                bool separated = false;
+                for (size_t a = 0; a < shape.num_axes; ++a) {
+                    const double curr = overlap_scalar(
+                        x[k], y[k], radius[k], shape.axis_x[a], shape.axis_y[a],
+                        shape.axis_min[a], shape.axis_max[a]);
+                    if (curr < 0) {
+                        separated = true;
+                        break;
+                    }
+                    if ((best < 0.0) || (curr < best)) {
+                        best = curr;
+                        best_x = shape.axis_x[a];
+                        best_y = shape.axis_y[a];
+                    }
+                }
+                if (separated) {
+                    continue;
+                }
+
+                // The axis through the nearest vertex.
+                size_t nearest = 0;
+                double min_dist = 0.0;
+                for (size_t i = 0; i < shape.num_vertices; ++i) {
+                    const double dx = shape.vertex_x[i] - x[k];
+                    const double dy = shape.vertex_y[i] - y[k];
+                    const double dsqr = (dx * dx) + (dy * dy);
+                    if ((i == 0) || (dsqr < min_dist)) {
+                        nearest = i;
+                        min_dist = dsqr;
+                    }
+                }
+                const double ax = -(shape.vertex_y[nearest] - y[k]);
+                const double ay = shape.vertex_x[nearest] - x[k];
+                double poly_min = 0.0;
+                double poly_max = 0.0;
+                for (size_t i = 0; i < shape.num_vertices; ++i) {
+                    const double curr_dot = (shape.vertex_x[i] * ax) + (shape.vertex_y[i] * ay);
+                    if (i == 0) {
+                        poly_min = curr_dot;
+                        poly_max = curr_dot;
+                    } else {
+                        poly_min = (poly_min < curr_dot) ? poly_min : curr_dot;
+                        poly_max = (poly_max > curr_dot) ? poly_max : curr_dot;
+                    }
+                }
+                const double curr = overlap_scalar(x[k], y[k], radius[k], ax, ay, poly_min, poly_max);
+                if (curr < 0.0) {
+                    continue;
+                }
+                if ((best < 0.0) || (curr < best)) {
+                    best = curr;
+                    best_x = ax;
+                    best_y = ay;
+                }
+
+                if (best > 0.0) {
+                    overlap[k] = best;
+                    normal_x[k] = best_x;
+                    normal_y[k] = best_y;
+                }
+            }
+        }
+
+#if defined(__x86_64__)
+        // overlap_scalar before mapping separation to -1.
+        __attribute__((target("avx2")))
+        inline __m256d min_dist_avx2(
+            const __m256d px, const __m256d py, const __m256d radius,
+            const __m256d ax, const __m256d ay, const __m256d poly_min, const __m256d poly_max)
+        {
+            const __m256d center_dot = _mm256_add_pd(_mm256_mul_pd(px, ax), _mm256_mul_pd(py, ay));
+            const __m256d dist0 = _mm256_sub_pd(_mm256_add_pd(center_dot, radius), poly_min);
+            const __m256d dist1 = _mm256_sub_pd(poly_max, _mm256_sub_pd(center_dot, radius));
+            return _mm256_min_pd(dist0, dist1);
+        }
+
+        // One axis's step of find_collision_normal: drop lanes the axis
+        // separates ("not <= 0" rather than "> 0" treats NaN as the
+        // scalar code does), and keep the smallest overlap of the rest.
+        __attribute__((target("avx2")))
+        inline void consider_avx2(
+            const __m256d curr, const __m256d ax, const __m256d ay,
+            __m256d& alive, __m256d& best, __m256d& best_x, __m256d& best_y)
+        {
+            const __m256d zero = _mm256_setzero_pd();
+            alive = _mm256_and_pd(alive, _mm256_cmp_pd(curr, zero, _CMP_NLE_UQ));
+            const __m256d better = _mm256_and_pd(alive, _mm256_or_pd(
+                _mm256_cmp_pd(best, zero, _CMP_LT_OQ),
+                _mm256_cmp_pd(curr, best, _CMP_LT_OQ)));
+            best = _mm256_blendv_pd(best, curr, better);
+            best_x = _mm256_blendv_pd(best_x, ax, better);
+            best_y = _mm256_blendv_pd(best_y, ay, better);
+        }
+
+        __attribute__((target("avx2")))
+        size_t normals_avx2(
+            const Shape& shape, const double *x, const double *y, const double *radius,
+            double *overlap, double *normal_x, double *normal_y, const size_t end)
+        {
+            const __m256d zero = _mm256_setzero_pd();
+            const __m256d minus_one = _mm256_set1_pd(-1.0);
+            const __m256d sign = _mm256_set1_pd(-0.0);
+            size_t k = 0;
+            for (; k + 4 <= end; k += 4) {
+                const __m256d px = _mm256_loadu_pd(x + k);
+                const __m256d py = _mm256_loadu_pd(y + k);
+                const __m256d pr = _mm256_loadu_pd(radius + k);
+
+                // Lanes not yet separated from the polygon.
+                __m256d alive = _mm256_castsi256_pd(_mm256_set1_epi64x(-1));
+                __m256d best = minus_one;
+                __m256d best_x = zero;
+                __m256d best_y = zero;
+
+                for (size_t a = 0; (a < shape.num_axes) && _mm256_movemask_pd(alive); ++a) {
+                    const __m256d ax = _mm256_set1_pd(shape.axis_x[a]);
+                    const __m256d ay = _mm256_set1_pd(shape.axis_y[a]);
+                    consider_avx2(min_dist_avx2(
+                        px, py, pr, ax, ay,
+                        _mm256_set1_pd(shape.axis_min[a]), _mm256_set1_pd(shape.axis_max[a])),
+                        ax, ay, alive, best, best_x, best_y);
+                }
+
+                if (_mm256_movemask_pd(alive)) {
+                    __m256d near_x = _mm256_set1_pd(shape.vertex_x[0]);
+                    __m256d near_y = _mm256_set1_pd(shape.vertex_y[0]);
+                    __m256d dx = _mm256_sub_pd(near_x, px);
+                    __m256d dy = _mm256_sub_pd(near_y, py);
+                    __m256d min_dist = _mm256_add_pd(_mm256_mul_pd(dx, dx), _mm256_mul_pd(dy, dy));
+                    for (size_t i = 1; i < shape.num_vertices; ++i) {
+                        const __m256d vx = _mm256_set1_pd(shape.vertex_x[i]);
+                        const __m256d vy = _mm256_set1_pd(shape.vertex_y[i]);
+                        dx = _mm256_sub_pd(vx, px);
+                        dy = _mm256_sub_pd(vy, py);
+                        const __m256d dsqr = _mm256_add_pd(_mm256_mul_pd(dx, dx), _mm256_mul_pd(dy, dy));
+                        const __m256d closer = _mm256_cmp_pd(dsqr, min_dist, _CMP_LT_OQ);
+                        min_dist = _mm256_blendv_pd(min_dist, dsqr, closer);
+                        near_x = _mm256_blendv_pd(near_x, vx, closer);
+                        near_y = _mm256_blendv_pd(near_y, vy, closer);
+                    }
+                    const __m256d ax = _mm256_xor_pd(_mm256_sub_pd(near_y, py), sign);
+                    const __m256d ay = _mm256_sub_pd(near_x, px);
+
+                    __m256d poly_min = _mm256_add_pd(
+                        _mm256_mul_pd(_mm256_set1_pd(shape.vertex_x[0]), ax),
+                        _mm256_mul_pd(_mm256_set1_pd(shape.vertex_y[0]), ay));
+                    __m256d poly_max = poly_min;
+                    for (size_t i = 1; i < shape.num_vertices; ++i) {
+                        const __m256d curr_dot = _mm256_add_pd(
+                            _mm256_mul_pd(_mm256_set1_pd(shape.vertex_x[i]), ax),
+                            _mm256_mul_pd(_mm256_set1_pd(shape.vertex_y[i]), ay));
+                        poly_min = _mm256_min_pd(poly_min, curr_dot);
+                        poly_max = _mm256_max_pd(poly_max, curr_dot);
+                    }
+                    consider_avx2(
+                        min_dist_avx2(px, py, pr, ax, ay, poly_min, poly_max),
+                        ax, ay, alive, best, best_x, best_y);
+                }
+
+                const __m256d collides = _mm256_and_pd(alive, _mm256_cmp_pd(best, zero, _CMP_GT_OQ));
+                _mm256_storeu_pd(overlap + k, _mm256_blendv_pd(minus_one, best, collides));
+                _mm256_storeu_pd(normal_x + k, _mm256_and_pd(collides, best_x));
+                _mm256_storeu_pd(normal_y + k, _mm256_and_pd(collides, best_y));
+            }
+            return k;
+        }
+
+        // GCC's _mm512_min_pd/_mm512_max_pd pass an undefined vector as
+        // the unused merge source, which -Wmaybe-uninitialized flags.
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+        __attribute__((target("avx512f")))
+        inline __m512d min_dist_avx512(
+            const __m512d px, const __m512d py, const __m512d radius,
+            const __m512d ax, const __m512d ay, const __m512d poly_min, const __m512d poly_max)
+        {
+            const __m512d center_dot = _mm512_add_pd(_mm512_mul_pd(px, ax), _mm512_mul_pd(py, ay));
+            const __m512d dist0 = _mm512_sub_pd(_mm512_add_pd(center_dot, radius), poly_min);
+            const __m512d dist1 = _mm512_sub_pd(poly_max, _mm512_sub_pd(center_dot, radius));
+            return _mm512_min_pd(dist0, dist1);
+        }
+
+        __attribute__((target("avx512f")))
+        inline void consider_avx512(
+            const __m512d curr, const __m512d ax, const __m512d ay,
+            __mmask8& alive, __m512d& best, __m512d& best_x, __m512d& best_y)
+        {
+            const __m512d zero = _mm512_setzero_pd();
+            alive = _mm512_mask_cmp_pd_mask(alive, curr, zero, _CMP_NLE_UQ);
+            const __mmask8 better = alive & (
+                _mm512_cmp_pd_mask(best, zero, _CMP_LT_OQ) |
+                _mm512_cmp_pd_mask(curr, best, _CMP_LT_OQ));
+            best = _mm512_mask_blend_pd(better, best, curr);
+            best_x = _mm512_mask_blend_pd(better, best_x, ax);
+            best_y = _mm512_mask_blend_pd(better, best_y, ay);
+        }
+
+        __attribute__((target("avx512f")))
+        size_t normals_avx512(
+            const Shape& shape, const double *x, const double *y, const double *radius,
+            double *overlap, double *normal_x, double *normal_y, const size_t end)
+        {
+            const __m512d zero = _mm512_setzero_pd();
+            const __m512d minus_one = _mm512_set1_pd(-1.0);
+            const __m512i sign = _mm512_castpd_si512(_mm512_set1_pd(-0.0));
+            size_t k = 0;
+            for (; k + 8 <= end; k += 8) {
+                const __m512d px = _mm512_loadu_pd(x + k);
+                const __m512d py = _mm512_loadu_pd(y + k);
+                const __m512d pr = _mm512_loadu_pd(radius + k);
+
+                __mmask8 alive = 0xff;
+                __m512d best = minus_one;
+                __m512d best_x = zero;
+                __m512d best_y = zero;
+
+                for (size_t a = 0; (a < shape.num_axes) && alive; ++a) {
+                    const __m512d ax = _mm512_set1_pd(shape.axis_x[a]);
+                    const __m512d ay = _mm512_set1_pd(shape.axis_y[a]);
+                    consider_avx512(min_dist_avx512(
+                        px, py, pr, ax, ay,
+                        _mm512_set1_pd(shape.axis_min[a]), _mm512_set1_pd(shape.axis_max[a])),
+                        ax, ay, alive, best, best_x, best_y);
+                }
+
+                if (alive) {
+                    __m512d near_x = _mm512_set1_pd(shape.vertex_x[0]);
+                    __m512d near_y = _mm512_set1_pd(shape.vertex_y[0]);
+                    __m512d dx = _mm512_sub_pd(near_x, px);
+                    __m512d dy = _mm512_sub_pd(near_y, py);
+                    __m512d min_dist = _mm512_add_pd(_mm512_mul_pd(dx, dx), _mm512_mul_pd(dy, dy));
+                    for (size_t i = 1; i < shape.num_vertices; ++i) {
+                        const __m512d vx = _mm512_set1_pd(shape.vertex_x[i]);
+                        const __m512d vy = _mm512_set1_pd(shape.vertex_y[i]);
+                        dx = _mm512_sub_pd(vx, px);
+                        dy = _mm512_sub_pd(vy, py);
+                        const __m512d dsqr = _mm512_add_pd(_mm512_mul_pd(dx, dx), _mm512_mul_pd(dy, dy));
+                        const __mmask8 closer = _mm512_cmp_pd_mask(dsqr, min_dist, _CMP_LT_OQ);
+                        min_dist = _mm512_mask_blend_pd(closer, min_dist, dsqr);
+                        near_x = _mm512_mask_blend_pd(closer, near_x, vx);
+                        near_y = _mm512_mask_blend_pd(closer, near_y, vy);
+                    }
+                    const __m512d ax = _mm512_castsi512_pd(_mm512_xor_si512(
+                        _mm512_castpd_si512(_mm512_sub_pd(near_y, py)), sign));
+                    const __m512d ay = _mm512_sub_pd(near_x, px);
+
+                    __m512d poly_min = _mm512_add_pd(
+                        _mm512_mul_pd(_mm512_set1_pd(shape.vertex_x[0]), ax),
+                        _mm512_mul_pd(_mm512_set1_pd(shape.vertex_y[0]), ay));
+                    __m512d poly_max = poly_min;
+                    for (size_t i = 1; i < shape.num_vertices; ++i) {
+                        const __m512d curr_dot = _mm512_add_pd(
+                            _mm512_mul_pd(_mm512_set1_pd(shape.vertex_x[i]), ax),
+                            _mm512_mul_pd(_mm512_set1_pd(shape.vertex_y[i]), ay));
+                        poly_min = _mm512_min_pd(poly_min, curr_dot);
+                        poly_max = _mm512_max_pd(poly_max, curr_dot);
+                    }
+                    consider_avx512(
+                        min_dist_avx512(px, py, pr, ax, ay, poly_min, poly_max),
+                        ax, ay, alive, best, best_x, best_y);
+                }
+
+                const __mmask8 collides = _mm512_mask_cmp_pd_mask(alive, best, zero, _CMP_GT_OQ);
+                _mm512_storeu_pd(overlap + k, _mm512_mask_blend_pd(collides, minus_one, best));
+                _mm512_storeu_pd(normal_x + k, _mm512_maskz_mov_pd(collides, best_x));
+                _mm512_storeu_pd(normal_y + k, _mm512_maskz_mov_pd(collides, best_y));
+            }
+            return k;
+        }
+#pragma GCC diagnostic pop
+#endif
+    }
+
+    SATPolyBatch::SATPolyBatch(const Polygon& poly, const SimdLevel level)
+    : level_m(level)
+    {
+        for (const Point& vertex : poly.vertices()) {
+            vertex_x_m.push_back(vertex.x());
+            vertex_y_m.push_back(vertex.y());
+        }
+        for (const Vector& normal : poly.edge_normals()) {
+            const DotMinMax extrema(poly.projected_extrema(normal));
+            axis_x_m.push_back(normal.x());
+            axis_y_m.push_back(normal.y());
+            axis_min_m.push_back(extrema.min_m);
+            axis_max_m.push_back(extrema.max_m);
+        }
+    }
+
+    template <typename Real, typename Species>
+    size_t SATPolyBatch::find_collision_normals(
+        const BasicParticle<Real, Species> *particles, const size_t *indices, const size_t n)
+    {
+        for (vector<double>& row : stage_m) {
+            if (row.size() < n) {
+                row.resize(n);
+            }
+        }
+        hits_m.reserve(n);
+        normals_m.reserve(n);
+        double *row[NUM_ROWS];
+        for (size_t r = 0; r < NUM_ROWS; ++r) {
+            row[r] = stage_m[r].data();
+        }
+        for (size_t k = 0; k < n; ++k) {
+            const BasicParticle<Real, Species>& particle(particles[indices[k]]);
+            row[X][k] = particle.pos_x();
+            row[Y][k] = particle.pos_y();
+            row[RADIUS][k] = particle.radius();
+        }
+
+        const Shape shape {
+            vertex_x_m.data(), vertex_y_m.data(), vertex_x_m.size(),
+            axis_x_m.data(), axis_y_m.data(), axis_min_m.data(), axis_max_m.data(), axis_x_m.size()
+        };
+        size_t done = 0;
+#if defined(__x86_64__)
+        if (level_m == SimdLevel::AVX512) {
+            done = normals_avx512(
+                shape, row[X], row[Y], row[RADIUS], row[OVERLAP], row[NORMAL_X], row[NORMAL_Y], n);
+        } else if (level_m == SimdLevel::AVX2) {
+            done = normals_avx2(
+                shape, row[X], row[Y], row[RADIUS], row[OVERLAP], row[NORMAL_X], row[NORMAL_Y], n);
+        }
+#endif
+        normals_scalar(
+            shape, row[X], row[Y], row[RADIUS], row[OVERLAP], row[NORMAL_X], row[NORMAL_Y], done, n);
+
+        hits_m.clear();
+        normals_m.clear();
+        for (size_t k = 0; k < n; ++k) {
+            if (row[OVERLAP][k] > 0.0) {
+                hits_m.push_back(k);
+                normals_m.push_back(Vector(row[NORMAL_X][k], row[NORMAL_Y][k]).scaled(row[OVERLAP][k]));
+            }
+        }
+        return hits_m.size();
+    }
+
+    template size_t SATPolyBatch::find_collision_normals(
+        const BasicParticle<float> *, const size_t *, const size_t);
+    template size_t SATPolyBatch::find_collision_normals(
+        const BasicParticle<double> *, const size_t *, const size_t);
+    template size_t SATPolyBatch::find_collision_normals(
+        const BasicParticle<float, MixedSpecies> *, const size_t *, const size_t);
+    template size_t SATPolyBatch::find_collision_normals(
+        const BasicParticle<double, MixedSpecies> *, const size_t *, const size_t);
+    template size_t SATPolyBatch::find_collision_normals(
+        const BasicParticle<float, WeightedSpecies> *, const size_t *, const size_t);
+    template size_t SATPolyBatch::find_collision_normals(
+        const BasicParticle<double, WeightedSpecies> *, const size_t *, const size_t);
+}
@@ -0,0 +1,15 @@
+#include "simd_level.h"
+
+namespace wingworks {
+    SimdLevel best_simd_level() {
+#if defined(__x86_64__)
+        if (__builtin_cpu_supports("avx512f")) {
+            return SimdLevel::AVX512;
+        }
+        if (__builtin_cpu_supports("avx2")) {
+            return SimdLevel::AVX2;
+        }
+#endif
+        return SimdLevel::Scalar;
+    }
+}
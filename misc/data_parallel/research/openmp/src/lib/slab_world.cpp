@@ -0,0 +1,456 @@
+#include "slab_world.h"
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <stdexcept>
+#include <type_traits>
+
+#include <omp.h>
+
+#include "airfoil_collision.h"
+#include "world.h"
+#include "rng.h"
+
+namespace wingworks {
+
+    template <typename Real, typename Species>
+    BasicSlabWorld<Real, Species>::BasicSlabWorld(
+        MPI_Comm comm,
+        const Airfoil& foil,
+        const double width, const double height,
+        const double max_particle_speed, const Vector& wind_vel,
+        const WorldOptions& options
+    )
+    : comm_m(MPI_COMM_NULL)
+    , rank_m(0)
+    , num_ranks_m(1)
+    , airfoil_m(foil)
+    , world_width_m(width)
+    , world_height_m(height)
+    , free_space_m(foil.shape(), width, height)
+    , num_particles_m(BasicWorld<Real, Species>::particle_count(width, height))
+    , max_speed_m(max_particle_speed)
+    , wind_vel_m(wind_vel)
+    , seed_m(options.seed)
+    , cell_extent_m(options.cell_extent)
+    , interaction_range_m(2.0 * Species::max_radius())
+    , num_threads_m(
+        (options.num_threads > 0) ? options.num_threads : omp_get_max_threads())
+    , step_count_m(0)
+    , near_airfoil_m(false)
+    , num_owned_m(0)
+    , cells_m(nullptr)
+    , cells_capacity_m(0)
+    {
+        static_assert(std::is_trivially_copyable<Particle>::value,
+                      "Particles are sent between ranks as bytes.");
+        if (cell_extent_m <= 0.0) {
+            throw std::invalid_argument("Cell extent must be positive.");
+        }
+        MPI_Comm_dup(comm, &comm_m);
+        MPI_Comm_rank(comm_m, &rank_m);
+        MPI_Comm_size(comm_m, &num_ranks_m);
+
+        // The same grid a World's WorldCells would have.
+        num_horiz_m = ::ceil(width / cell_extent_m);
+        num_vert_m = ::ceil(height / cell_extent_m);
+        reach_m = ::ceil(interaction_range_m / cell_extent_m);
+        halo_rows_m = reach_m * (reach_m + 1);
+        if (num_vert_m < size_t(num_ranks_m)) {
+            MPI_Comm_free(&comm_m);
+            throw std::invalid_argument("A SlabWorld needs at least one row of cells per rank.");
+        }
+        for (int r = 0; r <= num_ranks_m; ++r) {
+            first_row_m.push_back((num_vert_m * r) / num_ranks_m);
+        }
+
+        // Particles touch the foil only if their centers are within a
+        // radius of it.  The first and last slabs reach on past the
+        // world's edges.
+        const BBox& foil_box(airfoil_m.shape().bbox());
+        const double margin = 2.0 * Species::max_radius();
+        const double slab_ymin = (rank_m == 0) ? -HUGE_VAL : first_row() * cell_extent_m;
+        const double slab_ymax =
+            (rank_m + 1 == num_ranks_m) ? HUGE_VAL : end_row() * cell_extent_m;
+        near_airfoil_m = (foil_box.ymin() - margin < slab_ymax)
+            && (foil_box.ymin() + foil_box.height() + margin > slab_ymin);
+
+        for (size_t i = 0; i < num_threads_m; ++i) {
+            foil_batches_m.push_back(new SATPolyBatch(airfoil_m.shape()));
+        }
+        outgoing_m.resize(num_ranks_m);
+        randomize();
+    }
+
+    template <typename Real, typename Species>
+    BasicSlabWorld<Real, Species>::~BasicSlabWorld() {
+        for (SATPolyBatch *batch : foil_batches_m) {
+            delete batch;
+        }
+        delete cells_m;
+        MPI_Comm_free(&comm_m);
+    }
+
+    // A rank's grid starts on a multiple of reach + 1 rows, so that its
+    // cells take their colors in the same order as the World's.
+    template <typename Real, typename Species>
+    size_t BasicSlabWorld<Real, Species>::grid_begin(const size_t rank) const {
+        const size_t first = first_row_m[rank];
+        const size_t begin = (first > halo_rows_m) ? first - halo_rows_m : 0;
+        return begin - begin % (reach_m + 1);
+    }
+
+    template <typename Real, typename Species>
+    size_t BasicSlabWorld<Real, Species>::grid_end(const size_t rank) const {
+        return std::min(num_vert_m, first_row_m[rank + 1] + halo_rows_m);
+    }
+
+    template <typename Real, typename Species>
+    size_t BasicSlabWorld<Real, Species>::row_of(const double y) const {
+        const double row = ::floor(y / cell_extent_m);
+        if (row < 0.0) {
+            return 0;
+        }
+        return (row < num_vert_m) ? size_t(row) : num_vert_m - 1;
+    }
+
+    template <typename Real, typename Species>
+    size_t BasicSlabWorld<Real, Species>::owner_of_row(const size_t row) const {
+        return std::upper_bound(first_row_m.begin(), first_row_m.end(), row)
+            - first_row_m.begin() - 1;
+    }
+
+    // Every rank draws the World's whole initial state, in the World's
+    // order, and keeps its own share.
+    template <typename Real, typename Species>
+    void BasicSlabWorld<Real, Species>::randomize() {
+        std::mt19937 gen(seed_m);
+        std::uniform_real_distribution<> urand(0.0, 1.0);
+
+        std::uniform_real_distribution<> vrand(-max_speed_m, max_speed_m);
+
+        for (size_t i = 0; i < num_particles_m; ++i) {
+            const double u1 = urand(gen);
+            const double u2 = urand(gen);
+            const double u3 = urand(gen);
+            const Point pos(free_space_m.sample(u1, u2, u3));
+            Particle p;
+            p.move_to(pos.x(), pos.y());
+
+            const Vector vel(
+                wind_vel_m
+                .adding(Vector(vrand(gen), vrand(gen))
+                .unit().scaled(max_speed_m)));
+            p.set_vel(vel.x(), vel.y());
+            p.draw_species(gen);
+            if (owner_of_row(row_of(p.pos_y())) == size_t(rank_m)) {
+                particles_m.push_back(p);
+                ids_m.push_back(i);
+            }
+        }
+        num_owned_m = particles_m.size();
+    }
+
+    // Just as World::recycle.
+    template <typename Real, typename Species>
+    void BasicSlabWorld<Real, Species>::recycle(Particle& p, const size_t step, const uint64_t id) {
+        CounterRNG gen(seed_m, step, id);
+        std::uniform_real_distribution<> urand(0.0, 1.0);
+        std::uniform_real_distribution<> vrand(-max_speed_m, max_speed_m);
+
+        double x = p.pos_x();
+        while (x < 0) {
+            x += world_width_m;
+        }
+        while (x > world_width_m) {
+            x -= world_width_m;
+        }
+        const double y = free_space_m.sample_y(x, urand(gen));
+        const double vx = vrand(gen) + wind_vel_m.x();
+        const double vy = vrand(gen) + wind_vel_m.y();
+        p.move_to(x, y);
+        p.set_vel(vx, vy);
+    }
+
+    template <typename Real, typename Species>
+    void BasicSlabWorld<Real, Species>::step_many(const size_t num_steps) {
+        for (size_t i = 0; i < num_steps; ++i) {
+            gather_ghosts();
+            assign_to_cells();
+            collide_particles();
+            collide_with_airfoil();
+            integrate();
+            migrate();
+            ++step_count_m;
+        }
+    }
+
+    // Counts go first, so that every rank can size its receive buffer.
+    // Messages are counted in bytes, as ints, which limits a rank to
+    // receiving 2 GiB a step.
+    template <typename Real, typename Species>
+    void BasicSlabWorld<Real, Species>::exchange() {
+        std::vector<int> send_counts(num_ranks_m), send_displs(num_ranks_m);
+        std::vector<int> recv_counts(num_ranks_m), recv_displs(num_ranks_m);
+        std::vector<Entry> send_buf;
+        for (int r = 0; r < num_ranks_m; ++r) {
+            send_displs[r] = send_buf.size() * sizeof(Entry);
+            send_counts[r] = outgoing_m[r].size() * sizeof(Entry);
+            send_buf.insert(send_buf.end(), outgoing_m[r].begin(), outgoing_m[r].end());
+            outgoing_m[r].clear();
+        }
+        MPI_Alltoall(send_counts.data(), 1, MPI_INT, recv_counts.data(), 1, MPI_INT, comm_m);
+
+        size_t recv_bytes = 0;
+        for (int r = 0; r < num_ranks_m; ++r) {
+            recv_displs[r] = recv_bytes;
+            recv_bytes += recv_counts[r];
+        }
+        incoming_m.resize(recv_bytes / sizeof(Entry));
+        MPI_Alltoallv(
+            send_buf.data(), send_counts.data(), send_displs.data(), MPI_BYTE,
+            incoming_m.data(), recv_counts.data(), recv_displs.data(), MPI_BYTE, comm_m);
+    }
+
+    // Grids overlap only near slab boundaries, so a particle's row is
+    // compared with the grids of ranks further and further away until
+    // one no longer reaches it.
+    template <typename Real, typename Species>
+    void BasicSlabWorld<Real, Species>::gather_ghosts() {
+        for (size_t i = 0; i < particles_m.size(); ++i) {
+            const size_t row = row_of(particles_m[i].pos_y());
+            const Entry entry {ids_m[i], particles_m[i]};
+            for (int r = rank_m - 1; (r >= 0) && (grid_end(r) > row); --r) {
+                outgoing_m[r].push_back(entry);
+            }
+            for (int r = rank_m + 1; (r < num_ranks_m) && (grid_begin(r) <= row); ++r) {
+                outgoing_m[r].push_back(entry);
+            }
+        }
+        exchange();
+        num_owned_m = particles_m.size();
+        for (const Entry& entry : incoming_m) {
+            particles_m.push_back(entry.particle);
+            ids_m.push_back(entry.id);
+        }
+    }
+
+    template <typename Real, typename Species>
+    void BasicSlabWorld<Real, Species>::assign_to_cells() {
+        const size_t num_present = particles_m.size();
+        if (!cells_m || (num_present > cells_capacity_m)) {
+            delete cells_m;
+            cells_m = nullptr;
+            // Room to grow, so that cells are rarely replaced.
+            cells_capacity_m = 2 * num_present;
+            const size_t num_rows = grid_end(rank_m) - grid_begin(rank_m);
+            // Half a row short, so that rounding can't add a row.
+            cells_m = new WorldCells(
+                world_width_m, (num_rows - 0.5) * cell_extent_m,
+                cell_extent_m, interaction_range_m, cells_capacity_m);
+        }
+        cells_m->clear();
+
+        const size_t row0 = grid_begin(rank_m);
+        for (size_t i = 0; i < num_present; ++i) {
+            const Particle& p(particles_m[i]);
+            // Row 0 of the grid, in the particle's column.
+            const size_t col = cells_m->index_of(p.pos_x(), 0.0);
+            cells_m->add_to((row_of(p.pos_y()) - row0) * num_horiz_m + col, i);
+        }
+        // A World fills cells in ID order.
+        const auto by_id = [this](const size_t i1, const size_t i2) {
+            return ids_m[i1] < ids_m[i2];
+        };
+        const size_t num_cells = cells_m->size();
+        #pragma omp parallel for num_threads(num_threads_m) schedule(static)
+        for (size_t i = 0; i < num_cells; ++i) {
+            cells_m->sort_cell(i, by_id);
+        }
+    }
+
+    // Just as World::collide_cell_particles.
+    template <typename Real, typename Species>
+    void BasicSlabWorld<Real, Species>::collide_cell_particles(const size_t i_cell) {
+        const WorldCells& cells(*cells_m);
+        const Cell& cell = cells.cell(i_cell);
+        const size_t num_particles = cell.size();
+        for (size_t i = 0; i < num_particles; ++i) {
+            Particle& p_i = particles_m[cell[i]];
+            for (size_t j = i + 1; j < num_particles; ++j) {
+                Particle& p_j = particles_m[cell[j]];
+                if (p_i.is_colliding_with(p_j)) {
+                    p_i.collide_with(p_j);
+                }
+            }
+        }
+
+        cells.for_each_forward_neighbor(i_cell, [&](const size_t i_other) {
+            const Cell& other = cells.cell(i_other);
+            for (size_t i = 0; i < num_particles; ++i) {
+                Particle& p_i = particles_m[cell[i]];
+                for (const size_t j : other) {
+                    Particle& p_j = particles_m[j];
+                    if (p_i.is_colliding_with(p_j)) {
+                        p_i.collide_with(p_j);
+                    }
+                }
+            }
+        });
+    }
+
+    // Ghosts near the grid's far edges miss some of their partners, but
+    // the error can't travel as far as this rank's own rows in one step;
+    // see halo_rows.
+    template <typename Real, typename Species>
+    void BasicSlabWorld<Real, Species>::collide_particles() {
+        const size_t num_colors = cells_m->num_colors();
+        for (size_t color = 0; color < num_colors; ++color) {
+            const CellSpan span(cells_m->color_span(color));
+            const size_t num_cells = span.size();
+            #pragma omp parallel for num_threads(num_threads_m) schedule(static)
+            for (size_t k = 0; k < num_cells; ++k) {
+                collide_cell_particles(span.cell(k));
+            }
+        }
+        // The ghosts have served their purpose.
+        particles_m.resize(num_owned_m);
+        ids_m.resize(num_owned_m);
+    }
+
+    // Particles are tested against the foil in groups of this many, as
+    // in World.
+    const size_t slab_airfoil_group = 64;
+
+    template <typename Real, typename Species>
+    void BasicSlabWorld<Real, Species>::collide_with_airfoil() {
+        if (!near_airfoil_m) {
+            return;
+        }
+        const size_t num_particles = particles_m.size();
+        const size_t num_groups = (num_particles + slab_airfoil_group - 1) / slab_airfoil_group;
+        #pragma omp parallel num_threads(num_threads_m)
+        {
+            AirfoilCollision collider(airfoil_m);
+            SATPolyBatch& batch(*foil_batches_m[omp_get_thread_num()]);
+            Vector force;
+            size_t indices[slab_airfoil_group];
+
+            #pragma omp for schedule(static)
+            for (size_t g = 0; g < num_groups; ++g) {
+                const size_t begin = g * slab_airfoil_group;
+                const size_t n = std::min(num_particles - begin, slab_airfoil_group);
+                for (size_t k = 0; k < n; ++k) {
+                    indices[k] = begin + k;
+                }
+                const size_t num_hits =
+                    batch.find_collision_normals(particles_m.data(), indices, n);
+                for (size_t h = 0; h < num_hits; ++h) {
+                    Particle& particle(particles_m[indices[batch.hit(h)]]);
+                    Vector recoil_vec(batch.normal(h));
+                    particle.move_to(Vector(particle.pos()).adding(recoil_vec));
+                    force.add(collider.resolve_collision(particle, recoil_vec));
+                }
+            }
+            #pragma omp critical
+            {
+                local_force_m.add(force);
+            }
+        }
+    }
+
+    template <typename Real, typename Species>
+    void BasicSlabWorld<Real, Species>::integrate() {
+        const BasicBBox<Real> world_bbox(0.0, 0.0, world_width_m, world_height_m);
+        const size_t num_particles = particles_m.size();
+        #pragma omp parallel for num_threads(num_threads_m) schedule(static)
+        for (size_t i = 0; i < num_particles; ++i) {
+            Particle& p(particles_m[i]);
+            p.integrate();
+            if (!world_bbox.contains(p.pos())) {
+                recycle(p, step_count_m, ids_m[i]);
+            }
+        }
+    }
+
+    // Recycled particles may land anywhere, so any rank may be sent
+    // particles, not just the neighboring ones.
+    template <typename Real, typename Species>
+    void BasicSlabWorld<Real, Species>::migrate() {
+        size_t kept = 0;
+        for (size_t i = 0; i < particles_m.size(); ++i) {
+            const size_t owner = owner_of_row(row_of(particles_m[i].pos_y()));
+            if (owner == size_t(rank_m)) {
+                particles_m[kept] = particles_m[i];
+                ids_m[kept] = ids_m[i];
+                kept += 1;
+            } else {
+                outgoing_m[owner].push_back(Entry {ids_m[i], particles_m[i]});
+            }
+        }
+        particles_m.resize(kept);
+        ids_m.resize(kept);
+        exchange();
+        for (const Entry& entry : incoming_m) {
+            particles_m.push_back(entry.particle);
+            ids_m.push_back(entry.id);
+        }
+        num_owned_m = particles_m.size();
+    }
+
+    template <typename Real, typename Species>
+    Vector BasicSlabWorld<Real, Species>::force_on_foil() const {
+        double local[2] = {local_force_m.x(), local_force_m.y()};
+        double total[2] = {0.0, 0.0};
+        MPI_Allreduce(local, total, 2, MPI_DOUBLE, MPI_SUM, comm_m);
+        return Vector(total[0], total[1]);
+    }
+
+    template <typename Real, typename Species>
+    double BasicSlabWorld<Real, Species>::momentum() const {
+        double local = 0.0;
+        for (const Particle& p : particles_m) {
+            local += p.momentum();
+        }
+        double total = 0.0;
+        MPI_Allreduce(&local, &total, 1, MPI_DOUBLE, MPI_SUM, comm_m);
+        return total;
+    }
+
+    template <typename Real, typename Species>
+    std::vector<typename BasicSlabWorld<Real, Species>::Particle>
+    BasicSlabWorld<Real, Species>::gather_particles() const {
+        std::vector<Entry> local;
+        for (size_t i = 0; i < particles_m.size(); ++i) {
+            local.push_back(Entry {ids_m[i], particles_m[i]});
+        }
+        const int send_bytes = local.size() * sizeof(Entry);
+        std::vector<int> recv_counts(num_ranks_m), recv_displs(num_ranks_m);
+        MPI_Gather(&send_bytes, 1, MPI_INT, recv_counts.data(), 1, MPI_INT, 0, comm_m);
+
+        std::vector<Entry> all;
+        if (rank_m == 0) {
+            size_t total = 0;
+            for (int r = 0; r < num_ranks_m; ++r) {
+                recv_displs[r] = total;
+                total += recv_counts[r];
+            }
+            all.resize(total / sizeof(Entry));
+        }
+        MPI_Gatherv(
+            local.data(), send_bytes, MPI_BYTE,
+            all.data(), recv_counts.data(), recv_displs.data(), MPI_BYTE, 0, comm_m);
+
+        std::vector<Particle> result(all.size());
+        for (const Entry& entry : all) {
+            result[entry.id] = entry.particle;
+        }
+        return result;
+    }
+
+    template class BasicSlabWorld<double, UniformSpecies>;
+    template class BasicSlabWorld<float, UniformSpecies>;
+    template class BasicSlabWorld<double, MixedSpecies>;
+    template class BasicSlabWorld<float, MixedSpecies>;
+}
@@ -0,0 +1,46 @@
+#include "species.h"
+
+#include <stdexcept>
+
+namespace wingworks {
+    size_t MixedSpecies::num_species_m = 1;
+    double MixedSpecies::max_radius_m = UniformSpecies::radius();
+    double MixedSpecies::mass_m[MixedSpecies::max_species] = {UniformSpecies::mass()};
+    double MixedSpecies::radius_m[MixedSpecies::max_species] = {UniformSpecies::radius()};
+    double MixedSpecies::cumulative_m[MixedSpecies::max_species] = {1.0};
+
+    void MixedSpecies::set_table(const std::vector<SpeciesInfo>& table) {
+        if (table.empty() || (table.size() > max_species)) {
+            throw std::invalid_argument("A species table needs 1 to 16 species.");
+        }
+        double total = 0.0;
+        for (const SpeciesInfo& info : table) {
+            if ((info.mass <= 0.0) || (info.radius <= 0.0) || (info.fraction < 0.0)) {
+                throw std::invalid_argument(
+                    "Species need positive mass and radius, and a non-negative fraction.");
+            }
+            total += info.fraction;
+        }
+        if (total <= 0.0) {
+            throw std::invalid_argument("Species fractions must not all be zero.");
+        }
+
+        num_species_m = table.size();
+        max_radius_m = 0.0;
+        double sum = 0.0;
+        for (size_t s = 0; s < num_species_m; ++s) {
+            mass_m[s] = table[s].mass;
+            radius_m[s] = table[s].radius;
+            sum += table[s].fraction;
+            cumulative_m[s] = sum / total;
+            max_radius_m = (radius_m[s] > max_radius_m) ? radius_m[s] : max_radius_m;
+        }
+    }
+
+    void MixedSpecies::set_species(const size_t species) {
+        if (species >= num_species_m) {
+            throw std::invalid_argument("No such species.");
+        }
+        species_m = species;
+    }
+}
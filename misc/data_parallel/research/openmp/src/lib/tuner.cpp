@@ -0,0 +1,194 @@
+#include "tuner.h"
+
+#include <algorithm>
+#include <chrono>
+#include <sstream>
+#include <stdexcept>
+
+#include <omp.h>
+
+namespace wingworks {
+    using namespace std;
+    using namespace std::chrono;
+
+    string to_string(LoopSchedule schedule) {
+        switch (schedule) {
+            case LoopSchedule::Static: return "static";
+            case LoopSchedule::Dynamic: return "dynamic";
+            case LoopSchedule::Guided: return "guided";
+        }
+        return "static";
+    }
+
+    LoopSchedule loop_schedule_named(const string& name) {
+        if (name == "static") {
+            return LoopSchedule::Static;
+        }
+        if (name == "dynamic") {
+            return LoopSchedule::Dynamic;
+        }
+        if (name == "guided") {
+            return LoopSchedule::Guided;
+        }
+        throw invalid_argument("Unknown loop schedule: " + name);
+    }
+
+    namespace {
+        string describe(const TuningProfile& profile) {
+            ostringstream outs;
+            outs << "cell_extent=" << profile.cell_extent
+                 << " threads=" << profile.num_threads
+                 << " schedule=" << to_string(profile.schedule)
+                 << "," << profile.chunk_size;
+            return outs.str();
+        }
+    }
+
+    TuningProfile::TuningProfile()
+    : TuningProfile(WorldOptions())
+    {}
+
+    TuningProfile::TuningProfile(const WorldOptions& options)
+    : cell_extent(options.cell_extent)
+    , num_threads(options.num_threads)
+    , schedule(options.schedule)
+    , chunk_size(options.chunk_size)
+    , steps_per_second(0.0)
+    {}
+
+    void TuningProfile::apply_to(WorldOptions& options) const {
+        options.cell_extent = cell_extent;
+        options.num_threads = num_threads;
+        options.schedule = schedule;
+        options.chunk_size = chunk_size;
+    }
+
+    void TuningProfile::write(ostream& outs) const {
+        outs << "# wingworks tuning profile" << endl
+             << "cell_extent=" << cell_extent << endl
+             << "num_threads=" << num_threads << endl
+             << "schedule=" << to_string(schedule) << endl
+             << "chunk_size=" << chunk_size << endl
+             << "steps_per_second=" << steps_per_second << endl;
+    }
+
+    TuningProfile TuningProfile::read(istream& ins) {
+        TuningProfile result;
+        string line;
+        while (getline(ins, line)) {
+            if (line.empty() || (line[0] == '#')) {
+                continue;
+            }
+            const size_t sep = line.find('=');
+            if (sep == string::npos) {
+                throw invalid_argument("Malformed tuning profile line: " + line);
+            }
+            const string key(line.substr(0, sep));
+            istringstream value(line.substr(sep + 1));
+            if (key == "cell_extent") {
+                value >> result.cell_extent;
+            } else if (key == "num_threads") {
+                value >> result.num_threads;
+            } else if (key == "schedule") {
+                string name;
+                value >> name;
+                result.schedule = loop_schedule_named(name);
+            } else if (key == "chunk_size") {
+                value >> result.chunk_size;
+            } else if (key == "steps_per_second") {
+                value >> result.steps_per_second;
+            } else {
+                throw invalid_argument("Unknown tuning profile key: " + key);
+            }
+            if (value.fail()) {
+                throw invalid_argument("Bad tuning profile value: " + line);
+            }
+        }
+        return result;
+    }
+
+    Tuner::Tuner(
+        WorldFactory make_world, const size_t warmup_steps,
+        const size_t timed_steps, const size_t repetitions)
+    : make_world_m(make_world)
+    , warmup_steps_m(warmup_steps)
+    , timed_steps_m(timed_steps)
+    , repetitions_m(repetitions)
+    , cell_extents_m({0.5, 1.0, 1.5, 2.0})
+    , schedules_m({
+        {LoopSchedule::Static, 0},
+        {LoopSchedule::Static, 64},
+        {LoopSchedule::Dynamic, 16},
+        {LoopSchedule::Dynamic, 64},
+        {LoopSchedule::Dynamic, 256},
+        {LoopSchedule::Guided, 0},
+        {LoopSchedule::Guided, 16},
+    })
+    {
+        if (repetitions_m < 3) {
+            throw invalid_argument("Tuner needs at least 3 repetitions per trial");
+        }
+        // Powers of two up to the available threads, and that count.
+        const size_t max_threads = omp_get_max_threads();
+        for (size_t n = 1; n < max_threads; n *= 2) {
+            thread_counts_m.push_back(n);
+        }
+        thread_counts_m.push_back(max_threads);
+    }
+
+    double Tuner::steps_per_second(const WorldOptions& options) const {
+        unique_ptr<World> world(make_world_m(options));
+        world->step_many(warmup_steps_m);
+
+        vector<double> rates;
+        rates.reserve(repetitions_m);
+        for (size_t i = 0; i < repetitions_m; ++i) {
+            steady_clock::time_point t0 = steady_clock::now();
+            world->step_many(timed_steps_m);
+            duration<double> dt = steady_clock::now() - t0;
+            rates.push_back(timed_steps_m / dt.count());
+        }
+        nth_element(rates.begin(), rates.begin() + rates.size() / 2, rates.end());
+        return rates[rates.size() / 2];
+    }
+
+    TuningProfile Tuner::calibrate(const WorldOptions& base, ostream& log) const {
+        const int max_threads = omp_get_max_threads();
+
+        TuningProfile best(base);
+        if (best.num_threads == 0) {
+            best.num_threads = max_threads;
+        }
+
+        auto trial = [this, &best, &base, &log](const TuningProfile& candidate) {
+            WorldOptions options(base);
+            candidate.apply_to(options);
+            const double rate = steps_per_second(options);
+            log << "tune: " << describe(candidate) << ": " << rate << " steps/s" << endl;
+            if (rate > best.steps_per_second) {
+                best = candidate;
+                best.steps_per_second = rate;
+            }
+        };
+
+        for (const double extent : cell_extents_m) {
+            TuningProfile candidate(best);
+            candidate.cell_extent = extent;
+            trial(candidate);
+        }
+        for (const ScheduleChoice& choice : schedules_m) {
+            TuningProfile candidate(best);
+            candidate.schedule = choice.schedule;
+            candidate.chunk_size = choice.chunk_size;
+            trial(candidate);
+        }
+        for (const size_t threads : thread_counts_m) {
+            TuningProfile candidate(best);
+            candidate.num_threads = threads;
+            trial(candidate);
+        }
+
+        log << "tune: best " << describe(best) << endl;
+        return best;
+    }
+}
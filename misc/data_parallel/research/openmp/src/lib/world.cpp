@@ -1,66 +1,293 @@
 #include "world.h"
 
+#include <algorithm>
+#include <cmath>
 #include <random>
 #include <iostream>
+#include <new>
 #include <sstream>
+#include <type_traits>
 
 #include <omp.h>
 
 #include "sat_poly_collision.h"
 #include "airfoil_collision.h"
 #include "particle.h"
+#include "page_alloc.h"
 #include "point.h"
+#include "rng.h"
 
-
-namespace {
-    static std::random_device rd;  // Provides seed for random number engine
-    static std::mt19937 gen(rd()); // Standard mersenne_twister_engine
-}
 namespace wingworks {
-    // Use a little secret knowledge of particle size to calculate max number
-    // of particles without overlap.  Assume square grid rather than hex
-    // packing.  Assume no airfoil.
-    // Apply an over-density fudge factor (FF).
-    const double ff = 10.0;
+    // Chunks each thread is dealt by a CellBalancer: enough that stealing
+    // can even out a poor estimate, few enough that each holds many cells.
+    const size_t chunks_per_thread = 4;
+    // Room for particles, with open boundaries, as a multiple of the
+    // initial count.  Crowding in front of the foil needs some.
+    const double open_headroom = 1.5;
+    // Keeps arrivals' random streams apart from the others.
+    const uint64_t boundary_stream = 0x464c4f57;  // "FLOW"
+
+    namespace {
+        BBox grown(const BBox& bbox, const double margin) {
+            return BBox(
+                bbox.xmin() - margin, bbox.ymin() - margin,
+                bbox.xmin() + bbox.width() + margin, bbox.ymin() + bbox.height() + margin);
+        }
+    }
 
-    World::World(
+    template <typename Real, typename Species>
+    BasicWorld<Real, Species>::BasicWorld(
         const Airfoil& foil,
         const double width, const double height,
-        const double max_particle_speed, const Vector& wind_vel
+        const double max_particle_speed, const Vector& wind_vel,
+        const WorldOptions& options
     )
     : airfoil_m(foil)
     , world_width_m(width)
     , world_height_m(height)
-    , num_particles_m(width * height * ff)  // Particle radius: 0.5
+    , free_space_m(foil.shape(), width, height)
+    , num_particles_m(particle_count(width, height))
+    , max_particles_m(
+        (options.boundaries == BoundaryModel::Open) ? size_t(open_headroom * num_particles_m)
+                                                    : num_particles_m)
     , max_speed_m(max_particle_speed)
     , wind_vel_m(wind_vel)
-    , cells_m(width, height, 1.0)  // Particle radius == 0.5
+    , seed_m(options.seed)
+    , step_count_m(0)
+    , num_threads_m(
+        (options.num_threads > 0) ? options.num_threads : omp_get_max_threads())
+    , schedule_m(options.schedule)
+    , chunk_size_m(options.chunk_size)
+    , executor_m(options.executor)
+    , huge_pages_m(options.huge_pages)
+    , tile_columns_m(options.tile_columns)
+    , particles_m(nullptr)
+    , id_of_m(nullptr)
+    , slot_of_m(nullptr)
+    , reorder_interval_m(options.reorder_interval)
+    , next_reorder_step_m(0)
+    , reorder_buffer_m(nullptr)
+    , reorder_keys_m(nullptr)
+    , sorter_m(nullptr)
+    , balance_interval_m(options.balance_interval)
+    , cells_m(
+        width, height, options.cell_extent,
+        2.0 * Species::max_radius() + (options.neighbor_lists ? options.neighbor_skin : 0.0),
+        max_particles_m, options.huge_pages)
+    , dsmc_m(nullptr)
+    , coarsen_interval_m(options.coarsen ? options.coarsen_interval : 0)
+    , merge_gradient_m(options.merge_gradient)
+    , max_weight_m(options.max_weight)
+    , refine_zone_m(grown(foil.shape().bbox(), options.refine_margin))
+    , merge_zone_m(grown(foil.shape().bbox(), 2.0 * options.refine_margin))
+    , num_exits_m(0)
+    , boundaries_m(nullptr)
+    , num_turned_away_m(0)
+    , num_blocked_m(0)
+    , cell_stats_m(nullptr)
+    , neighbor_lists_m(nullptr)
+    , stray_cells_m(nullptr)
+    , incremental_cells_m(options.incremental_cells)
+    , cells_filled_m(false)
+    , home_cell_m(nullptr)
+    , num_migrations_m(0)
     , world_bbox_m(0.0, 0.0, width, height)
     {
+        if (tile_columns_m == 0) {
+            throw std::invalid_argument("Fused tiles need at least one column.");
+        }
+        if (options.neighbor_lists) {
+            if (executor_m != StepExecutor::Phased) {
+                throw std::invalid_argument("Neighbor lists need the Phased executor.");
+            }
+            if (options.neighbor_skin < 0.0) {
+                throw std::invalid_argument("Neighbor list skin must not be negative.");
+            }
+        }
+        if (options.balance_cells
+            && (options.neighbor_lists || (executor_m != StepExecutor::Phased))) {
+            throw std::invalid_argument(
+                "Balanced cells need the Phased executor, without neighbor lists.");
+        }
+        if (options.balance_cells && (balance_interval_m == 0)) {
+            throw std::invalid_argument("Balanced cells need a re-planning interval of at least one step.");
+        }
+        if ((options.collisions == CollisionModel::DSMC)
+            && ((executor_m != StepExecutor::Phased) || options.neighbor_lists
+                || options.balance_cells)) {
+            throw std::invalid_argument(
+                "DSMC collisions need the Phased executor, without neighbor lists "
+                "or balanced cells.");
+        }
+        if (incremental_cells_m && options.neighbor_lists) {
+            throw std::invalid_argument(
+                "Incremental cells need the Phased or Fused executor, without neighbor lists.");
+        }
+        if ((options.boundaries == BoundaryModel::Open)
+            && ((executor_m != StepExecutor::Phased) || options.neighbor_lists
+                || incremental_cells_m || (reorder_interval_m > 0))) {
+            throw std::invalid_argument(
+                "Open boundaries need the Phased executor, without neighbor lists, "
+                "incremental cells or reordering.");
+        }
+        if (options.coarsen) {
+            if (!std::is_same<Species, WeightedSpecies>::value) {
+                throw std::invalid_argument("Coarsening needs a World of WeightedSpecies.");
+            }
+            if ((executor_m != StepExecutor::Phased) || options.neighbor_lists
+                || incremental_cells_m || (reorder_interval_m > 0)
+                || (options.collisions == CollisionModel::DSMC)) {
+                throw std::invalid_argument(
+                    "Coarsening needs the Phased executor, without neighbor lists, "
+                    "incremental cells, reordering or DSMC.");
+            }
+            if ((options.coarsen_interval == 0) || (options.refine_margin < 0.0)
+                || (options.max_weight < 1.0)) {
+                throw std::invalid_argument(
+                    "Coarsening needs an interval of at least one step, a non-negative "
+                    "refinement margin and a maximum weight of at least 1.");
+            }
+        }
+        // Opening the channel can fail, so do it before allocating
+        // anything else.
+        if (!options.frame_channel.empty()) {
+            frame_publisher_m.reset(new FramePublisher(options.frame_channel, max_particles_m));
+        }
         std::cout << "Number of particles: " << num_particles_m << std::endl;
-        particles_m = new Particle[num_particles_m];
+        particles_m = allocate_array<Particle>(max_particles_m, huge_pages_m);
+        id_of_m = allocate_array<size_t>(max_particles_m, huge_pages_m);
+        slot_of_m = allocate_array<size_t>(max_particles_m, huge_pages_m);
+        if (reorder_interval_m > 0) {
+            reorder_buffer_m = allocate_array<Particle>(max_particles_m, huge_pages_m);
+            reorder_keys_m = allocate_array<uint64_t>(max_particles_m, huge_pages_m);
+            sorter_m = new RadixSorter(max_particles_m, num_threads_m, huge_pages_m);
+        }
+        if (options.collect_cell_stats) {
+            cell_stats_m = new CellStats(cells_m);
+        }
+        for (size_t i = 0; i < num_threads_m; ++i) {
+            foil_batches_m.push_back(new SATPolyBatch(airfoil_m.shape()));
+        }
+        pair_screens_m.resize(num_threads_m);
+        if (options.balance_cells) {
+            for (size_t color = 0; color < cells_m.num_colors(); ++color) {
+                balancers_m.push_back(new CellBalancer(num_threads_m, chunks_per_thread));
+            }
+        }
+        if (options.collisions == CollisionModel::DSMC) {
+            // Initial particle velocities differ by at most twice the
+            // maximum speed.
+            dsmc_m = new DsmcCells(
+                cells_m, width, height, options.dsmc_weight,
+                2.0 * Species::max_radius() * 2.0 * max_speed_m);
+        }
+        if (options.neighbor_lists) {
+            neighbor_lists_m = new NeighborLists(max_particles_m, options.neighbor_skin, wind_vel_m);
+            // Past max_stray_fraction the lists are rebuilt instead.
+            stray_cells_m = new WorldCells(
+                width, height, options.cell_extent,
+                2.0 * Species::max_radius() + options.neighbor_skin,
+                size_t(NeighborLists::max_stray_fraction * max_particles_m) + 1, options.huge_pages);
+        }
+        if (coarsen_interval_m > 0) {
+            cell_weight_m.resize(cells_m.size());
+            cell_vel_m.resize(cells_m.size());
+            // A cell can hold every particle, so no coarsening grows these.
+            merge_order_m.resize(num_threads_m);
+            for (auto& order : merge_order_m) {
+                order.reserve(max_particles_m);
+            }
+            split_halves_m.reserve(max_particles_m);
+        }
+        if (options.boundaries == BoundaryModel::Open) {
+            boundaries_m = new FlowBoundaries(
+                width, height, num_particles_m / (width * height), wind_vel_m,
+                max_speed_m / ::sqrt(2.0), options.side_walls);
+        }
+        exits_m.resize(max_particles_m);
+        recycled_per_thread_m.resize(num_threads_m);
+        if (incremental_cells_m) {
+            home_cell_m = allocate_array<size_t>(max_particles_m, huge_pages_m);
+            migrations_m.resize(num_threads_m);
+        }
         reset_force_on_foil();
+
+        #pragma omp parallel num_threads(num_threads_m)
+        {
+            apply_loop_settings();
+            first_touch();
+        }
         randomize();
     }
 
-    World::~World() {
-        delete [] particles_m;
+    template <typename Real, typename Species>
+    BasicWorld<Real, Species>::~BasicWorld() {
+        for (SATPolyBatch *batch : foil_batches_m) {
+            delete batch;
+        }
+        for (CellBalancer *balancer : balancers_m) {
+            delete balancer;
+        }
+        free_pages(home_cell_m);
+        delete boundaries_m;
+        delete dsmc_m;
+        delete stray_cells_m;
+        delete neighbor_lists_m;
+        delete cell_stats_m;
+        delete sorter_m;
+        // Particles need no destruction.
+        free_pages(reorder_keys_m);
+        free_pages(reorder_buffer_m);
+        free_pages(slot_of_m);
+        free_pages(id_of_m);
+        free_pages(particles_m);
+    }
+
+    // Under Linux's default first-touch policy, a page is placed on the
+    // NUMA node of the thread that first writes it.  So rather than let
+    // one thread construct everything, each thread initializes the
+    // particles -- and the slots of the cells -- that the step loops
+    // will give it.  The loops use the same schedule as the step loops,
+    // so with the default static schedule, and threads bound to cores
+    // (see WorldOptions), each thread's particles are local to it.
+    template <typename Real, typename Species>
+    void BasicWorld<Real, Species>::first_touch() {
+        static_assert(std::is_trivially_destructible<Particle>::value,
+                      "Particle storage is freed without destroying particles.");
+        #pragma omp for schedule(runtime)
+        for (size_t i = 0; i < max_particles_m; ++i) {
+            new (&particles_m[i]) Particle();
+            id_of_m[i] = slot_of_m[i] = i;
+            if (reorder_buffer_m) {
+                new (&reorder_buffer_m[i]) Particle();
+                reorder_keys_m[i] = 0;
+            }
+            if (home_cell_m) {
+                home_cell_m[i] = 0;
+            }
+        }
+        cells_m.first_touch();
+        if (sorter_m) {
+            sorter_m->first_touch();
+        }
+        if (stray_cells_m) {
+            stray_cells_m->first_touch();
+        }
     }
     
-    void World::randomize() {
-        std::uniform_real_distribution<> sxrand(0.0, world_width_m);
-        std::uniform_real_distribution<> syrand(0.0, world_height_m);
+    template <typename Real, typename Species>
+    void BasicWorld<Real, Species>::randomize() {
+        std::mt19937 gen(seed_m);
+        std::uniform_real_distribution<> urand(0.0, 1.0);
         
         std::uniform_real_distribution<> vrand(-max_speed_m, max_speed_m);
 
         for (size_t i = 0; i < num_particles_m; ++i) {
-            double x = sxrand(gen);
-            double y = syrand(gen);
-            while (airfoil_m.shape().contains(Point(x, y))) {
-                x = sxrand(gen);
-                y = syrand(gen);
-            }
-            particles_m[i].move_to(x, y);
+            const double u1 = urand(gen);
+            const double u2 = urand(gen);
+            const double u3 = urand(gen);
+            const Point pos(free_space_m.sample(u1, u2, u3));
+            particles_m[i].move_to(pos.x(), pos.y());
 
             // Get a random particle speed, with added wind.
             const Vector vel(
@@ -68,11 +295,16 @@ namespace wingworks {
                 .adding(Vector(vrand(gen), vrand(gen))
                 .unit().scaled(max_speed_m)));
             particles_m[i].set_vel(vel.x(), vel.y());
+            particles_m[i].draw_species(gen);
         }
     }
 
-    void World::recycle(Particle& p, size_t index) {
-        std::uniform_real_distribution<> syrand(0.0, world_height_m);
+    template <typename Real, typename Species>
+    void BasicWorld<Real, Species>::recycle(Particle& p, const size_t step, const size_t index) {
+        // Integrate runs in parallel, so draw from a per-particle stream
+        // rather than from a shared generator.
+        CounterRNG gen(seed_m, step, index);
+        std::uniform_real_distribution<> urand(0.0, 1.0);
         std::uniform_real_distribution<> vrand(-max_speed_m, max_speed_m);
 
         // TODO try just wrapping around, with a little randomzation.
@@ -85,16 +317,29 @@ namespace wingworks {
         while (x > world_width_m) {
             x -= world_width_m;
         }
-        double y = syrand(gen);
-        while (airfoil_m.shape().contains(Point(x, y))) {
-            y = syrand(gen);
-        }
+        const double y = free_space_m.sample_y(x, urand(gen));
         const double vx = vrand(gen) + wind_vel_m.x();
         const double vy = vrand(gen) + wind_vel_m.y();
         p.move_to(x, y);
         p.set_vel(vx, vy);
     }
 
+    // The step loops use schedule(runtime), so the schedule reaches them
+    // without threading it through every pragma.  Every thread of a
+    // World's parallel region sets it first thing: the schedule is an ICV
+    // of each thread's implicit task, so it ends with the region and
+    // neither other Worlds nor the host program see it.
+    template <typename Real, typename Species>
+    void BasicWorld<Real, Species>::apply_loop_settings() const {
+        omp_sched_t kind = omp_sched_static;
+        switch (schedule_m) {
+            case LoopSchedule::Static: kind = omp_sched_static; break;
+            case LoopSchedule::Dynamic: kind = omp_sched_dynamic; break;
+            case LoopSchedule::Guided: kind = omp_sched_guided; break;
+        }
+        omp_set_schedule(kind, int(chunk_size_m));
+    }
+
     // As in Swift version, divide the world into subregions.  Fewer particles
     // per region makes less work than full pairwise collision test:
     // k * O(M**2) < O(N**2) when M << N.
@@ -103,84 +348,492 @@ namespace wingworks {
     // by NVidia, here:
     // https://developer.download.nvidia.com/assets/cuda/files/particles.pdf
     // Apparently it's pretty common.
-    void World::assign_to_cells() {
+    template <typename Real, typename Species>
+    void BasicWorld<Real, Species>::assign_to_cells() {
+        // With incremental cells, apply_migrations has already brought
+        // the cells up to date.  The barrier ending clear's loop keeps
+        // any thread from setting cells_filled_m before all have read it.
+        if (incremental_cells_m && cells_filled_m) {
+            #pragma omp single
+            {
+                if (cell_stats_m) {
+                    cell_stats_m->record_occupancy(cells_m);
+                }
+            }
+            return;
+        }
+
         cells_m.clear();
-        for (size_t i = 0; i < num_particles_m; ++i) {
-            cells_m.add(particles_m[i], i);
+        #pragma omp single
+        {
+            // Fill cells in ID order, whatever the storage order.
+            for (size_t id = 0; id < num_particles_m; ++id) {
+                const size_t i = slot_of_m[id];
+                cells_m.add(particles_m[i], i);
+            }
+            if (incremental_cells_m) {
+                for (size_t i = 0; i < num_particles_m; ++i) {
+                    home_cell_m[i] = cells_m.index_of(particles_m[i].pos_x(), particles_m[i].pos_y());
+                }
+                cells_filled_m = true;
+            }
+            if (cell_stats_m) {
+                cell_stats_m->record_occupancy(cells_m);
+            }
         }
     }
 
-    // This has a bug: it allows two particles to collide repeatedly,
-    // once for each cell that they share.
-    void World::collide_cell_particles(const Cell& cell) {
+    // Collide the particles in one cell with each other and with those
+    // in the cell's forward neighbors.  Each particle lives in exactly
+    // one cell, so each candidate pair is tested exactly once per step.
+    //
+    // Cells hold only a handful of particles, so this does not try
+    // to parallelize within a cell; see collide_particles.  Pairs are
+    // screened for touching up front (see PairScreen), but collide in
+    // the same order as if each were tested as it came.
+    template <typename Real, typename Species>
+    void BasicWorld<Real, Species>::collide_cell_particles(const WorldCells& cells, const size_t i_cell) {
+        const Cell& cell = cells.cell(i_cell);
         const size_t num_particles = cell.size();
-        
-        const size_t *raw_cell = cell.data();
-        #pragma omp target teams distribute parallel for
-        for (size_t i = 0; i < num_particles; ++i) {
-            Particle& p_i = particles_m[raw_cell[i]];
-            for (size_t j = i + 1; j < num_particles; ++j) {
-                Particle& p_j = particles_m[raw_cell[j]];
-                if (p_i.is_colliding_with(p_j)) {
-                    #pragma omp critical
-                    p_i.collide_with(p_j);
+        if (num_particles == 0) {
+            if (cell_stats_m) {
+                cell_stats_m->record_pairs(i_cell, 0, 0);
+            }
+            return;
+        }
+
+        PairScreen<Real>& screen(pair_screens_m[omp_get_thread_num()]);
+        screen.clear();
+        for (const size_t i : cell) {
+            screen.stage(particles_m[i], i);
+        }
+        cells.for_each_forward_neighbor(i_cell, [&](const size_t i_other) {
+            for (const size_t j : cells.cell(i_other)) {
+                screen.stage(particles_m[j], j);
+            }
+        });
+
+        size_t tested = 0;
+        size_t colliding = 0;
+        // Collide each particle of the cell, staged at a, with the
+        // touching staged particles in [begin, end) that come after it.
+        auto collide_range = [&](const size_t begin, const size_t end) {
+            for (size_t a = 0; a < num_particles; ++a) {
+                Particle& p_i = particles_m[cell[a]];
+                const size_t after = (begin > a) ? begin : a + 1;
+                const size_t num_hits = screen.find_touching(p_i, after, end);
+                for (size_t h = 0; h < num_hits; ++h) {
+                    p_i.collide_with(particles_m[screen.hit(h)]);
+                }
+                tested += (end > after) ? end - after : 0;
+                colliding += num_hits;
+            }
+        };
+
+        collide_range(0, num_particles);
+        size_t begin = num_particles;
+        cells.for_each_forward_neighbor(i_cell, [&](const size_t i_other) {
+            const size_t end = begin + cells.cell(i_other).size();
+            collide_range(begin, end);
+            begin = end;
+        });
+
+        if (cell_stats_m) {
+            cell_stats_m->record_pairs(i_cell, tested, colliding);
+        }
+    }
+
+    template <typename Real, typename Species>
+    void BasicWorld<Real, Species>::collide_span_cells(
+        const WorldCells& cells, const CellSpan& span, const size_t k_begin, const size_t k_end)
+    {
+        for (size_t k = k_begin; k < k_end; ++k) {
+            collide_cell_particles(cells, span.cell(k));
+        }
+    }
+
+    template <typename Real, typename Species>
+    void BasicWorld<Real, Species>::collide_span(const WorldCells& cells, const CellSpan& span) {
+        const size_t num_cells = span.size();
+        #pragma omp for schedule(runtime)
+        for (size_t k = 0; k < num_cells; ++k) {
+            collide_cell_particles(cells, span.cell(k));
+        }
+    }
+
+    // Search one color of cells at a time; see WorldCells::num_colors.
+    // The barrier at the end of each loop keeps colors from overlapping.
+    template <typename Real, typename Species>
+    void BasicWorld<Real, Species>::collide_particles() {
+        const size_t num_colors = cells_m.num_colors();
+        if (balancers_m.empty()) {
+            for (size_t color = 0; color < num_colors; ++color) {
+                collide_span(cells_m, cells_m.color_span(color));
+            }
+            return;
+        }
+
+        // Every thread sees the same step count, so all agree on whether
+        // to re-plan.
+        if (step_count_m % balance_interval_m == 0) {
+            #pragma omp single
+            {
+                for (size_t color = 0; color < num_colors; ++color) {
+                    balancers_m[color]->plan(cells_m, cells_m.color_span(color));
                 }
             }
         }
+        for (size_t color = 0; color < num_colors; ++color) {
+            const CellSpan span(cells_m.color_span(color));
+            balancers_m[color]->for_each_chunk([&](const size_t k_begin, const size_t k_end) {
+                collide_span_cells(cells_m, span, k_begin, k_end);
+            });
+        }
+    }
+
+    template <typename Real, typename Species>
+    void BasicWorld<Real, Species>::collide_with_airfoil(
+        AirfoilCollision& collider, SATPolyBatch& batch,
+        const size_t *indices, const size_t n, Vector& force)
+    {
+        const size_t num_hits = batch.find_collision_normals(particles_m, indices, n);
+        for (size_t h = 0; h < num_hits; ++h) {
+            Particle& particle(particles_m[indices[batch.hit(h)]]);
+            Vector recoil_vec(batch.normal(h));
+            particle.move_to(Vector(particle.pos()).adding(recoil_vec));
+            force.add(collider.resolve_collision(particle, recoil_vec));
+        }
+    }
+
+    template <typename Real, typename Species>
+    bool BasicWorld<Real, Species>::integrate(Particle& particle, const size_t step, const size_t index) {
+        particle.integrate();
+        if (is_out_of_world(particle)) {
+            recycle(particle, step, index);
+            return true;
+        }
+        return false;
+    }
+
+    template <typename Real, typename Species>
+    void BasicWorld<Real, Species>::track_migration(const Particle& particle, const size_t index) {
+        const size_t home = cells_m.index_of(particle.pos_x(), particle.pos_y());
+        if (home != home_cell_m[index]) {
+            migrations_m[omp_get_thread_num()].push_back(Migration {index, home_cell_m[index], home});
+        }
+    }
+
+    // Called by one thread, once all have finished integrating.  Cells
+    // stay in ID order, just as assign_to_cells would leave them,
+    // so the results match rebuilding the cells every step.
+    template <typename Real, typename Species>
+    void BasicWorld<Real, Species>::apply_migrations() {
+        for (std::vector<Migration>& queue : migrations_m) {
+            for (const Migration& m : queue) {
+                cells_m.move(m.index, m.from_cell, m.to_cell, by_id());
+                home_cell_m[m.index] = m.to_cell;
+            }
+            num_migrations_m += queue.size();
+            queue.clear();
+        }
     }
 
-    void World::collide_particles() {
-        for (size_t i_cell = 0; i_cell < cells_m.size(); ++i_cell) {
-            const Cell& cell = cells_m.cell(i_cell);
-            // What if two particles appear together in multiple cells,
-            // thus colliding multiple times?
-            collide_cell_particles(cell);
+    template <typename Real, typename Species>
+    void BasicWorld<Real, Species>::add_force_on_foil(const Vector& force) {
+        #pragma omp critical
+        {
+            net_force_on_foil_m.add(force);
         }
     }
 
-    void World::collide_with_airfoil() {
+    // Particles are tested against the foil in groups of this many, to
+    // fill SATPolyBatch's vector lanes.
+    const size_t airfoil_group = 64;
+
+    template <typename Real, typename Species>
+    void BasicWorld<Real, Species>::collide_with_airfoil() {
         AirfoilCollision collider(airfoil_m);
+        SATPolyBatch& batch(*foil_batches_m[omp_get_thread_num()]);
+        Vector force;
+        size_t indices[airfoil_group];
+
+        // Each loop iteration mutates only its own particles,
+        // and depends on no mutable state.  So I think no
+        // critical section is needed here, except to sum
+        // up the force on the foil.
+        const size_t num_groups = (num_particles_m + airfoil_group - 1) / airfoil_group;
+        #pragma omp for schedule(runtime)
+        for (size_t g = 0; g < num_groups; ++g) {
+            const size_t begin = g * airfoil_group;
+            const size_t n = std::min(num_particles_m - begin, airfoil_group);
+            for (size_t k = 0; k < n; ++k) {
+                indices[k] = begin + k;
+            }
+            collide_with_airfoil(collider, batch, indices, n, force);
+        }
+        add_force_on_foil(force);
+    }
+
+    template <typename Real, typename Species>
+    void BasicWorld<Real, Species>::note_exit(const size_t i) {
+        size_t k;
+        #pragma omp atomic capture
+        k = num_exits_m++;
+        exits_m[k] = i;
+    }
 
-        #pragma omp parallel for
+    // Particles leave the world unevenly over the index ranges the
+    // threads share -- once they're ordered by cell, only those near the
+    // world's edges can -- and recycling one draws random numbers and
+    // places it.  So rather than recycle them where they are found, the
+    // threads note the slots of those that left, and recycle them
+    // together, split evenly among the threads.  Each particle draws from
+    // its own stream, so neither the order the notes land in nor the
+    // order they're recycled in matters.
+    template <typename Real, typename Species>
+    void BasicWorld<Real, Species>::integrate() {
+        if (boundaries_m) {
+            #pragma omp for schedule(runtime)
+            for (size_t i = 0; i < num_particles_m; ++i) {
+                particles_m[i].integrate();
+                if (!boundaries_m->keep(particles_m[i])) {
+                    note_exit(i);
+                }
+            }
+            return;
+        }
+        #pragma omp for schedule(runtime)
         for (size_t i = 0; i < num_particles_m; ++i) {
-            Particle& particle(particles_m[i]);
-            Vector recoil_vec;
-            // Each loop iteration mutates only one particle,
-            // and depends on no mutable state.  So I think no
-            // critical section is needed here.
-            if (collider.is_colliding(particle, recoil_vec)) {
-                    particle.move_to(particle.pos().adding(recoil_vec));
-                    const Vector impulse = collider.resolve_collision(
-                            particle, recoil_vec);
-                    #pragma omp critical
-                    {
-                        net_force_on_foil_m.add(impulse);
-                    }                        
+            particles_m[i].integrate();
+            if (is_out_of_world(particles_m[i])) {
+                note_exit(i);
+            } else if (incremental_cells_m) {
+                track_migration(particles_m[i], i);
+            }
+        }
+
+        const size_t num_recycled = num_exits_m;
+        size_t num_mine = 0;
+        #pragma omp for schedule(static)
+        for (size_t k = 0; k < num_recycled; ++k) {
+            const size_t i = exits_m[k];
+            recycle(particles_m[i], step_count_m, id_of_m[i]);
+            if (neighbor_lists_m) {
+                neighbor_lists_m->mark_stray(i);
+            }
+            if (incremental_cells_m) {
+                track_migration(particles_m[i], i);
+            }
+            num_mine += 1;
+        }
+        recycled_per_thread_m[omp_get_thread_num()] = num_mine;
+    }
+
+    // Arrivals fill the lowest free slots first.  Any free slots left
+    // over are filled from the top of storage, and any arrivals left
+    // over go on top.  All in slot order, so the results depend on
+    // neither the thread count nor the schedule.
+    template <typename Real, typename Species>
+    void BasicWorld<Real, Species>::exchange_through_boundaries() {
+        // The slots particles left are free.
+        std::vector<size_t>& free_slots(exits_m);
+        const size_t num_free = num_exits_m;
+        std::sort(free_slots.begin(), free_slots.begin() + num_free);
+
+        CounterRNG gen(seed_m ^ boundary_stream, step_count_m, 0);
+        inflow_m.clear();
+        boundaries_m->draw_arrivals(gen, inflow_m);
+
+        size_t k_free = 0;
+        for (const Arrival& arrival : inflow_m) {
+            // Arrivals land within a step's travel of their edge, so only
+            // a foil reaching the edge can be in the way.  The foil covers
+            // that stretch of the edge, and no gas comes in through it.
+            if (airfoil_m.shape().contains(arrival.pos)) {
+                num_blocked_m += 1;
+                continue;
+            }
+            Particle p;
+            p.move_to(arrival.pos);
+            p.set_vel(arrival.vel.x(), arrival.vel.y());
+            p.draw_species(gen);
+            if (k_free < num_free) {
+                particles_m[free_slots[k_free++]] = p;
+            } else if (num_particles_m < max_particles_m) {
+                particles_m[num_particles_m++] = p;
+            } else {
+                num_turned_away_m += 1;
+            }
+        }
+
+        // Close the remaining gaps, highest free slot first if it is on
+        // top.
+        size_t k_top = num_free;
+        while (k_free < k_top) {
+            if (free_slots[k_top - 1] == num_particles_m - 1) {
+                k_top -= 1;
+            } else {
+                particles_m[free_slots[k_free++]] = particles_m[num_particles_m - 1];
             }
+            num_particles_m -= 1;
         }
     }
 
-    void World::integrate() {
-        #pragma omp parallel for
+    // Recycling draws from streams keyed by the step count, so the count
+    // must not change until every thread has finished integrating.  The
+    // barrier ending integrate's loop, and the one ending this single,
+    // see to that.
+    template <typename Real, typename Species>
+    void BasicWorld<Real, Species>::finish_step() {
+        #pragma omp single
+        {
+            if (boundaries_m) {
+                exchange_through_boundaries();
+            }
+            num_exits_m = 0;
+            ++step_count_m;
+            if (incremental_cells_m) {
+                apply_migrations();
+            }
+            if (cell_stats_m) {
+                cell_stats_m->record_step();
+            }
+            if (neighbor_lists_m) {
+                neighbor_lists_m->finish_step();
+            }
+        }
+    }
+
+    template <typename Real, typename Species>
+    void BasicWorld<Real, Species>::step_many(const size_t num_steps) {
+        // Reordering sorts within the region, where throwing would
+        // terminate the program, so check here that the sorter fits.  A
+        // team is never larger than num_threads_m.
+        if (sorter_m
+            && ((num_threads_m > sorter_m->max_threads()) || (max_particles_m > sorter_m->capacity()))) {
+            throw std::invalid_argument("The reordering sorter is too small for this World.");
+        }
+        #pragma omp parallel num_threads(num_threads_m)
+        {
+            apply_loop_settings();
+            for (size_t i = 0; i < num_steps; ++i) {
+                reorder_if_due();
+                coarsen_if_due();
+                if (executor_m == StepExecutor::Fused) {
+                    assign_to_cells();
+                    fused_sweep();
+                } else {
+                    if (neighbor_lists_m) {
+                        collide_listed_particles();
+                    } else if (dsmc_m) {
+                        assign_to_cells();
+                        collide_dsmc();
+                    } else {
+                        assign_to_cells();
+                        collide_particles();
+                    }
+                    collide_with_airfoil();
+                    integrate();
+                }
+                finish_step();
+            }
+            if (frame_publisher_m) {
+                publish_frame();
+            }
+        }
+    }
+
+    // Viewers read the frame while the World steps on, so it is written
+    // straight into shared memory, never waiting on them.
+    template <typename Real, typename Species>
+    void BasicWorld<Real, Species>::publish_frame() {
+        FramePublisher& publisher(*frame_publisher_m);
+        #pragma omp single
+        {
+            publisher.begin_frame(step_count_m, num_particles_m, net_force_on_foil_m);
+        }
+        float *pos_x = publisher.pos_x();
+        float *pos_y = publisher.pos_y();
+        float *vel_x = publisher.vel_x();
+        float *vel_y = publisher.vel_y();
+        #pragma omp for schedule(runtime)
+        for (size_t id = 0; id < num_particles_m; ++id) {
+            const Particle& p(particle(id));
+            pos_x[id] = p.pos_x();
+            pos_y[id] = p.pos_y();
+            vel_x[id] = p.vel().x();
+            vel_y[id] = p.vel().y();
+        }
+        #pragma omp single
+        {
+            publisher.end_frame();
+        }
+    }
+
+    template <typename Real, typename Species>
+    void BasicWorld<Real, Species>::reorder_if_due() {
+        // next_reorder_step_m changes only after reorder_particles' first
+        // barrier, so every thread makes the same decision.
+        if ((reorder_interval_m > 0) && (step_count_m >= next_reorder_step_m)) {
+            reorder_particles();
+        }
+    }
+
+    // Sort keys hold a particle's home cell's Morton code above its ID.
+    // IDs are unique, so the sort needs no payload, and particles that
+    // share a cell end up in ID order.
+    template <typename Real, typename Species>
+    void BasicWorld<Real, Species>::reorder_particles() {
+        unsigned id_bits = 1;
+        while ((size_t(1) << id_bits) < num_particles_m) {
+            id_bits += 1;
+        }
+        const uint64_t id_mask = (uint64_t(1) << id_bits) - 1;
+
+        #pragma omp for schedule(runtime)
+        for (size_t i = 0; i < num_particles_m; ++i) {
+            const Particle& p(particles_m[i]);
+            const size_t home = cells_m.index_of(p.pos_x(), p.pos_y());
+            reorder_keys_m[i] = (cells_m.morton_of(home) << id_bits) | id_of_m[i];
+        }
+        sorter_m->sort(reorder_keys_m, num_particles_m, cells_m.morton_bits() + id_bits);
+
+        #pragma omp for schedule(runtime)
+        for (size_t i = 0; i < num_particles_m; ++i) {
+            const size_t id = reorder_keys_m[i] & id_mask;
+            const Particle& src(particles_m[slot_of_m[id]]);
+            reorder_buffer_m[i] = src;
+            id_of_m[i] = id;
+        }
+        #pragma omp for schedule(runtime)
         for (size_t i = 0; i < num_particles_m; ++i) {
-            Particle& p(particles_m[i]);
-            p.integrate();
-            if (is_out_of_world(p)) {
-                recycle(p, i);
+            slot_of_m[id_of_m[i]] = i;
+        }
+
+        // Slots have changed, so anything indexed by slot must be rebuilt.
+        #pragma omp single
+        {
+            std::swap(particles_m, reorder_buffer_m);
+            cells_filled_m = false;
+            if (neighbor_lists_m) {
+                neighbor_lists_m->invalidate();
             }
+            next_reorder_step_m = step_count_m + reorder_interval_m;
         }
     }
 
-    bool World::is_out_of_world(const Particle& p) const {
+    template <typename Real, typename Species>
+    bool BasicWorld<Real, Species>::is_out_of_world(const Particle& p) const {
         return !world_bbox_m.contains(p.pos());
     }
 
     // These belong somewhere else...
-    void World::write_particle_positions(std::ostream& outs) const {
+    template <typename Real, typename Species>
+    void BasicWorld<Real, Species>::write_particle_positions(std::ostream& outs) const {
         // Positions, positions + velocities... whatever
         outs << "X,Y,VX,VY" << std::endl;
-        for (size_t i = 0; i < num_particles_m; ++i) {
-            const Particle& p(particles_m[i]);
+        for (size_t id = 0; id < num_particles_m; ++id) {
+            const Particle& p(particle(id));
             Point pos(p.pos());
             Point vel(p.vel());
             outs << pos.x() << "," << pos.y() << ","
@@ -189,9 +842,24 @@ namespace wingworks {
         }
     }
 
-    void World::write_force_on_foil(std::ostream& outs) const {
+    template <typename Real, typename Species>
+    void BasicWorld<Real, Species>::write_force_on_foil(std::ostream& outs) const {
         outs 
             << "X,Y" << std::endl
             << net_force_on_foil_m.x() << "," << net_force_on_foil_m.y() << std::endl;
     }
-}
\ No newline at end of file
+
+    template <typename Real, typename Species>
+    void BasicWorld<Real, Species>::write_cell_stats(std::ostream& outs) const {
+        if (cell_stats_m) {
+            cell_stats_m->write(outs);
+        }
+    }
+
+    template class BasicWorld<float>;
+    template class BasicWorld<double>;
+    template class BasicWorld<float, MixedSpecies>;
+    template class BasicWorld<double, MixedSpecies>;
+    template class BasicWorld<float, WeightedSpecies>;
+    template class BasicWorld<double, WeightedSpecies>;
+}
@@ -2,36 +2,102 @@
 
 namespace wingworks {
 
+    // This is an orphaned worksharing loop: called from within World's
+    // parallel region the team shares the cells, and called outside one
+    // it runs serially.
     void WorldCells::clear() {
-        #pragma omp parallel for
+        // The loop's closing barrier keeps anyone from adding to the
+        // overflow area before it is reset.
+        #pragma omp single nowait
+        {
+            overflow_used_m = 0;
+        }
+        #pragma omp for schedule(runtime)
         for (size_t i = 0; i < num_cells_m; ++i) {
-            cells_m[i].clear();
+            reset_cell(i);
         }
     }
 
-    void WorldCells::add(const Particle& particle, const size_t particle_index) {
-        // Assign the particle to any cell with which it overlaps.
-        const double x(particle.pos_x());
-        const double y(particle.pos_y());
-        const double r(particle.radius());
-        const double x_coords[3] {x - r, x, x + r};
-        const double y_coords[3] {y - r, y, y + r};
-
-        for (size_t iy = 0; iy < 3; ++iy) {
-            const double y_curr = y_coords[iy];
-            const double i_cell_row = y_curr / cell_extent_m; // Truncate.
-            const size_t row_offset = i_cell_row * num_horiz_m;
-
-            for (size_t ix = 0; ix < 3; ++ix) {
-                const double x_curr = x_coords[ix];
-                const double i_cell_col = x_curr / cell_extent_m;
-                const size_t cell_index = row_offset + i_cell_col;
-
-                if (0 <= cell_index && cell_index < num_cells_m) {
-                    cells_m[cell_index].push_back(particle_index);
-                }
+    // Orphaned worksharing, like clear().  Which cells spill into the
+    // overflow area can't be known, so it is simply split evenly.
+    void WorldCells::first_touch() {
+        #pragma omp for schedule(runtime)
+        for (size_t i = 0; i < num_cells_m; ++i) {
+            std::fill_n(slab_m + i * slab_capacity_m, slab_capacity_m, 0);
+            reset_cell(i);
+        }
+        #pragma omp for schedule(static)
+        for (size_t k = 0; k < overflow_capacity_m; ++k) {
+            overflow_m[k] = 0;
+        }
+        #pragma omp single
+        {
+            overflow_used_m = 0;
+        }
+    }
+
+    // Cells that fit back in their own slots go home.  The rest slide
+    // down to the start of the overflow area, in address order, with no
+    // room to spare.
+    void WorldCells::compact_overflow() {
+        size_t num_overflowing = 0;
+        for (size_t i = 0; i < num_cells_m; ++i) {
+            if (!in_overflow(i)) {
+                continue;
+            }
+            if (size_m[i] <= slab_capacity_m) {
+                size_t *home = slab_m + i * slab_capacity_m;
+                std::copy(begin_m[i], begin_m[i] + size_m[i], home);
+                begin_m[i] = home;
+                capacity_m[i] = slab_capacity_m;
+            } else {
+                compact_order_m[num_overflowing++] = i;
             }
         }
+        std::sort(compact_order_m, compact_order_m + num_overflowing,
+            [this](const size_t i1, const size_t i2) {
+                return (begin_m[i1] - overflow_m) < (begin_m[i2] - overflow_m);
+            });
+
+        overflow_used_m = 0;
+        for (size_t k = 0; k < num_overflowing; ++k) {
+            const size_t i = compact_order_m[k];
+            size_t *region = overflow_m + overflow_used_m;
+            std::copy(begin_m[i], begin_m[i] + size_m[i], region);
+            begin_m[i] = region;
+            capacity_m[i] = size_m[i];
+            overflow_used_m += size_m[i];
+        }
+    }
+
+    CellSpan WorldCells::color_span(
+        const size_t color, const size_t col_begin, const size_t col_end) const
+    {
+        const size_t row0 = color / color_cols_m;
+        const size_t col_residue = color % color_cols_m;
+        // First column at or after col_begin with this color's residue.
+        const size_t col0 =
+            col_begin + (color_cols_m + col_residue - col_begin % color_cols_m) % color_cols_m;
+
+        const size_t rows = (num_vert_m > row0)
+            ? (num_vert_m - row0 + color_rows_m - 1) / color_rows_m : 0;
+        const size_t cols = (col_end > col0)
+            ? (col_end - col0 + color_cols_m - 1) / color_cols_m : 0;
+        return CellSpan {row0, col0, color_rows_m, color_cols_m, rows, cols, num_horiz_m};
+    }
+
+    CellSpan WorldCells::nearby_color_span(const size_t color) const {
+        const size_t stride = color_cols_m;
+        const size_t row0 = color / stride;
+        const size_t col0 = color % stride;
+        const size_t rows = (num_vert_m > row0) ? (num_vert_m - row0 + stride - 1) / stride : 0;
+        const size_t cols = (num_horiz_m > col0) ? (num_horiz_m - col0 + stride - 1) / stride : 0;
+        return CellSpan {row0, col0, stride, stride, rows, cols, num_horiz_m};
+    }
+
+    CellSpan WorldCells::column_span(const size_t col_begin, const size_t col_end) const {
+        const size_t cols = (col_end > col_begin) ? col_end - col_begin : 0;
+        return CellSpan {0, col_begin, 1, 1, num_vert_m, cols, num_horiz_m};
     }
 
-} // namespace
\ No newline at end of file
+} // namespace
@@ -0,0 +1,175 @@
+#include "world.h"
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <type_traits>
+
+#include <omp.h>
+
+#include "coarsening.h"
+#include "rng.h"
+
+// Coarsening (see WorldOptions::coarsen).  Cells merge their own
+// particles, so every cell can merge in parallel, each drawing from a
+// random stream keyed by step and cell.  Splitting, and compacting the
+// survivors into the lowest slots, is serial: it moves particles across
+// the whole of storage.  Both go in slot order, so the results depend
+// on neither the thread count nor the schedule.
+
+namespace wingworks {
+    namespace {
+        // Keep coarsening's streams apart from recycling's and DSMC's.
+        const uint64_t merge_stream = 0x4d455247;  // "MERG"
+        const uint64_t split_stream = 0x53504c54;  // "SPLT"
+
+        // Particles merge this many at a time, into two.
+        const size_t merge_group = 4;
+        // How far apart the halves of a split particle start.  They move
+        // together, so they don't push each other apart.
+        const double split_offset = 0.25;
+
+        Vector random_direction(CounterRNG& gen) {
+            std::uniform_real_distribution<> arand(0.0, 2.0 * M_PI);
+            const double a = arand(gen);
+            return Vector(::cos(a), ::sin(a));
+        }
+    }
+
+    template <typename Real, typename Species>
+    void BasicWorld<Real, Species>::coarsen_if_due() {
+        // Every thread sees the same step count, so all agree.
+        if ((coarsen_interval_m > 0) && (step_count_m % coarsen_interval_m == 0)) {
+            coarsen();
+        }
+    }
+
+    template <typename Real, typename Species>
+    void BasicWorld<Real, Species>::coarsen() {
+        // Only weighted particles can merge; the constructor turns
+        // coarsening away for any other Species.
+        if constexpr (std::is_same<Species, WeightedSpecies>::value) {
+            cells_m.clear();
+            #pragma omp single
+            {
+                for (size_t i = 0; i < num_particles_m; ++i) {
+                    cells_m.add(particles_m[i], i);
+                }
+            }
+
+            const size_t num_cells = cells_m.size();
+            #pragma omp for schedule(runtime)
+            for (size_t i_cell = 0; i_cell < num_cells; ++i_cell) {
+                double weight = 0.0;
+                Vector momentum;
+                for (const size_t i : cells_m.cell(i_cell)) {
+                    const Particle& p(particles_m[i]);
+                    weight += p.weight();
+                    momentum.add(Vector(p.vel()).scaled(p.weight()));
+                }
+                cell_weight_m[i_cell] = weight;
+                cell_vel_m[i_cell] = (weight > 0.0) ? momentum.scaled(1.0 / weight) : Vector();
+            }
+
+            // A cell merges if it lies wholly outside merge_zone_m, and
+            // its mean velocity is close to those of its occupied
+            // neighbors.  Merged-away particles are left with weight 0.
+            const double extent = cells_m.cell_extent();
+            std::vector<size_t>& order(merge_order_m[omp_get_thread_num()]);
+            #pragma omp for schedule(runtime)
+            for (size_t i_cell = 0; i_cell < num_cells; ++i_cell) {
+                if (cell_weight_m[i_cell] == 0.0) {
+                    continue;
+                }
+                const double left = cells_m.col_of(i_cell) * extent;
+                const double bottom = cells_m.row_of(i_cell) * extent;
+                const BBox& zone(merge_zone_m);
+                if ((left < zone.xmin() + zone.width()) && (left + extent > zone.xmin())
+                    && (bottom < zone.ymin() + zone.height()) && (bottom + extent > zone.ymin())) {
+                    continue;
+                }
+                bool smooth = true;
+                cells_m.for_each_nearby(i_cell, [&](const size_t i_other) {
+                    if ((cell_weight_m[i_other] > 0.0)
+                        && (cell_vel_m[i_other].offset(cell_vel_m[i_cell]).magnitude() > merge_gradient_m)) {
+                        smooth = false;
+                    }
+                });
+                if (!smooth) {
+                    continue;
+                }
+
+                // Merge the lightest particles first, so that weights
+                // even out.  Ties go in slot order, the cell's own order;
+                // unlike stable_sort, sort doesn't allocate.
+                const Cell cell(cells_m.cell(i_cell));
+                order.assign(cell.begin(), cell.end());
+                std::sort(order.begin(), order.end(), [this](const size_t i1, const size_t i2) {
+                    const double w1 = particles_m[i1].weight();
+                    const double w2 = particles_m[i2].weight();
+                    return (w1 < w2) || ((w1 == w2) && (i1 < i2));
+                });
+                CounterRNG gen(seed_m ^ merge_stream, step_count_m, i_cell);
+                size_t k = 0;
+                while (k + merge_group <= order.size()) {
+                    double weight = 0.0;
+                    for (size_t j = 0; j < merge_group; ++j) {
+                        weight += particles_m[order[k + j]].weight();
+                    }
+                    if (0.5 * weight > max_weight_m) {
+                        break;
+                    }
+                    merge_particles(particles_m, &order[k], merge_group, random_direction(gen));
+                    for (size_t j = 2; j < merge_group; ++j) {
+                        particles_m[order[k + j]].set_weight(0.0);
+                    }
+                    k += merge_group;
+                }
+            }
+
+            // Split heavy particles near the foil until they weigh less
+            // than 2 -- no particle may weigh less than 1 -- and
+            // close the gaps the merges left.  The split pieces go after
+            // the survivors.
+            #pragma omp single
+            {
+                split_halves_m.clear();
+                size_t n = 0;
+                for (size_t i = 0; i < num_particles_m; ++i) {
+                    const Particle p(particles_m[i]);
+                    if (p.weight() == 0.0) {
+                        continue;
+                    }
+                    if ((p.weight() >= 2.0) && refine_zone_m.contains(Point(p.pos_x(), p.pos_y()))) {
+                        CounterRNG gen(seed_m ^ split_stream, step_count_m, i);
+                        size_t k = split_halves_m.size();
+                        split_halves_m.push_back(p);
+                        while (k < split_halves_m.size()) {
+                            if (split_halves_m[k].weight() >= 2.0) {
+                                Particle half;
+                                split_particle(
+                                    split_halves_m[k], half, random_direction(gen).scaled(split_offset));
+                                split_halves_m.push_back(half);
+                            } else {
+                                k += 1;
+                            }
+                        }
+                    } else {
+                        particles_m[n++] = p;
+                    }
+                }
+                for (const Particle& p : split_halves_m) {
+                    particles_m[n++] = p;
+                }
+                num_particles_m = n;
+            }
+        }
+    }
+
+    template void BasicWorld<float>::coarsen_if_due();
+    template void BasicWorld<double>::coarsen_if_due();
+    template void BasicWorld<float, MixedSpecies>::coarsen_if_due();
+    template void BasicWorld<double, MixedSpecies>::coarsen_if_due();
+    template void BasicWorld<float, WeightedSpecies>::coarsen_if_due();
+    template void BasicWorld<double, WeightedSpecies>::coarsen_if_due();
+}
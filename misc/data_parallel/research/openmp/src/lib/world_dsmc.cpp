@@ -0,0 +1,82 @@
+#include "world.h"
+
+#include <cmath>
+#include <random>
+
+#include "dsmc_cells.h"
+#include "rng.h"
+
+// DSMC pair collisions (see DsmcCells).  A cell's candidates are drawn
+// only from its own particles, so cells need no coloring: every cell
+// can be collided in parallel with every other.  Each cell draws from a
+// random stream keyed by step and cell, and cells list their particles
+// in ID order, so the results depend on neither the thread count nor
+// the storage order.
+
+namespace wingworks {
+    namespace {
+        // Keeps DSMC's streams apart from recycling's, which are keyed
+        // by step and particle ID.
+        const uint64_t dsmc_stream = 0x44534d43;  // "DSMC"
+    }
+
+    template <typename Real, typename Species>
+    void BasicWorld<Real, Species>::collide_dsmc() {
+        const size_t num_cells = cells_m.size();
+        #pragma omp for schedule(runtime)
+        for (size_t i_cell = 0; i_cell < num_cells; ++i_cell) {
+            collide_dsmc_cell(i_cell);
+        }
+    }
+
+    template <typename Real, typename Species>
+    void BasicWorld<Real, Species>::collide_dsmc_cell(const size_t i_cell) {
+        const Cell& cell = cells_m.cell(i_cell);
+        const size_t num_particles = cell.size();
+        const size_t num_candidates = dsmc_m->num_candidates(i_cell, num_particles);
+        if (num_candidates == 0) {
+            return;
+        }
+
+        CounterRNG gen(seed_m ^ dsmc_stream, step_count_m, i_cell);
+        std::uniform_int_distribution<size_t> first(0, num_particles - 1);
+        std::uniform_int_distribution<size_t> second(0, num_particles - 2);
+        std::uniform_real_distribution<> draw(0.0, 1.0);
+        std::uniform_real_distribution<> impact(-1.0, 1.0);
+
+        size_t colliding = 0;
+        for (size_t c = 0; c < num_candidates; ++c) {
+            const size_t i = first(gen);
+            size_t j = second(gen);
+            if (j >= i) {
+                j += 1;
+            }
+            Particle& p_i = particles_m[cell[i]];
+            Particle& p_j = particles_m[cell[j]];
+            const Vector vr(Vector(p_i.vel()).offset(Vector(p_j.vel())));
+            const double cr = vr.magnitude();
+            const double sigma = double(p_i.radius()) + double(p_j.radius());
+            if (!dsmc_m->accept(i_cell, sigma * cr, draw(gen))) {
+                continue;
+            }
+            // Hard disks meet with an impact parameter uniform across
+            // their collision diameter, which fixes the line of centers.
+            const double b = impact(gen);
+            const Vector along(vr.scaled(1.0 / cr));
+            const Vector normal(along.scaled(std::sqrt(1.0 - b * b)).adding(along.normal().scaled(b)));
+            p_i.collide_along(p_j, BasicPoint<Real>(normal));
+            colliding += 1;
+        }
+
+        if (cell_stats_m) {
+            cell_stats_m->record_pairs(i_cell, num_candidates, colliding);
+        }
+    }
+
+    template void BasicWorld<float>::collide_dsmc();
+    template void BasicWorld<double>::collide_dsmc();
+    template void BasicWorld<float, MixedSpecies>::collide_dsmc();
+    template void BasicWorld<double, MixedSpecies>::collide_dsmc();
+    template void BasicWorld<float, WeightedSpecies>::collide_dsmc();
+    template void BasicWorld<double, WeightedSpecies>::collide_dsmc();
+}
@@ -0,0 +1,130 @@
+#include "world.h"
+
+#include <omp.h>
+
+#include "airfoil_collision.h"
+
+// The Fused executor.  The Phased executor walks every particle three
+// times per step -- pair collisions, airfoil collisions, integration --
+// and once the world outgrows the cache, each walk streams all of the
+// particles in from memory again.  The Fused executor instead sweeps
+// once across the grid in tiles of cell columns, finishing all three
+// phases for a tile's particles while they are still in cache.
+//
+// It produces the same particle states as the Phased executor.  Each
+// particle must see the same sequence of pair collisions, which Phased
+// orders by color; so color k's window trails the sweep front by
+// s_k = 2 * reach * k columns.  A pair search spans 2 * reach + 1
+// columns, so two searches that share a particle are always done in
+// color order.  A particle is integrated only once the trailing window
+// of the last color has passed every search that can touch it.
+//
+// The sweep runs from right to left, over "mirrored" columns
+// m = num_horiz - 1 - col.  That makes no difference here, but a
+// particle recycled off the right edge reappears at the left, in
+// columns that the sweep has not yet reached.
+//
+// Locality comes from visiting cells in column order, so it is only as
+// good as the agreement between cell order and the order of particles
+// in memory.
+
+namespace wingworks {
+
+    namespace {
+        // Clip a window of mirrored columns [m_begin, m_end) to the grid,
+        // and map it back to ordinary columns [col_begin, col_end).
+        void to_columns(
+            const long num_horiz, long m_begin, long m_end,
+            size_t& col_begin, size_t& col_end)
+        {
+            m_begin = (m_begin > 0) ? m_begin : 0;
+            m_end = (m_end < num_horiz) ? m_end : num_horiz;
+            if (m_end <= m_begin) {
+                col_begin = col_end = 0;
+            } else {
+                col_begin = num_horiz - m_end;
+                col_end = num_horiz - m_begin;
+            }
+        }
+    }
+
+    template <typename Real, typename Species>
+    BasicWorld<Real, Species>::SweepGeometry::SweepGeometry(const WorldCells& cells, const size_t tile_columns)
+    : num_horiz(cells.num_horiz())
+    , reach(cells.reach())
+    , num_colors(cells.num_colors())
+    , tile(tile_columns)
+    , lag(2 * reach * (num_colors - 1) + reach)
+    , num_tiles((num_horiz + lag + tile - 1) / tile)
+    {}
+
+    template <typename Real, typename Species>
+    void BasicWorld<Real, Species>::collide_tile(const WorldCells& cells, const SweepGeometry& geom, const long t) {
+        size_t col_begin;
+        size_t col_end;
+        const long front = t * geom.tile;
+        for (long color = 0; color < geom.num_colors; ++color) {
+            const long shift = 2 * geom.reach * color;
+            to_columns(geom.num_horiz, front - shift, front + geom.tile - shift, col_begin, col_end);
+            collide_span(cells, cells.color_span(color, col_begin, col_end));
+        }
+    }
+
+    template <typename Real, typename Species>
+    CellSpan BasicWorld<Real, Species>::finished_cells(
+        const WorldCells& cells, const SweepGeometry& geom, const long t) const
+    {
+        size_t col_begin;
+        size_t col_end;
+        const long front = t * geom.tile;
+        to_columns(geom.num_horiz, front - geom.lag, front + geom.tile - geom.lag, col_begin, col_end);
+        return cells.column_span(col_begin, col_end);
+    }
+
+    template <typename Real, typename Species>
+    void BasicWorld<Real, Species>::fused_sweep() {
+        AirfoilCollision collider(airfoil_m);
+        SATPolyBatch& batch(*foil_batches_m[omp_get_thread_num()]);
+        Vector force;
+
+        const SweepGeometry geom(cells_m, tile_columns_m);
+        for (long t = 0; t < geom.num_tiles; ++t) {
+            collide_tile(cells_m, geom, t);
+
+            // No later search touches these particles, so threads may
+            // move on to the next tile while others finish here.
+            const CellSpan span(finished_cells(cells_m, geom, t));
+            const size_t num_cells = span.size();
+            #pragma omp for schedule(runtime) nowait
+            for (size_t k = 0; k < num_cells; ++k) {
+                const Cell& cell(cells_m.cell(span.cell(k)));
+                collide_with_airfoil(collider, batch, cell.data(), cell.size(), force);
+                for (const size_t i : cell) {
+                    integrate(particles_m[i], step_count_m, id_of_m[i]);
+                    if (incremental_cells_m) {
+                        track_migration(particles_m[i], i);
+                    }
+                }
+            }
+        }
+        add_force_on_foil(force);
+
+        // Recycling reads the step count; finish_step must wait.
+        #pragma omp barrier
+    }
+
+    // BasicWorld is instantiated in world.cpp; instantiate the members
+    // defined here.
+    template BasicWorld<float>::SweepGeometry::SweepGeometry(const WorldCells&, const size_t);
+    template BasicWorld<double>::SweepGeometry::SweepGeometry(const WorldCells&, const size_t);
+    template BasicWorld<float, MixedSpecies>::SweepGeometry::SweepGeometry(const WorldCells&, const size_t);
+    template BasicWorld<double, MixedSpecies>::SweepGeometry::SweepGeometry(const WorldCells&, const size_t);
+    template BasicWorld<float, WeightedSpecies>::SweepGeometry::SweepGeometry(const WorldCells&, const size_t);
+    template BasicWorld<double, WeightedSpecies>::SweepGeometry::SweepGeometry(const WorldCells&, const size_t);
+    template void BasicWorld<float>::fused_sweep();
+    template void BasicWorld<double>::fused_sweep();
+    template void BasicWorld<float, MixedSpecies>::fused_sweep();
+    template void BasicWorld<double, MixedSpecies>::fused_sweep();
+    template void BasicWorld<float, WeightedSpecies>::fused_sweep();
+    template void BasicWorld<double, WeightedSpecies>::fused_sweep();
+}
@@ -0,0 +1,148 @@
+#include "world.h"
+
+#include "neighbor_lists.h"
+
+// Pair collisions from NeighborLists.  The cells are rebuilt only when
+// the lists are, and still hold each particle's home cell as of the
+// last build.  Each particle's list names only particles in its home
+// cell or forward cells, so the cell colors still separate the work
+// into conflict-free parallel loops.
+
+namespace wingworks {
+
+    template <typename Real, typename Species>
+    void BasicWorld<Real, Species>::collide_listed_particles() {
+        if (neighbor_lists_m->update(particles_m)) {
+            assign_to_cells();
+            neighbor_lists_m->build(cells_m, particles_m, 2.0 * Species::max_radius());
+        }
+
+        const size_t num_colors = cells_m.num_colors();
+        for (size_t color = 0; color < num_colors; ++color) {
+            const CellSpan span(cells_m.color_span(color));
+            const size_t num_cells = span.size();
+            #pragma omp for schedule(runtime)
+            for (size_t k = 0; k < num_cells; ++k) {
+                collide_listed_cell(span.cell(k));
+            }
+        }
+
+        collide_strays();
+    }
+
+    template <typename Real, typename Species>
+    void BasicWorld<Real, Species>::collide_listed_cell(const size_t i_cell) {
+        const NeighborLists& lists(*neighbor_lists_m);
+        size_t tested = 0;
+        size_t colliding = 0;
+        for (const size_t i : cells_m.cell(i_cell)) {
+            if (lists.is_stray(i)) {
+                continue;
+            }
+            Particle& p_i = particles_m[i];
+            for (const size_t j : lists.neighbors(i)) {
+                if (!lists.is_stray(j)) {
+                    tested += 1;
+                    if (p_i.is_colliding_with(particles_m[j])) {
+                        colliding += 1;
+                        p_i.collide_with(particles_m[j]);
+                    }
+                }
+            }
+        }
+        if (cell_stats_m) {
+            cell_stats_m->record_pairs(i_cell, tested, colliding);
+        }
+    }
+
+    // A particle that is not a stray is within half the skin of its
+    // undrifted position when the lists were built, so searching the
+    // cells within reach of a stray's undrifted position finds every
+    // particle that may touch it.  The drift moves every particle alike,
+    // so two strays that touch also have undrifted positions within
+    // reach, and binning strays by undrifted position finds those pairs
+    // with a forward search.  Each stray cell's work stays within reach
+    // of it, so the cells of one nearby color (see WorldCells) run in
+    // parallel.  Orphaned worksharing.
+    template <typename Real, typename Species>
+    void BasicWorld<Real, Species>::collide_strays() {
+        const NeighborLists& lists(*neighbor_lists_m);
+        const size_t num_strays = lists.num_strays();
+        if (num_strays == 0) {
+            return;
+        }
+
+        WorldCells& stray_cells(*stray_cells_m);
+        stray_cells.clear();
+        #pragma omp single
+        {
+            const size_t *strays = lists.strays();
+            for (size_t a = 0; a < num_strays; ++a) {
+                const Point pos(lists.undrifted(Point(particles_m[strays[a]].pos())));
+                stray_cells.add_to(stray_cells.index_of(pos.x(), pos.y()), strays[a]);
+            }
+        }
+
+        const size_t num_colors = stray_cells.num_nearby_colors();
+        for (size_t color = 0; color < num_colors; ++color) {
+            const CellSpan span(stray_cells.nearby_color_span(color));
+            const size_t num_cells = span.size();
+            #pragma omp for schedule(runtime)
+            for (size_t k = 0; k < num_cells; ++k) {
+                collide_stray_cell(span.cell(k));
+            }
+        }
+    }
+
+    // stray_cells_m shares cells_m's grid, so i_cell indexes both.
+    template <typename Real, typename Species>
+    void BasicWorld<Real, Species>::collide_stray_cell(const size_t i_cell) {
+        const NeighborLists& lists(*neighbor_lists_m);
+        const WorldCells& stray_cells(*stray_cells_m);
+        const Cell& cell = stray_cells.cell(i_cell);
+        const size_t num_strays = cell.size();
+        if (num_strays == 0) {
+            return;
+        }
+
+        size_t tested = 0;
+        size_t colliding = 0;
+        auto collide_pair = [&tested, &colliding](Particle& p_i, Particle& p_j) {
+            tested += 1;
+            if (p_i.is_colliding_with(p_j)) {
+                colliding += 1;
+                p_i.collide_with(p_j);
+            }
+        };
+
+        for (size_t a = 0; a < num_strays; ++a) {
+            Particle& stray = particles_m[cell[a]];
+            for (size_t b = a + 1; b < num_strays; ++b) {
+                collide_pair(stray, particles_m[cell[b]]);
+            }
+            stray_cells.for_each_forward_neighbor(i_cell, [&](const size_t i_other) {
+                for (const size_t j : stray_cells.cell(i_other)) {
+                    collide_pair(stray, particles_m[j]);
+                }
+            });
+            cells_m.for_each_nearby(i_cell, [&](const size_t i_other) {
+                for (const size_t j : cells_m.cell(i_other)) {
+                    if (!lists.is_stray(j)) {
+                        collide_pair(stray, particles_m[j]);
+                    }
+                }
+            });
+        }
+
+        if (cell_stats_m) {
+            cell_stats_m->record_pairs(i_cell, tested, colliding);
+        }
+    }
+
+    template void BasicWorld<float>::collide_listed_particles();
+    template void BasicWorld<double>::collide_listed_particles();
+    template void BasicWorld<float, MixedSpecies>::collide_listed_particles();
+    template void BasicWorld<double, MixedSpecies>::collide_listed_particles();
+    template void BasicWorld<float, WeightedSpecies>::collide_listed_particles();
+    template void BasicWorld<double, WeightedSpecies>::collide_listed_particles();
+}
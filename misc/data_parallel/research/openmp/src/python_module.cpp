@@ -0,0 +1,509 @@
+// A Python extension module, wingworks, for building and stepping
+// Worlds from Python and reading their state without copying it.
+//
+//     import numpy as np
+//     import wingworks
+//
+//     world = wingworks.World(128.0, 72.0, seed=1)
+//     world.step_many(100)          # Releases the GIL
+//     pos = np.asarray(world.positions)       # (N, 2), aliases the World
+//     vel = np.asarray(world.velocities)      # (N, 2)
+//     ids = np.asarray(world.ids)             # (N,)
+//     fx, fy = world.force_on_foil
+//
+// Views alias the World's particle storage, in storage order: row i is
+// the particle whose ID is ids[i].  Without reordering, that is ID
+// order.  Views are read-only, and keep their World alive.  A World
+// that reorders its storage moves its particles, so take views afresh
+// after stepping.  A World can't be initialized twice.
+//
+// Written against the plain C API, and the buffer protocol, so that it
+// needs neither pybind11 nor NumPy to build.
+
+#define PY_SSIZE_T_CLEAN
+#include <Python.h>
+
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+
+#include "airfoil.h"
+#include "world.h"
+
+using namespace wingworks;
+
+namespace {
+    // The module's view of a World, whatever its precision.
+    class WorldHandle {
+    public:
+        virtual ~WorldHandle() {}
+
+        virtual void step_many(const size_t num_steps) = 0;
+        virtual size_t num_particles() const = 0;
+        virtual size_t step_count() const = 0;
+        virtual double momentum() const = 0;
+        virtual const Vector& force_on_foil() const = 0;
+        virtual void reset_force_on_foil() = 0;
+
+        // Particle storage, and where each particle keeps its state.
+        virtual const char *storage() const = 0;
+        virtual const size_t *storage_ids() const = 0;
+        virtual size_t particle_bytes() const = 0;
+        virtual size_t pos_offset() const = 0;
+        virtual size_t vel_offset() const = 0;
+        // Buffer protocol format and size of one coordinate.
+        virtual const char *real_format() const = 0;
+        virtual size_t real_bytes() const = 0;
+    };
+
+    template <typename Real>
+    class WorldHandleOf : public WorldHandle {
+    public:
+        using Particle = typename BasicWorld<Real>::Particle;
+
+        WorldHandleOf(
+            const Airfoil& foil, const double width, const double height,
+            const double max_speed, const Vector& wind, const WorldOptions& options)
+        : world_m(foil, width, height, max_speed, wind, options)
+        {
+            static_assert(sizeof(BasicPoint<Real>) == 2 * sizeof(Real),
+                          "Views take a point's coordinates to be adjacent.");
+        }
+
+        void step_many(const size_t num_steps) override { world_m.step_many(num_steps); }
+        size_t num_particles() const override { return world_m.num_particles(); }
+        size_t step_count() const override { return world_m.step_count(); }
+        double momentum() const override { return world_m.momentum(); }
+        const Vector& force_on_foil() const override { return world_m.force_on_foil(); }
+        void reset_force_on_foil() override { world_m.reset_force_on_foil(); }
+
+        const char *storage() const override {
+            return (const char *)world_m.particle_storage();
+        }
+        const size_t *storage_ids() const override { return world_m.storage_ids(); }
+        size_t particle_bytes() const override { return sizeof(Particle); }
+        size_t pos_offset() const override {
+            const Particle *p = world_m.particle_storage();
+            return (const char *)&p->pos() - (const char *)p;
+        }
+        size_t vel_offset() const override {
+            const Particle *p = world_m.particle_storage();
+            return (const char *)&p->vel() - (const char *)p;
+        }
+        const char *real_format() const override {
+            return std::is_same<Real, float>::value ? "f" : "d";
+        }
+        size_t real_bytes() const override { return sizeof(Real); }
+
+    private:
+        BasicWorld<Real> world_m;
+    };
+
+    struct PyWorld {
+        PyObject_HEAD
+        WorldHandle *handle;
+        // Set while step_many runs without the GIL.
+        bool stepping;
+    };
+
+    // A read-only, possibly strided, view of memory owned by a World.
+    struct PyStateArray {
+        PyObject_HEAD
+        PyObject *owner;
+        const char *data;
+        int ndim;
+        Py_ssize_t shape[2];
+        Py_ssize_t strides[2];
+        const char *format;
+        Py_ssize_t itemsize;
+    };
+
+    PyTypeObject *world_type = nullptr;
+    PyTypeObject *state_array_type = nullptr;
+
+    // Translate the engine's exceptions into Python's.
+    void set_python_error(const std::exception& e) {
+        if (dynamic_cast<const std::invalid_argument *>(&e)) {
+            PyErr_SetString(PyExc_ValueError, e.what());
+        } else {
+            PyErr_SetString(PyExc_RuntimeError, e.what());
+        }
+    }
+
+    // State arrays ---------------------------------------------------
+
+    int state_array_getbuffer(PyObject *self, Py_buffer *view, int flags) {
+        PyStateArray *array = (PyStateArray *)self;
+        if (flags & PyBUF_WRITABLE) {
+            PyErr_SetString(PyExc_BufferError, "World state is read-only.");
+            return -1;
+        }
+        if ((array->ndim > 1) && !((flags & PyBUF_STRIDES) == PyBUF_STRIDES)) {
+            PyErr_SetString(PyExc_BufferError, "World state views are strided.");
+            return -1;
+        }
+        view->obj = self;
+        Py_INCREF(self);
+        view->buf = (void *)array->data;
+        view->len = array->itemsize;
+        for (int d = 0; d < array->ndim; ++d) {
+            view->len *= array->shape[d];
+        }
+        view->readonly = 1;
+        view->itemsize = array->itemsize;
+        view->format = (flags & PyBUF_FORMAT) ? (char *)array->format : nullptr;
+        view->ndim = array->ndim;
+        view->shape = array->shape;
+        view->strides = ((flags & PyBUF_STRIDES) == PyBUF_STRIDES) ? array->strides : nullptr;
+        view->suboffsets = nullptr;
+        view->internal = nullptr;
+        return 0;
+    }
+
+    void state_array_dealloc(PyObject *self) {
+        PyTypeObject *type = Py_TYPE(self);
+        Py_XDECREF(((PyStateArray *)self)->owner);
+        type->tp_free(self);
+        Py_DECREF(type);
+    }
+
+    PyType_Slot state_array_slots[] = {
+        {Py_bf_getbuffer, (void *)state_array_getbuffer},
+        {Py_tp_dealloc, (void *)state_array_dealloc},
+        {Py_tp_doc, (void *)"A read-only view of a World's state."},
+        {0, nullptr}
+    };
+
+    PyType_Spec state_array_spec = {
+        "wingworks._StateArray", sizeof(PyStateArray), 0, Py_TPFLAGS_DEFAULT, state_array_slots
+    };
+
+    // Return a memoryview of an array of num_rows rows, each row_bytes
+    // apart, of num_cols items -- or, if num_cols is 0, one item.
+    PyObject *make_view(
+        PyObject *owner, const char *data, const Py_ssize_t num_rows, const Py_ssize_t row_bytes,
+        const Py_ssize_t num_cols, const char *format, const Py_ssize_t itemsize)
+    {
+        PyStateArray *array = PyObject_New(PyStateArray, state_array_type);
+        if (!array) {
+            return nullptr;
+        }
+        Py_INCREF(owner);
+        array->owner = owner;
+        array->data = data;
+        array->ndim = (num_cols > 0) ? 2 : 1;
+        array->shape[0] = num_rows;
+        array->shape[1] = num_cols;
+        array->strides[0] = row_bytes;
+        array->strides[1] = itemsize;
+        array->format = format;
+        array->itemsize = itemsize;
+        PyObject *result = PyMemoryView_FromObject((PyObject *)array);
+        Py_DECREF(array);
+        return result;
+    }
+
+    // Worlds ----------------------------------------------------------
+
+    bool parse_pair(PyObject *obj, const char *what, double& a, double& b) {
+        if (!PyArg_ParseTuple(obj, "dd", &a, &b)) {
+            PyErr_Format(PyExc_TypeError, "%s must be a pair of numbers.", what);
+            return false;
+        }
+        return true;
+    }
+
+    int world_init(PyObject *self, PyObject *args, PyObject *kwargs) {
+        static const char *keywords[] = {
+            "width", "height", "max_speed", "wind", "foil", "seed",
+            "cell_extent", "num_threads", "executor", "tile_columns",
+            "neighbor_lists", "incremental_cells", "reorder_interval",
+            "balance_cells", "single", nullptr
+        };
+        PyWorld *world = (PyWorld *)self;
+        double width = 0.0, height = 0.0, max_speed = 0.0005;
+        PyObject *wind_obj = nullptr, *foil_obj = nullptr, *seed_obj = Py_None;
+        const char *executor = "phased";
+        WorldOptions options;
+        Py_ssize_t num_threads = 0, tile_columns = options.tile_columns;
+        Py_ssize_t reorder_interval = 0;
+        int neighbor_lists = 0, incremental_cells = 0;
+        int balance_cells = 0, single = 0;
+        if (!PyArg_ParseTupleAndKeywords(
+                args, kwargs, "dd|$dOOOdnsnppnpp", (char **)keywords,
+                &width, &height, &max_speed, &wind_obj, &foil_obj, &seed_obj,
+                &options.cell_extent, &num_threads, &executor, &tile_columns,
+                &neighbor_lists, &incremental_cells, &reorder_interval,
+                &balance_cells, &single)) {
+            return -1;
+        }
+        if ((num_threads < 0) || (tile_columns < 0) || (reorder_interval < 0)) {
+            PyErr_SetString(PyExc_ValueError, "Counts must not be negative.");
+            return -1;
+        }
+
+        double wind_x = 0.11, wind_y = 0.0;
+        if (wind_obj && !parse_pair(wind_obj, "wind", wind_x, wind_y)) {
+            return -1;
+        }
+        // Like the demo's foil, unless given as (left, bottom, width,
+        // angle of attack in radians).
+        double foil_left = width / 8.0, foil_bottom = height / 2.0;
+        double foil_width = width / 4.0, aoa_rad = 10.0 * M_PI / 180.0;
+        if (foil_obj && !PyArg_ParseTuple(
+                foil_obj, "dddd", &foil_left, &foil_bottom, &foil_width, &aoa_rad)) {
+            return -1;
+        }
+        if (seed_obj != Py_None) {
+            options.seed = PyLong_AsUnsignedLongLongMask(seed_obj);
+            if (PyErr_Occurred()) {
+                return -1;
+            }
+        }
+        const std::string executor_name(executor);
+        if (executor_name == "phased") {
+            options.executor = StepExecutor::Phased;
+        } else if (executor_name == "fused") {
+            options.executor = StepExecutor::Fused;
+        } else {
+            PyErr_Format(PyExc_ValueError, "Unknown executor: %s", executor);
+            return -1;
+        }
+        options.num_threads = num_threads;
+        options.tile_columns = tile_columns;
+        options.neighbor_lists = neighbor_lists;
+        options.incremental_cells = incremental_cells;
+        options.reorder_interval = reorder_interval;
+        options.balance_cells = balance_cells;
+
+        // Views point into the World's particles, and keep only this
+        // object alive, so the World can't be replaced under them.
+        if (world->handle) {
+            PyErr_SetString(PyExc_RuntimeError, "The World is already initialized.");
+            return -1;
+        }
+        try {
+            const Airfoil foil(foil_left, foil_bottom, foil_width, aoa_rad);
+            const Vector wind(wind_x, wind_y);
+            WorldHandle *handle = single
+                ? (WorldHandle *)new WorldHandleOf<float>(
+                    foil, width, height, max_speed, wind, options)
+                : (WorldHandle *)new WorldHandleOf<double>(
+                    foil, width, height, max_speed, wind, options);
+            world->handle = handle;
+        } catch (const std::exception& e) {
+            set_python_error(e);
+            return -1;
+        }
+        return 0;
+    }
+
+    void world_dealloc(PyObject *self) {
+        PyTypeObject *type = Py_TYPE(self);
+        delete ((PyWorld *)self)->handle;
+        type->tp_free(self);
+        Py_DECREF(type);
+    }
+
+    PyObject *world_new(PyTypeObject *type, PyObject *, PyObject *) {
+        PyWorld *self = (PyWorld *)type->tp_alloc(type, 0);
+        if (self) {
+            self->handle = nullptr;
+            self->stepping = false;
+        }
+        return (PyObject *)self;
+    }
+
+    // Returns the World's handle, or sets an exception and returns
+    // nullptr if the World can't be used just now.
+    WorldHandle *usable_handle(PyObject *self) {
+        PyWorld *world = (PyWorld *)self;
+        if (!world->handle) {
+            PyErr_SetString(PyExc_RuntimeError, "The World was not initialized.");
+            return nullptr;
+        }
+        if (world->stepping) {
+            PyErr_SetString(PyExc_RuntimeError, "The World is stepping.");
+            return nullptr;
+        }
+        return world->handle;
+    }
+
+    // Other Python threads may run meanwhile, but may not use this
+    // World; see usable_handle.
+    PyObject *world_step_many(PyObject *self, PyObject *args) {
+        Py_ssize_t num_steps = 0;
+        if (!PyArg_ParseTuple(args, "n", &num_steps)) {
+            return nullptr;
+        }
+        if (num_steps < 0) {
+            PyErr_SetString(PyExc_ValueError, "Step count must not be negative.");
+            return nullptr;
+        }
+        WorldHandle *handle = usable_handle(self);
+        if (!handle) {
+            return nullptr;
+        }
+        PyWorld *world = (PyWorld *)self;
+        world->stepping = true;
+        bool failed = false;
+        std::string message;
+        Py_BEGIN_ALLOW_THREADS
+        try {
+            handle->step_many(num_steps);
+        } catch (const std::exception& e) {
+            failed = true;
+            message = e.what();
+        }
+        Py_END_ALLOW_THREADS
+        world->stepping = false;
+        if (failed) {
+            PyErr_SetString(PyExc_RuntimeError, message.c_str());
+            return nullptr;
+        }
+        Py_RETURN_NONE;
+    }
+
+    PyObject *world_step(PyObject *self, PyObject *) {
+        PyObject *args = Py_BuildValue("(n)", Py_ssize_t(1));
+        PyObject *result = world_step_many(self, args);
+        Py_DECREF(args);
+        return result;
+    }
+
+    PyObject *world_momentum(PyObject *self, PyObject *) {
+        WorldHandle *handle = usable_handle(self);
+        return handle ? PyFloat_FromDouble(handle->momentum()) : nullptr;
+    }
+
+    PyObject *world_reset_force_on_foil(PyObject *self, PyObject *) {
+        WorldHandle *handle = usable_handle(self);
+        if (!handle) {
+            return nullptr;
+        }
+        handle->reset_force_on_foil();
+        Py_RETURN_NONE;
+    }
+
+    PyObject *world_get_num_particles(PyObject *self, void *) {
+        WorldHandle *handle = usable_handle(self);
+        return handle ? PyLong_FromSize_t(handle->num_particles()) : nullptr;
+    }
+
+    PyObject *world_get_step_count(PyObject *self, void *) {
+        WorldHandle *handle = usable_handle(self);
+        return handle ? PyLong_FromSize_t(handle->step_count()) : nullptr;
+    }
+
+    PyObject *world_get_positions(PyObject *self, void *) {
+        WorldHandle *handle = usable_handle(self);
+        if (!handle) {
+            return nullptr;
+        }
+        return make_view(
+            self, handle->storage() + handle->pos_offset(), handle->num_particles(),
+            handle->particle_bytes(), 2, handle->real_format(), handle->real_bytes());
+    }
+
+    PyObject *world_get_velocities(PyObject *self, void *) {
+        WorldHandle *handle = usable_handle(self);
+        if (!handle) {
+            return nullptr;
+        }
+        return make_view(
+            self, handle->storage() + handle->vel_offset(), handle->num_particles(),
+            handle->particle_bytes(), 2, handle->real_format(), handle->real_bytes());
+    }
+
+    PyObject *world_get_ids(PyObject *self, void *) {
+        WorldHandle *handle = usable_handle(self);
+        if (!handle) {
+            return nullptr;
+        }
+        const char *format = (sizeof(size_t) == sizeof(unsigned long)) ? "L" : "Q";
+        return make_view(
+            self, (const char *)handle->storage_ids(), handle->num_particles(),
+            sizeof(size_t), 0, format, sizeof(size_t));
+    }
+
+    PyObject *world_get_force_on_foil(PyObject *self, void *) {
+        WorldHandle *handle = usable_handle(self);
+        if (!handle) {
+            return nullptr;
+        }
+        const Vector& force(handle->force_on_foil());
+        static_assert(sizeof(Vector) == 2 * sizeof(double),
+                      "The force view takes its coordinates to be adjacent.");
+        return make_view(self, (const char *)&force, 2, sizeof(double), 0, "d", sizeof(double));
+    }
+
+    PyMethodDef world_methods[] = {
+        {"step_many", world_step_many, METH_VARARGS,
+         "step_many(num_steps)\n\nAdvance num_steps steps, releasing the GIL meanwhile."},
+        {"step", world_step, METH_NOARGS, "Advance one step."},
+        {"momentum", world_momentum, METH_NOARGS, "Total momentum of the particles."},
+        {"reset_force_on_foil", world_reset_force_on_foil, METH_NOARGS,
+         "Zero the force accumulated on the foil."},
+        {nullptr, nullptr, 0, nullptr}
+    };
+
+    PyGetSetDef world_getset[] = {
+        {"num_particles", world_get_num_particles, nullptr, "Number of particles.", nullptr},
+        {"step_count", world_get_step_count, nullptr, "Steps taken so far.", nullptr},
+        {"positions", world_get_positions, nullptr,
+         "Particle positions, (num_particles, 2), in storage order.", nullptr},
+        {"velocities", world_get_velocities, nullptr,
+         "Particle velocities, (num_particles, 2), in storage order.", nullptr},
+        {"ids", world_get_ids, nullptr, "The ID of the particle in each storage slot.", nullptr},
+        {"force_on_foil", world_get_force_on_foil, nullptr,
+         "Force on the foil, (2,), since it was last reset.", nullptr},
+        {nullptr, nullptr, nullptr, nullptr, nullptr}
+    };
+
+    PyType_Slot world_slots[] = {
+        {Py_tp_new, (void *)world_new},
+        {Py_tp_init, (void *)world_init},
+        {Py_tp_dealloc, (void *)world_dealloc},
+        {Py_tp_methods, world_methods},
+        {Py_tp_getset, world_getset},
+        {Py_tp_doc, (void *)
+         "World(width, height, *, max_speed=0.0005, wind=(0.11, 0.0), foil=None, seed=None,\n"
+         "      cell_extent=1.0, num_threads=0, executor='phased', tile_columns=16,\n"
+         "      neighbor_lists=False, incremental_cells=False, reorder_interval=0,\n"
+         "      balance_cells=False, single=False)\n\n"
+         "A World of particles flowing past an airfoil.  foil is (left, bottom, width,\n"
+         "angle of attack in radians); by default it is placed as in the demo.  single\n"
+         "stores particles as float rather than double."},
+        {0, nullptr}
+    };
+
+    PyType_Spec world_spec = {
+        "wingworks.World", sizeof(PyWorld), 0, Py_TPFLAGS_DEFAULT, world_slots
+    };
+
+    PyModuleDef module_def = {
+        PyModuleDef_HEAD_INIT, "wingworks",
+        "Particles flowing past an airfoil, stepped in C++ with OpenMP.",
+        -1, nullptr, nullptr, nullptr, nullptr, nullptr
+    };
+}
+
+PyMODINIT_FUNC PyInit_wingworks() {
+    PyObject *module = PyModule_Create(&module_def);
+    if (!module) {
+        return nullptr;
+    }
+    state_array_type = (PyTypeObject *)PyType_FromSpec(&state_array_spec);
+    world_type = (PyTypeObject *)PyType_FromSpec(&world_spec);
+    if (!state_array_type || !world_type
+        || (PyModule_AddObject(module, "World", (PyObject *)world_type) < 0)) {
+        Py_XDECREF(state_array_type);
+        Py_XDECREF(world_type);
+        Py_DECREF(module);
+        return nullptr;
+    }
+    // The module keeps the state array type alive through state_array_type.
+    return module;
+}
@@ -0,0 +1,97 @@
+#include <iostream>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <stdexcept>
+#include <string>
+
+#include <mpi.h>
+
+#include "point.h"
+#include "airfoil.h"
+#include "slab_world.h"
+
+using namespace std;
+using namespace wingworks;
+using namespace std::chrono;
+
+// Run the demo's world, scaled up, across MPI ranks, reporting the force
+// on the foil and the time per step.  No particle output: the worlds
+// this is for are too big to write out.
+//
+// Usage: mpirun -np <ranks> slab_demo [--scale <k>] [--steps <n>] [--single]
+// A scale of k makes the world k times as wide and high.
+namespace {
+    struct SlabDemoArgs {
+        double scale = 1.0;
+        size_t steps = 100;
+        bool single_precision = false;
+    };
+
+    SlabDemoArgs parse_args(int argc, char **argv) {
+        SlabDemoArgs result;
+        for (int i = 1; i < argc; ++i) {
+            const string arg(argv[i]);
+            if ((arg == "--scale") && (i + 1 < argc)) {
+                result.scale = ::atof(argv[++i]);
+            } else if ((arg == "--steps") && (i + 1 < argc)) {
+                result.steps = ::atoi(argv[++i]);
+            } else if (arg == "--single") {
+                result.single_precision = true;
+            } else {
+                throw invalid_argument("Unknown argument: " + arg);
+            }
+        }
+        return result;
+    }
+
+    template <typename Real>
+    void run(const SlabDemoArgs& args) {
+        const double world_width = 128.0 * args.scale;
+        const double world_height = 72.0 * args.scale;
+        const Airfoil airfoil(
+            world_width / 8.0, world_height / 2.0,
+            world_width / 4.0,
+            10.0 * M_PI / 180.0
+        );
+        WorldOptions options;
+        options.seed = 1;
+
+        BasicSlabWorld<Real> world(
+            MPI_COMM_WORLD, airfoil, world_width, world_height, 0.0005, Point(0.11, 0.0),
+            options);
+        if (world.rank() == 0) {
+            cout << "Number of particles: " << world.num_particles()
+                 << " on " << world.num_ranks() << " ranks" << endl;
+        }
+
+        const size_t report_every = 10;
+        steady_clock::time_point t0 = steady_clock::now();
+        for (size_t done = 0; done < args.steps; done += report_every) {
+            world.step_many(min(report_every, args.steps - done));
+            const Vector force(world.force_on_foil());
+            world.reset_force_on_foil();
+
+            steady_clock::time_point tf = steady_clock::now();
+            const duration<double> dt = duration_cast<duration<double>>(tf - t0);
+            t0 = tf;
+            if (world.rank() == 0) {
+                cout << "Step " << world.step_count()
+                     << ": force on foil = " << force.scaled(-1.0).to_str()
+                     << "; " << dt.count() / report_every << " seconds/step" << endl;
+            }
+        }
+    }
+}
+
+int main(int argc, char **argv) {
+    MPI_Init(&argc, &argv);
+    const SlabDemoArgs args(parse_args(argc, argv));
+    if (args.single_precision) {
+        run<float>(args);
+    } else {
+        run<double>(args);
+    }
+    MPI_Finalize();
+    return 0;
+}
@@ -0,0 +1,304 @@
+// Short, fixed-seed performance workloads.  Each run measures the
+// throughput of one workload and compares it against a baseline file:
+//
+//     perf_workloads <workload> <baseline-file> <tolerance> [--update]
+//
+// A workload whose throughput falls more than <tolerance> (a fraction,
+// e.g. 0.05) below its baseline fails, and so does one with no baseline
+// entry.  --update records the entry, overwriting any there was.
+//
+// Only the work itself is timed: each trial first builds its World or
+// particles, untimed.
+//
+// Throughput is normalized by a fixed reference loop timed alongside each
+// trial, so that a machine which is busy or throttled for the whole run
+// does not read as a regression.
+
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <map>
+#include <vector>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <random>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+
+#include "point.h"
+#include "particle.h"
+#include "airfoil.h"
+#include "airfoil_collision.h"
+#include "world.h"
+
+using namespace std;
+using namespace wingworks;
+using namespace std::chrono;
+
+namespace {
+    const uint64_t seed = 20211231;
+    const size_t num_trials = 9;
+
+    // A trial: runs the work once and returns the number of units done.
+    using Trial = function<double()>;
+
+    struct Workload {
+        // What one unit of work is, for reporting.
+        string units;
+        // Sets up a trial, which alone is timed.
+        function<Trial()> prepare;
+    };
+
+    Airfoil make_airfoil(const double world_width, const double world_height) {
+        const double aoa_rad = 10.0 * M_PI / 180.0;
+        return Airfoil(
+            world_width / 8.0, world_height / 2.0, world_width / 4.0, aoa_rad);
+    }
+
+    World make_world(WorldOptions options = WorldOptions()) {
+        const double width = 32.0;
+        const double height = 18.0;
+        options.seed = seed;
+        return World(
+            make_airfoil(width, height), width, height, 0.0005,
+            Vector(0.11, 0.0), options);
+    }
+
+    const size_t num_world_steps = 10;
+
+    Trial prepare_world_step() {
+        shared_ptr<World> world(new World(make_world()));
+        return [world]() {
+            for (size_t i = 0; i < num_world_steps; ++i) {
+                world->step();
+            }
+            return double(num_world_steps * world->num_particles());
+        };
+    }
+
+    Trial prepare_world_step_many(const StepExecutor executor) {
+        WorldOptions options;
+        options.executor = executor;
+        shared_ptr<World> world(new World(make_world(options)));
+        return [world]() {
+            world->step_many(num_world_steps);
+            return double(num_world_steps * world->num_particles());
+        };
+    }
+
+    Trial prepare_particle_collision() {
+        mt19937 gen(seed);
+        uniform_real_distribution<> prand(-0.6, 0.6);
+        uniform_real_distribution<> vrand(-0.1, 0.1);
+
+        const size_t num_particles = 4096;
+        shared_ptr<vector<Particle>> storage(new vector<Particle>(num_particles));
+        for (Particle& p : *storage) {
+            p.move_to(prand(gen), prand(gen));
+            p.set_vel(vrand(gen), vrand(gen));
+        }
+
+        return [storage]() {
+            vector<Particle>& particles(*storage);
+            const size_t num_passes = 1024;
+            size_t num_pairs = 0;
+            for (size_t pass = 0; pass < num_passes; ++pass) {
+                for (size_t i = 0; i + 1 < num_particles; i += 2) {
+                    Particle& p_i(particles[i]);
+                    Particle& p_j(particles[(i + 1 + 2 * pass) % num_particles]);
+                    if (p_i.is_colliding_with(p_j)) {
+                        p_i.collide_with(p_j);
+                    }
+                    num_pairs += 1;
+                }
+            }
+            return double(num_pairs);
+        };
+    }
+
+    Trial prepare_airfoil_collision() {
+        const double width = 64.0;
+        const double height = 36.0;
+        const Airfoil foil(make_airfoil(width, height));
+
+        // Concentrate particles around the foil, where the SAT tests
+        // cannot exit early on the bounding box.
+        BBox near(foil.shape().bbox());
+        near.extend_bounds(0.2);
+        mt19937 gen(seed);
+        uniform_real_distribution<> xrand(near.xmin(), near.xmin() + near.width());
+        uniform_real_distribution<> yrand(near.ymin(), near.ymin() + near.height());
+
+        const size_t num_particles = 16384;
+        shared_ptr<vector<Particle>> storage(new vector<Particle>(num_particles));
+        for (Particle& p : *storage) {
+            p.move_to(xrand(gen), yrand(gen));
+            p.set_vel(0.11, 0.0);
+        }
+
+        return [storage, foil]() {
+            AirfoilCollision collider(foil);
+            vector<Particle>& particles(*storage);
+            const size_t num_passes = 32;
+            for (size_t pass = 0; pass < num_passes; ++pass) {
+                for (Particle& particle : particles) {
+                    Vector recoil_vec;
+                    if (collider.is_colliding(particle, recoil_vec)) {
+                        collider.resolve_collision(particle, recoil_vec);
+                    }
+                }
+            }
+            return double(num_passes * particles.size());
+        };
+    }
+
+    map<string, Workload> workloads() {
+        return {
+            {"world_step", {"particle-steps", prepare_world_step}},
+            {"world_step_many", {"particle-steps", []() {
+                return prepare_world_step_many(StepExecutor::Phased);
+            }}},
+            {"world_step_fused", {"particle-steps", []() {
+                return prepare_world_step_many(StepExecutor::Fused);
+            }}},
+            {"particle_collision", {"pairs", prepare_particle_collision}},
+            {"airfoil_collision", {"particles", prepare_airfoil_collision}},
+        };
+    }
+
+    // A dependent floating-point chain plus a streaming sum: a rough
+    // stand-in for the mix of latency- and bandwidth-bound work in a step.
+    double run_reference() {
+        const size_t num_iters = 4000000;
+        volatile double chain = 0.0;
+        for (size_t i = 0; i < num_iters; ++i) {
+            chain = chain * 0.999 + 1.0;
+        }
+        const vector<double> values(1 << 20, 1.0);
+        double sum = 0.0;
+        for (size_t pass = 0; pass < 4; ++pass) {
+            for (const double v : values) {
+                sum += v;
+            }
+        }
+        return (sum > 0.0) ? 1.0 : 0.0;
+    }
+
+    double throughput_of(const function<double()>& run) {
+        steady_clock::time_point t0 = steady_clock::now();
+        const double units = run();
+        duration<double> dt = steady_clock::now() - t0;
+        return units / dt.count();
+    }
+
+    struct Measurement {
+        double throughput;
+        double reference;
+
+        double normalized() const { return throughput / reference; }
+    };
+
+    // Best-of-N: the fastest trial is the least disturbed by the rest
+    // of the machine.
+    Measurement measure(const Workload& workload) {
+        Measurement best {0.0, 0.0};
+        for (size_t i = 0; i < num_trials; ++i) {
+            const double reference = throughput_of(run_reference);
+            best.reference = (reference > best.reference) ? reference : best.reference;
+            const double throughput = throughput_of(workload.prepare());
+            best.throughput = (throughput > best.throughput) ? throughput : best.throughput;
+        }
+        return best;
+    }
+
+    map<string, double> read_baseline(const string& path) {
+        map<string, double> result;
+        ifstream inf(path);
+        string line;
+        while (getline(inf, line)) {
+            if (line.empty() || line[0] == '#') {
+                continue;
+            }
+            istringstream ins(line);
+            string name;
+            double value;
+            if (ins >> name >> value) {
+                result[name] = value;
+            }
+        }
+        return result;
+    }
+
+    void write_baseline(const string& path, const map<string, double>& values) {
+        ofstream outf(path);
+        outf << "# workload normalized-throughput" << endl;
+        for (const auto& entry : values) {
+            outf << entry.first << " " << setprecision(6) << entry.second << endl;
+        }
+    }
+}
+
+int main(int argc, char **argv) {
+    if (argc < 4) {
+        cerr << "Usage: " << argv[0]
+             << " <workload> <baseline-file> <tolerance> [--update]" << endl;
+        return 2;
+    }
+    const string name(argv[1]);
+    const string baseline_path(argv[2]);
+    const double tolerance = ::atof(argv[3]);
+    const bool update = (argc > 4) && (0 == ::strcmp(argv[4], "--update"));
+
+    const map<string, Workload> all_workloads(workloads());
+    const auto found = all_workloads.find(name);
+    if (found == all_workloads.end()) {
+        cerr << "Unknown workload: " << name << endl;
+        return 2;
+    }
+    const Workload& workload(found->second);
+
+    map<string, double> baseline(read_baseline(baseline_path));
+    const auto prev = baseline.find(name);
+    if (!update && (prev == baseline.end())) {
+        cerr << "perf " << name << ": no baseline in " << baseline_path
+             << ".  Record one with --update, review it, and commit it." << endl;
+        return 1;
+    }
+
+    const Measurement measured = measure(workload);
+    const double score = measured.normalized();
+    if (update) {
+        baseline[name] = score;
+        write_baseline(baseline_path, baseline);
+        cout << "perf " << name << ": " << measured.throughput << " "
+             << workload.units << "/s (normalized " << score
+             << ") recorded as baseline in " << baseline_path << endl;
+        return 0;
+    }
+
+    const double expected = prev->second;
+    const double change = (score - expected) / expected;
+    const bool ok = (change >= -tolerance);
+
+    cout << endl
+         << "perf " << name << ": " << (ok ? "PASS" : "FAIL") << endl
+         << "    measured:   " << measured.throughput << " " << workload.units
+         << "/s (best of " << num_trials << ")" << endl
+         << "    normalized: " << score << endl
+         << "    baseline:   " << expected << endl
+         << "    change:     " << showpos << fixed << setprecision(1)
+         << (100.0 * change) << "%" << noshowpos
+         << " (tolerance -" << (100.0 * tolerance) << "%)" << endl;
+    if (!ok) {
+        cout << "    " << name << " is slower than its baseline.  If the"
+             << " slowdown is intended, re-run with --update." << endl;
+    } else if (change > tolerance) {
+        cout << "    " << name << " is faster than its baseline.  Consider"
+             << " re-running with --update to tighten it." << endl;
+    }
+    return ok ? 0 : 1;
+}
@@ -14,7 +14,7 @@ using namespace wingworks;
 
 
 void test_collision_1() {
-    Airfoil foil(10.0, 0.0, 50.0);
+    Airfoil foil(10.0, 0.0, 50.0, 0.0);
     AirfoilCollision ac(foil);
 
     Particle p;
@@ -0,0 +1,117 @@
+#include <iostream>
+#include <assert.h>
+#include <vector>
+
+#include <omp.h>
+
+#include "world_cells.h"
+#include "cell_balancer.h"
+
+using namespace std;
+using namespace wingworks;
+
+namespace {
+    const double world_width = 64.0;
+    const double world_height = 32.0;
+    const size_t max_particles = 20000;
+
+    // Crowd most particles into a few cells near the left edge, as in
+    // front of an airfoil, and sprinkle the rest evenly.
+    void fill_crowded(WorldCells& cells) {
+        size_t index = 0;
+        for (size_t i = 0; i < cells.size(); ++i) {
+            cells.add_to(i, index++);
+        }
+        for (size_t row = 12; row < 20; ++row) {
+            for (size_t col = 2; col < 6; ++col) {
+                const size_t i = row * cells.num_horiz() + col;
+                for (size_t n = 0; n < 300; ++n) {
+                    cells.add_to(i, index++);
+                }
+            }
+        }
+        assert(index <= max_particles);
+    }
+
+    double span_cost(const WorldCells& cells, const CellSpan& span, size_t k0, size_t k1) {
+        double result = 0.0;
+        for (size_t k = k0; k < k1; ++k) {
+            result += CellBalancer::cell_cost(cells.cell(span.cell(k)).size());
+        }
+        return result;
+    }
+}
+
+void test_plan_balances_cost() {
+    WorldCells cells(world_width, world_height, 1.0, 1.0, max_particles);
+    fill_crowded(cells);
+
+    const size_t num_threads = 8;
+    const size_t chunks_per_thread = 4;
+    CellBalancer balancer(num_threads, chunks_per_thread);
+    for (size_t color = 0; color < cells.num_colors(); ++color) {
+        const CellSpan span(cells.color_span(color));
+        balancer.plan(cells, span);
+        assert(balancer.num_chunks() == num_threads * chunks_per_thread);
+        assert(balancer.chunk_begin(0) == 0);
+        assert(balancer.chunk_end(balancer.num_chunks() - 1) == span.size());
+
+        double max_cell = 0.0;
+        for (size_t k = 0; k < span.size(); ++k) {
+            max_cell = max(max_cell, span_cost(cells, span, k, k + 1));
+        }
+        // Each thread's run of chunks is within a cell of its share.
+        const double share = span_cost(cells, span, 0, span.size()) / num_threads;
+        for (size_t t = 0; t < num_threads; ++t) {
+            const size_t k0 = balancer.chunk_begin(t * chunks_per_thread);
+            const size_t k1 = balancer.chunk_end((t + 1) * chunks_per_thread - 1);
+            assert(span_cost(cells, span, k0, k1) <= share + max_cell);
+        }
+    }
+}
+
+void test_each_chunk_runs_once() {
+    WorldCells cells(world_width, world_height, 1.0, 1.0, max_particles);
+    fill_crowded(cells);
+    const CellSpan span(cells.color_span(0));
+
+    // Fewer, as many, and more threads than were planned for.
+    const size_t teams[] = {1, 3, 4, 6};
+    CellBalancer balancer(4, 3);
+    balancer.plan(cells, span);
+    for (const size_t team_size : teams) {
+        // Run twice, to check that the queues restart.
+        for (size_t pass = 0; pass < 2; ++pass) {
+            vector<int> visits(span.size(), 0);
+            #pragma omp parallel num_threads(team_size)
+            {
+                balancer.for_each_chunk([&](const size_t k0, const size_t k1) {
+                    for (size_t k = k0; k < k1; ++k) {
+                        #pragma omp atomic
+                        visits[k] += 1;
+                    }
+                });
+            }
+            for (const int v : visits) {
+                assert(v == 1);
+            }
+        }
+    }
+
+    // Outside a parallel region, the calling thread runs every chunk.
+    vector<int> visits(span.size(), 0);
+    balancer.for_each_chunk([&](const size_t k0, const size_t k1) {
+        for (size_t k = k0; k < k1; ++k) {
+            visits[k] += 1;
+        }
+    });
+    for (const int v : visits) {
+        assert(v == 1);
+    }
+}
+
+int main(int, char**) {
+    test_plan_balances_cost();
+    test_each_chunk_runs_once();
+    return 0;
+}
@@ -0,0 +1,115 @@
+#include <iostream>
+#include <assert.h>
+#include <cmath>
+#include <numeric>
+#include <vector>
+
+#include "cell_stats.h"
+#include "world_cells.h"
+#include "airfoil.h"
+#include "world.h"
+#include "world_fixture.h"
+
+using namespace std;
+using namespace wingworks;
+using namespace wingworks::fixture;
+
+namespace {
+    // Pairs of particles in contact, by testing every pair.
+    size_t count_contacts(const World& world) {
+        const size_t n = world.num_particles();
+        size_t result = 0;
+        for (size_t i = 0; i < n; ++i) {
+            const Particle& p_i(world.particle(i));
+            for (size_t j = i + 1; j < n; ++j) {
+                if (p_i.is_colliding_with(world.particle(j))) {
+                    result += 1;
+                }
+            }
+        }
+        return result;
+    }
+}
+
+// Occupancy bins each cell by its particle count, and hot spots sum pair
+// tests over blocks of cells.
+void test_counts() {
+    WorldCells cells(16.0, 16.0, 1.0, 1.0, 100);
+    for (size_t i = 0; i < 3; ++i) {
+        cells.add_to(0, i);
+    }
+    cells.add_to(17, 3);
+    cells.add_to(255, 4);
+    cells.add_to(255, 5);
+
+    CellStats stats(cells, 8);
+    stats.record_occupancy(cells);
+    stats.record_step();
+    assert(stats.num_steps() == 1);
+    assert(stats.occupancy()[0] == 253);
+    assert(stats.occupancy()[1] == 1);
+    assert(stats.occupancy()[2] == 1);
+    assert(stats.occupancy()[3] == 1);
+
+    // Cell 9 is in the second block of the bottom row; cell 255 in the
+    // top right block.
+    stats.record_pairs(0, 5, 2);
+    stats.record_pairs(9, 3, 0);
+    stats.record_pairs(255, 4, 1);
+    assert(stats.pairs_tested() == 12);
+    assert(stats.pairs_colliding() == 3);
+    const vector<size_t> expected {5, 3, 0, 4};
+    assert(stats.hot_spots() == expected);
+
+    stats.reset();
+    assert(stats.num_steps() == 0);
+    assert(stats.pairs_tested() == 0 && stats.occupancy()[0] == 0);
+}
+
+// Collisions change only velocities, so the pairs in contact when a step
+// starts are the ones its pair search must find -- each exactly once,
+// whichever way the search runs.
+void test_each_contact_once() {
+    for (size_t variant = 0; variant < 3; ++variant) {
+        WorldOptions options(seeded_options());
+        options.collect_cell_stats = true;
+        options.num_threads = 4;
+        options.schedule = LoopSchedule::Dynamic;
+        options.chunk_size = 3;
+        switch (variant) {
+            case 1: options.balance_cells = true; break;
+            case 2: options.executor = StepExecutor::Fused; break;
+            default: break;
+        }
+        World world(make_world(options));
+        world.step_many(5);
+        world.reset_cell_stats();
+
+        const size_t contacts = count_contacts(world);
+        world.step();
+        const CellStats& stats(*world.cell_stats());
+        cout << "Variant " << variant << ": " << contacts << " pairs in contact, "
+             << stats.pairs_colliding() << " collided, " << stats.pairs_tested() << " tested" << endl;
+        assert(contacts > 0);
+        assert(stats.pairs_colliding() == contacts);
+        assert(stats.pairs_tested() >= contacts);
+        assert(accumulate(stats.hot_spots().begin(), stats.hot_spots().end(), size_t(0))
+               == stats.pairs_tested());
+
+        // One occupancy sample per cell, holding every particle once.
+        size_t num_samples = 0;
+        size_t num_held = 0;
+        for (size_t k = 0; k < stats.occupancy().size(); ++k) {
+            num_samples += stats.occupancy()[k];
+            num_held += k * stats.occupancy()[k];
+        }
+        assert(num_samples == size_t(::ceil(world_width)) * size_t(::ceil(world_height)));
+        assert(num_held == world.num_particles());
+    }
+}
+
+int main(int, char**) {
+    test_counts();
+    test_each_contact_once();
+    return 0;
+}
@@ -0,0 +1,237 @@
+#include <iostream>
+#include <assert.h>
+#include <cmath>
+#include <random>
+
+#include "point.h"
+#include "particle.h"
+#include "airfoil.h"
+#include "coarsening.h"
+#include "world.h"
+#include "world_fixture.h"
+
+using namespace std;
+using namespace wingworks;
+using namespace wingworks::fixture;
+
+namespace {
+    using WeightedWorld = BasicWorld<double, WeightedSpecies>;
+
+    // A wide world with a small foil, leaving most of the world far from
+    // it.
+    const double wide_width = 48.0;
+    const double wide_height = 24.0;
+
+    Airfoil make_small_foil() {
+        return Airfoil(8.0, wide_height / 2.0, 4.0, 10.0 * M_PI / 180.0);
+    }
+
+    template <typename W>
+    W make_wide_world(const WorldOptions& options) {
+        return make_world<W>(make_small_foil(), wide_width, wide_height, options);
+    }
+
+    WorldOptions coarsen_options() {
+        WorldOptions options(seeded_options());
+        options.coarsen = true;
+        return options;
+    }
+
+    struct Totals {
+        double weight = 0.0;
+        Vector momentum;
+        double energy = 0.0;
+    };
+
+    template <typename Real>
+    Totals totals_of(const WeightedParticle<Real> *particles, const size_t *indices, const size_t n) {
+        Totals result;
+        for (size_t k = 0; k < n; ++k) {
+            const WeightedParticle<Real>& p(particles[indices[k]]);
+            result.weight += p.weight();
+            result.momentum.add(Vector(p.vel()).scaled(p.weight()));
+            result.energy += 0.5 * p.weight() * Vector(p.vel()).mag_sqr();
+        }
+        return result;
+    }
+
+    template <typename World>
+    Totals totals_of(const World& world) {
+        Totals result;
+        for (size_t id = 0; id < world.num_particles(); ++id) {
+            const typename World::Particle& p(world.particle(id));
+            result.weight += p.mass();
+            result.momentum.add(Vector(p.vel()).scaled(p.mass()));
+            result.energy += 0.5 * p.mass() * Vector(p.vel()).mag_sqr();
+        }
+        return result;
+    }
+
+    bool close(const double v1, const double v2, const double tolerance) {
+        return ::fabs(v1 - v2) <= tolerance * ::fabs(v1);
+    }
+}
+
+// Merging four particles into two keeps their weight, momentum, kinetic
+// energy and center of mass.
+template <typename Real>
+void test_merge_conserves(const double tolerance) {
+    std::mt19937 gen(42);
+    std::uniform_real_distribution<> rand(-1.0, 1.0);
+    WeightedParticle<Real> particles[6];
+    for (size_t i = 0; i < 6; ++i) {
+        particles[i].move_to(10.0 + rand(gen), 5.0 + rand(gen));
+        particles[i].set_vel(0.11 + 0.01 * rand(gen), 0.01 * rand(gen));
+        particles[i].set_weight((i < 2) ? 1.0 : 2.0);
+    }
+    const size_t indices[] = {4, 1, 3, 0};
+    const Totals before(totals_of(particles, indices, 4));
+    Vector center;
+    for (const size_t i : indices) {
+        center.add(Vector(particles[i].pos()).scaled(particles[i].weight() / before.weight));
+    }
+
+    merge_particles(particles, indices, 4, Vector(0.6, 0.8));
+    const Totals after(totals_of(particles, indices, 2));
+    assert(particles[4].weight() == 3.0);
+    assert(particles[1].weight() == 3.0);
+    assert(close(before.weight, after.weight, 1.0e-12));
+    assert(close(before.momentum.x(), after.momentum.x(), tolerance));
+    assert(::fabs(before.momentum.y() - after.momentum.y()) <= tolerance * before.momentum.x());
+    assert(close(before.energy, after.energy, tolerance));
+    const Vector merged_center(
+        Vector(particles[4].pos()).adding(Vector(particles[1].pos())).scaled(0.5));
+    assert(merged_center.offset(center).magnitude() < 10.0 * tolerance);
+}
+
+// Splitting keeps everything but position.
+void test_split_conserves() {
+    WeightedParticle<double> p, half;
+    p.move_to(3.0, 4.0);
+    p.set_vel(0.1, -0.2);
+    p.set_weight(4.0);
+    split_particle(p, half, Vector(0.25, 0.0));
+    assert(p.weight() == 2.0 && half.weight() == 2.0);
+    assert(p.pos_x() == 3.25 && half.pos_x() == 2.75);
+    assert(p.vel().x() == 0.1 && half.vel().y() == -0.2);
+}
+
+// Until something changes their weights, weighted particles behave just
+// like the default species.
+void test_unit_weights_match_default_species() {
+    const WorldOptions options(seeded_options());
+    World plain(make_wide_world<World>(options));
+    WeightedWorld weighted(make_wide_world<WeightedWorld>(options));
+    plain.step_many(20);
+    weighted.step_many(20);
+    for (size_t id = 0; id < plain.num_particles(); ++id) {
+        assert(plain.particle(id).pos_x() == weighted.particle(id).pos_x());
+        assert(plain.particle(id).vel().y() == weighted.particle(id).vel().y());
+    }
+}
+
+// Coarsening cuts the particle count, conserves weight and momentum
+// (recycling aside), keeps particles near the foil light, and doesn't
+// depend on the thread count.
+void test_coarsening_world() {
+    WorldOptions options(coarsen_options());
+    options.num_threads = 1;
+    WeightedWorld world(make_wide_world<WeightedWorld>(options));
+    const size_t initial = world.num_particles();
+    const Totals before(totals_of(world));
+
+    // Coarsening comes first in a step.  Whatever momentum the step
+    // changes, other than by recycling a few particles, goes to the foil.
+    world.step();
+    const Totals first(totals_of(world));
+    assert(world.num_particles() < initial);
+    assert(close(before.weight, first.weight, 1.0e-12));
+    assert(close(before.momentum.x() + world.force_on_foil().x(), first.momentum.x(), 1.0e-3));
+
+    world.step_many(99);
+    const Totals after(totals_of(world));
+    cout << "Particles: " << initial << " -> " << world.num_particles() << endl;
+    assert(3 * world.num_particles() < 2 * initial);
+    assert(after.weight == before.weight);
+
+    // Only the odd particle recycled since the last coarsening can be
+    // heavy there.
+    const Airfoil foil(make_small_foil());
+    const BBox& foil_bbox(foil.shape().bbox());
+    size_t num_heavy = 0;
+    for (size_t id = 0; id < world.num_particles(); ++id) {
+        const WeightedWorld::Particle& p(world.particle(id));
+        if (foil_bbox.contains(Point(p.pos_x(), p.pos_y()))) {
+            assert(p.weight() >= 1.0);
+            num_heavy += (p.weight() >= 2.0) ? 1 : 0;
+        }
+    }
+    assert(num_heavy <= 2);
+
+    options.num_threads = 4;
+    options.schedule = LoopSchedule::Dynamic;
+    options.chunk_size = 3;
+    WeightedWorld other(make_wide_world<WeightedWorld>(options));
+    other.step_many(100);
+    assert(other.num_particles() == world.num_particles());
+    for (size_t id = 0; id < world.num_particles(); ++id) {
+        assert(world.particle(id).pos_x() == other.particle(id).pos_x());
+        assert(world.particle(id).vel().y() == other.particle(id).vel().y());
+        assert(world.particle(id).weight() == other.particle(id).weight());
+    }
+}
+
+// Coarsening keeps the force on the foil, averaged over a long run,
+// within 5% of an uncoarsened World's.  Much shorter runs are noisier
+// than that.
+void test_force_matches_uncoarsened() {
+    const size_t warmup_steps = 100;
+    const size_t num_steps = 800;
+    World fine(make_wide_world<World>(seeded_options()));
+    WeightedWorld coarse(make_wide_world<WeightedWorld>(coarsen_options()));
+    fine.step_many(warmup_steps);
+    coarse.step_many(warmup_steps);
+    fine.reset_force_on_foil();
+    coarse.reset_force_on_foil();
+    fine.step_many(num_steps);
+    coarse.step_many(num_steps);
+
+    const Vector& fine_force(fine.force_on_foil());
+    const Vector& coarse_force(coarse.force_on_foil());
+    const double error = coarse_force.offset(fine_force).magnitude() / fine_force.magnitude();
+    cout << "Force on foil: fine " << fine_force.to_str() << ", coarse " << coarse_force.to_str()
+         << " with " << coarse.num_particles() << " of " << fine.num_particles() << " particles" << endl;
+    assert(error <= 0.05);
+    assert(3 * coarse.num_particles() < 2 * fine.num_particles());
+}
+
+void test_bad_coarsening_rejected() {
+    bool threw = false;
+    try {
+        World world(make_wide_world<World>(coarsen_options()));
+    } catch (const std::invalid_argument&) {
+        threw = true;
+    }
+    assert(threw);
+
+    threw = false;
+    WorldOptions options(coarsen_options());
+    options.executor = StepExecutor::Fused;
+    try {
+        WeightedWorld world(make_wide_world<WeightedWorld>(options));
+    } catch (const std::invalid_argument&) {
+        threw = true;
+    }
+    assert(threw);
+}
+
+int main(int, char**) {
+    test_merge_conserves<double>(1.0e-12);
+    test_merge_conserves<float>(1.0e-5);
+    test_split_conserves();
+    test_unit_weights_match_default_species();
+    test_coarsening_world();
+    test_force_matches_uncoarsened();
+    test_bad_coarsening_rejected();
+    return 0;
+}
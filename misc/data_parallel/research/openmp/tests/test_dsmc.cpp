@@ -0,0 +1,160 @@
+#include <iostream>
+#include <assert.h>
+#include <cmath>
+
+#include "point.h"
+#include "particle.h"
+#include "airfoil.h"
+#include "world_cells.h"
+#include "dsmc_cells.h"
+#include "world.h"
+#include "world_fixture.h"
+
+using namespace std;
+using namespace wingworks;
+using namespace wingworks::fixture;
+
+namespace {
+    WorldOptions dsmc_options() {
+        WorldOptions options(seeded_options());
+        options.collisions = CollisionModel::DSMC;
+        return options;
+    }
+
+    bool same_particles(const World& w1, const World& w2) {
+        for (size_t i = 0; i < w1.num_particles(); ++i) {
+            const Particle& p1(w1.particle(i));
+            const Particle& p2(w2.particle(i));
+            if ((p1.pos_x() != p2.pos_x()) || (p1.pos_y() != p2.pos_y())
+                || (p1.vel().x() != p2.vel().x()) || (p1.vel().y() != p2.vel().y())) {
+                cout << "Particle " << i << " differs" << endl;
+                return false;
+            }
+        }
+        return true;
+    }
+}
+
+void test_cell_areas_and_candidates() {
+    // The last column and row stick out of a 2.5 x 1.5 world.
+    WorldCells cells(2.5, 1.5, 1.0, 1.0, 100);
+    DsmcCells dsmc(cells, 2.5, 1.5, 2.0, 0.125);
+    assert(cells.size() == 6);
+    assert(dsmc.area(0) == 1.0);
+    assert(dsmc.area(2) == 0.5);
+    assert(dsmc.area(3) == 0.5);
+    assert(dsmc.area(5) == 0.25);
+
+    // 0.5 * 4 * 3 * 2.0 * 0.125 / 1.0 = 1.5 candidates a step, the
+    // halves carried over.
+    size_t total = 0;
+    for (size_t step = 0; step < 10; ++step) {
+        total += dsmc.num_candidates(0, 4);
+    }
+    assert(total == 15);
+    assert(dsmc.num_candidates(1, 1) == 0);
+
+    assert(dsmc.accept(0, 0.0625, 0.25));
+    assert(!dsmc.accept(0, 0.0625, 0.75));
+    // A pair beyond the maximum raises it, and is always accepted.
+    assert(dsmc.accept(0, 0.4, 0.99));
+    assert(dsmc.max_sigma_cr(0) == 0.4);
+    assert(dsmc.max_sigma_cr(1) == 0.125);
+}
+
+// Collisions along any line of centers conserve momentum and energy.
+void test_collide_along_conserves() {
+    Particle p1, p2;
+    p1.set_vel(0.3, -0.1);
+    p2.set_vel(-0.2, 0.4);
+    const double e0 = p1.vel().mag_sqr() + p2.vel().mag_sqr();
+    const Point n(Point(1.0, 2.0).unit());
+    p1.collide_along(p2, n);
+    assert(::fabs(p1.vel().x() + p2.vel().x() - 0.1) < 1.0e-12);
+    assert(::fabs(p1.vel().y() + p2.vel().y() - 0.3) < 1.0e-12);
+    assert(::fabs(p1.vel().mag_sqr() + p2.vel().mag_sqr() - e0) < 1.0e-12);
+    // The relative velocity is reflected across the line of centers.
+    const Point vr(p1.vel().offset(p2.vel()));
+    assert(::fabs(vr.dot(n) - Point(0.5, -0.5).dot(n) * -1.0) < 1.0e-12);
+}
+
+// Each cell draws from its own random stream, so neither threads nor
+// storage order change the results.
+void test_dsmc_reproducible() {
+    WorldOptions options(dsmc_options());
+    options.num_threads = 1;
+    World plain(make_world(options));
+    plain.step_many(20);
+
+    options.num_threads = 4;
+    options.schedule = LoopSchedule::Dynamic;
+    options.chunk_size = 7;
+    options.reorder_interval = 7;
+    options.incremental_cells = true;
+    World other(make_world(options));
+    other.step_many(20);
+    assert(same_particles(plain, other));
+}
+
+// Before anything has hit the foil, the first step collides as many
+// pairs as NTC's expectation, computed from the initial state.
+void test_dsmc_collision_rate() {
+    WorldOptions options(dsmc_options());
+    options.collect_cell_stats = true;
+    options.dsmc_weight = 100.0;
+    World world(make_world(options));
+
+    WorldCells cells(world_width, world_height, options.cell_extent, 1.0, world.num_particles());
+    for (size_t id = 0; id < world.num_particles(); ++id) {
+        cells.add(world.particle(id), id);
+    }
+    // sigma is 1; velocities differ by at most 2 * max_speed.
+    const double max_sigma_cr = 2.0 * max_speed;
+    double expected = 0.0;
+    for (size_t i_cell = 0; i_cell < cells.size(); ++i_cell) {
+        const Cell cell(cells.cell(i_cell));
+        const double n = cell.size();
+        if (n < 2) {
+            continue;
+        }
+        double sum_cr = 0.0;
+        for (size_t i = 0; i < cell.size(); ++i) {
+            for (size_t j = i + 1; j < cell.size(); ++j) {
+                const Particle& p_i(world.particle(cell[i]));
+                const Particle& p_j(world.particle(cell[j]));
+                sum_cr += p_i.vel().offset(p_j.vel()).magnitude();
+            }
+        }
+        const double mean_cr = sum_cr / (0.5 * n * (n - 1.0));
+        const double candidates =
+            ::floor(0.5 * n * (n - 1.0) * options.dsmc_weight * max_sigma_cr);
+        expected += candidates * mean_cr / max_sigma_cr;
+    }
+
+    world.step();
+    const double colliding = world.cell_stats()->pairs_colliding();
+    cout << "DSMC collisions: " << colliding << ", expected " << expected << endl;
+    assert(expected > 1000.0);
+    assert(::fabs(colliding - expected) < 0.08 * expected);
+}
+
+void test_dsmc_needs_phased() {
+    bool threw = false;
+    WorldOptions options(dsmc_options());
+    options.executor = StepExecutor::Fused;
+    try {
+        World world(make_world(options));
+    } catch (const std::invalid_argument&) {
+        threw = true;
+    }
+    assert(threw);
+}
+
+int main(int, char**) {
+    test_cell_areas_and_candidates();
+    test_collide_along_conserves();
+    test_dsmc_reproducible();
+    test_dsmc_collision_rate();
+    test_dsmc_needs_phased();
+    return 0;
+}
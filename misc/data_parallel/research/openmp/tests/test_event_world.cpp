@@ -0,0 +1,174 @@
+#include <iostream>
+#include <assert.h>
+#include <cmath>
+#include <vector>
+
+#include "point.h"
+#include "particle.h"
+#include "airfoil.h"
+#include "event_world.h"
+#include "world_fixture.h"
+
+using namespace std;
+using namespace wingworks;
+using namespace wingworks::fixture;
+
+namespace {
+    EventWorld::Particle make_particle(const double x, const double y, const double vx, const double vy) {
+        EventWorld::Particle result;
+        result.move_to(x, y);
+        result.set_vel(vx, vy);
+        return result;
+    }
+
+    bool close(const double v1, const double v2) {
+        return ::fabs(v1 - v2) < 1.0e-9;
+    }
+
+    double dist_to_segment(const Point& p, const Point& a, const Point& b) {
+        const Vector ab(b.offset(a));
+        double f = p.offset(a).dot(ab) / ab.mag_sqr();
+        f = (f < 0.0) ? 0.0 : ((f > 1.0) ? 1.0 : f);
+        return p.offset(a.adding(ab.scaled(f))).magnitude();
+    }
+
+    // No particle overlaps another, or the foil.
+    bool nothing_overlaps(const EventWorld& world, const Airfoil& foil) {
+        const vector<Point>& vertices(foil.shape().vertices());
+        for (size_t i = 0; i < world.num_particles(); ++i) {
+            const EventWorld::Particle& p(world.particle(i));
+            for (size_t j = i + 1; j < world.num_particles(); ++j) {
+                const double sigma = p.radius() + world.particle(j).radius();
+                if (p.dist_sqr(world.particle(j)) < sigma * sigma * (1.0 - 1.0e-9)) {
+                    cout << "Particles " << i << " and " << j << " overlap" << endl;
+                    return false;
+                }
+            }
+            if (foil.shape().contains(p.pos())) {
+                return false;
+            }
+            for (size_t k = 0; k < vertices.size(); ++k) {
+                const double d =
+                    dist_to_segment(p.pos(), vertices[k], vertices[(k + 1) % vertices.size()]);
+                if (d < p.radius() * (1.0 - 1.0e-9)) {
+                    cout << "Particle " << i << " overlaps the foil" << endl;
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+}
+
+// Two particles closing head on touch exactly when they should, and
+// bounce back.
+void test_head_on_collision_time() {
+    // Keep the foil out of the way.
+    const vector<EventWorld::Particle> particles {
+        make_particle(5.0, 15.0, 0.1, 0.0),
+        make_particle(10.0, 15.0, -0.1, 0.0)
+    };
+    EventWorld world(make_airfoil(), world_width, world_height, particles, max_speed, Vector(), 1);
+
+    // The gap of 4 closes at 0.2 per step.
+    world.advance_to(19.5);
+    assert(world.counts().pair_collisions == 0);
+    assert(close(world.particle(0).pos_x(), 6.95));
+    world.advance_to(20.0);
+    assert(world.counts().pair_collisions == 1);
+    world.advance_to(30.0);
+    assert(close(world.particle(0).pos_x(), 6.0));
+    assert(close(world.particle(1).pos_x(), 9.0));
+    assert(close(world.particle(0).vel().x(), -0.1));
+    assert(close(world.particle(1).vel().x(), 0.1));
+    assert(close(world.particle(0).pos_y(), 15.0));
+}
+
+// A particle flying at the foil bounces off it, with its speed intact,
+// pushing on the foil.
+void test_foil_collision() {
+    const Airfoil foil(make_airfoil());
+    const BBox& bbox(foil.shape().bbox());
+    const double x = bbox.xmin() + 0.5 * bbox.width();
+    const vector<EventWorld::Particle> particles {make_particle(x, 16.0, 0.0, -0.2)};
+    EventWorld world(foil, world_width, world_height, particles, max_speed, Vector(), 1);
+
+    world.advance_to(40.0);
+    assert(world.counts().foil_collisions == 1);
+    assert(world.particle(0).vel().y() > 0.0);
+    assert(close(Vector(world.particle(0).vel()).magnitude(), 0.2));
+    assert(world.force_on_foil().y() > 0.0);
+    assert(nothing_overlaps(world, foil));
+}
+
+// A dilute random flow never lets particles overlap, and its frames
+// come at the times asked for.
+void test_dilute_flow() {
+    const Airfoil foil(make_airfoil());
+    EventWorld world(foil, world_width, world_height, 150, 0.05, wind, 1234);
+    assert(nothing_overlaps(world, foil));
+
+    vector<double> frame_times;
+    world.for_each_frame(10.0, 30, [&](EventWorld& w) {
+        frame_times.push_back(w.time());
+        assert(nothing_overlaps(w, foil));
+    });
+    assert(frame_times.size() == 30);
+    assert(frame_times.back() == 300.0);
+
+    const EventCounts& counts(world.counts());
+    cout << "Pair collisions: " << counts.pair_collisions
+         << ", foil collisions: " << counts.foil_collisions
+         << ", cell crossings: " << counts.cell_crossings
+         << ", recycles: " << counts.recycles
+         << ", stale events: " << counts.stale_events
+         << ", predictions: " << counts.predictions << endl;
+    assert(counts.pair_collisions > 0);
+    assert(counts.foil_collisions > 0);
+    assert(counts.recycles > 0);
+
+    // The same seed and frames give the same flow.  (Sampling rounds
+    // positions, so different frames would not.)
+    EventWorld again(foil, world_width, world_height, 150, 0.05, wind, 1234);
+    again.for_each_frame(10.0, 30, [](EventWorld&) {});
+    for (size_t i = 0; i < world.num_particles(); ++i) {
+        assert(world.particle(i).pos_x() == again.particle(i).pos_x());
+        assert(world.particle(i).vel().y() == again.particle(i).vel().y());
+    }
+}
+
+void test_bad_worlds_rejected() {
+    bool threw = false;
+    try {
+        EventWorld world(make_airfoil(), world_width, world_height, 2000, 0.05, Vector(), 1);
+    } catch (const std::invalid_argument&) {
+        threw = true;
+    }
+    assert(threw);
+
+    threw = false;
+    try {
+        EventWorld world(make_airfoil(), world_width, world_height, 10, 0.05, Vector(), 1, 0.5);
+    } catch (const std::invalid_argument&) {
+        threw = true;
+    }
+    assert(threw);
+
+    threw = false;
+    const vector<EventWorld::Particle> particles {
+        make_particle(5.0, 15.0, 0.0, 0.0), make_particle(5.5, 15.0, 0.0, 0.0)};
+    try {
+        EventWorld world(make_airfoil(), world_width, world_height, particles, 0.05, Vector(), 1);
+    } catch (const std::invalid_argument&) {
+        threw = true;
+    }
+    assert(threw);
+}
+
+int main(int, char**) {
+    test_head_on_collision_time();
+    test_foil_collision();
+    test_dilute_flow();
+    test_bad_worlds_rejected();
+    return 0;
+}
@@ -0,0 +1,200 @@
+#include <iostream>
+#include <assert.h>
+#include <cmath>
+#include <vector>
+
+#include "point.h"
+#include "particle.h"
+#include "airfoil.h"
+#include "flow_boundaries.h"
+#include "rng.h"
+#include "world.h"
+#include "world_fixture.h"
+
+using namespace std;
+using namespace wingworks;
+using namespace wingworks::fixture;
+
+namespace {
+    bool close(const double v1, const double v2, const double tolerance) {
+        return ::fabs(v1 - v2) <= tolerance * ::fabs(v1);
+    }
+
+    WorldOptions open_options() {
+        WorldOptions options(seeded_options());
+        options.boundaries = BoundaryModel::Open;
+        return options;
+    }
+}
+
+// Reservoirs send in the freestream's flux through each open edge.
+void test_arrival_rates() {
+    const double sigma = 0.01;
+    FlowBoundaries specular(world_width, world_height, 10.0, wind, sigma, SideWalls::Specular);
+    // The wind is many sigmas: nearly all of the inflow is the wind's.
+    assert(close(specular.arrival_rate(FlowBoundaries::Left), 10.0 * world_height * 0.11, 1.0e-6));
+    assert(specular.arrival_rate(FlowBoundaries::Right) == 0.0);
+    assert(specular.arrival_rate(FlowBoundaries::Bottom) == 0.0);
+    assert(specular.arrival_rate(FlowBoundaries::Top) == 0.0);
+
+    // Across the wind, only thermal motion brings particles in.
+    FlowBoundaries open(world_width, world_height, 10.0, wind, sigma, SideWalls::Freestream);
+    const double thermal = 10.0 * world_width * sigma / ::sqrt(2.0 * M_PI);
+    assert(close(open.arrival_rate(FlowBoundaries::Bottom), thermal, 1.0e-12));
+    assert(close(open.arrival_rate(FlowBoundaries::Top), thermal, 1.0e-12));
+}
+
+// Arrivals come as often as the rates say, just inside their edges, with
+// normal speeds weighted by how fast they cross.
+void test_arrivals() {
+    const double sigma = 0.01;
+    FlowBoundaries boundaries(world_width, world_height, 10.0, wind, sigma, SideWalls::Freestream);
+    const double rate =
+        boundaries.arrival_rate(FlowBoundaries::Left) + boundaries.arrival_rate(FlowBoundaries::Bottom)
+        + boundaries.arrival_rate(FlowBoundaries::Top);
+
+    CounterRNG gen(42);
+    vector<Arrival> arrivals;
+    const size_t num_steps = 500;
+    for (size_t step = 0; step < num_steps; ++step) {
+        boundaries.draw_arrivals(gen, arrivals);
+    }
+    assert(::fabs(arrivals.size() - num_steps * rate) < 3.0);
+
+    size_t num_left = 0;
+    double left_vx = 0.0;
+    size_t num_bottom = 0;
+    double bottom_vy = 0.0;
+    for (const Arrival& a : arrivals) {
+        assert((0.0 <= a.pos.x()) && (a.pos.x() < world_width));
+        assert((0.0 < a.pos.y()) && (a.pos.y() < world_height));
+        if (a.pos.x() < a.vel.x()) {
+            num_left += 1;
+            left_vx += a.vel.x();
+        } else if (a.pos.y() < a.vel.y()) {
+            num_bottom += 1;
+            bottom_vy += a.vel.y();
+        } else {
+            // From the top, moving down.
+            assert(world_height - a.pos.y() <= -a.vel.y());
+        }
+    }
+    // Normal speeds across a still edge average sigma sqrt(pi / 2); with
+    // the wind behind them, wind + sigma^2 / wind.
+    assert(close(left_vx / num_left, 0.11 + sigma * sigma / 0.11, 0.01));
+    assert(num_bottom > 500);
+    assert(close(bottom_vy / num_bottom, sigma * ::sqrt(M_PI / 2.0), 0.05));
+}
+
+void test_specular_walls() {
+    FlowBoundaries boundaries(world_width, world_height, 10.0, wind, 0.01, SideWalls::Specular);
+    Particle p;
+    p.move_to(5.0, -0.25);
+    p.set_vel(0.1, -0.5);
+    assert(boundaries.keep(p));
+    assert(p.pos_y() == 0.25 && p.vel().y() == 0.5);
+
+    p.move_to(5.0, world_height + 0.5);
+    assert(boundaries.keep(p));
+    assert(p.pos_y() == world_height - 0.5 && p.vel().y() == -0.5);
+
+    p.move_to(world_width + 0.1, 3.0);
+    assert(!boundaries.keep(p));
+}
+
+// With nothing in the way, what flows in flows out: an open world keeps
+// its density, with either kind of side wall.
+void test_open_world_balances() {
+    for (const SideWalls walls : {SideWalls::Specular, SideWalls::Freestream}) {
+        WorldOptions options(open_options());
+        options.side_walls = walls;
+        // The foil is well outside the world.
+        World world(make_world(
+            Airfoil(10.0 * world_width, world_height / 2.0, 1.0, 0.0),
+            world_width, world_height, options));
+        const size_t initial = world.num_particles();
+        world.step_many(300);
+        cout << "Particles: " << initial << " -> " << world.num_particles() << endl;
+        assert(close(double(initial), double(world.num_particles()), 0.01));
+        assert(::fabs(world.momentum() / world.num_particles() - 0.11) < 1.0e-3);
+    }
+}
+
+// Particles stay in the world, none is turned away, and the results
+// don't depend on the thread count.
+void test_open_world_with_foil() {
+    WorldOptions options(open_options());
+    options.side_walls = SideWalls::Freestream;
+    options.num_threads = 1;
+    World world(make_world(options));
+    world.step_many(100);
+    assert(world.turned_away() == 0);
+    assert(world.blocked_arrivals() == 0);
+    for (size_t id = 0; id < world.num_particles(); ++id) {
+        const Particle& p(world.particle(id));
+        assert((0.0 <= p.pos_x()) && (p.pos_x() < world_width));
+        assert((0.0 <= p.pos_y()) && (p.pos_y() < world_height));
+    }
+
+    options.num_threads = 4;
+    options.schedule = LoopSchedule::Dynamic;
+    options.chunk_size = 7;
+    World other(make_world(options));
+    other.step_many(100);
+    assert(other.num_particles() == world.num_particles());
+    for (size_t id = 0; id < world.num_particles(); ++id) {
+        assert(world.particle(id).pos_x() == other.particle(id).pos_x());
+        assert(world.particle(id).vel().y() == other.particle(id).vel().y());
+    }
+}
+
+// Where the foil reaches the inflow edge, it blocks that part of the
+// edge: arrivals there are dropped, and counted.
+void test_foil_blocks_inflow() {
+    WorldOptions options(open_options());
+    // The left edge cuts through the middle of the foil.
+    const Airfoil foil(-world_width / 8.0, world_height / 2.0, world_width / 4.0, 0.0);
+    const Polygon& shape(foil.shape());
+    World world(make_world(foil, world_width, world_height, options));
+    const double density = world.num_particles() / (world_width * world_height);
+    const size_t num_steps = 300;
+    world.step_many(num_steps);
+    for (size_t id = 0; id < world.num_particles(); ++id) {
+        assert(!shape.contains(Point(world.particle(id).pos())));
+    }
+
+    // Arrivals land within about a step's travel of the edge, where the
+    // foil covers much the same stretch of it as at the edge itself.
+    size_t num_covered = 0;
+    const size_t n = 10000;
+    for (size_t k = 0; k < n; ++k) {
+        num_covered += shape.contains(Point(0.05, (k + 0.5) * world_height / n)) ? 1 : 0;
+    }
+    const double covered = num_covered * world_height / n;
+    const double expected = num_steps * density * 0.11 * covered;
+    cout << "Blocked arrivals: " << world.blocked_arrivals() << ", expected about " << expected << endl;
+    assert(::fabs(world.blocked_arrivals() - expected) < 0.2 * expected);
+}
+
+void test_open_needs_phased() {
+    bool threw = false;
+    WorldOptions options(open_options());
+    options.executor = StepExecutor::Fused;
+    try {
+        World world(make_world(options));
+    } catch (const std::invalid_argument&) {
+        threw = true;
+    }
+    assert(threw);
+}
+
+int main(int, char**) {
+    test_arrival_rates();
+    test_arrivals();
+    test_specular_walls();
+    test_open_world_balances();
+    test_open_world_with_foil();
+    test_foil_blocks_inflow();
+    test_open_needs_phased();
+    return 0;
+}
@@ -0,0 +1,156 @@
+#include <iostream>
+#include <assert.h>
+#include <cmath>
+#include <string>
+
+#include <unistd.h>
+
+#include "airfoil.h"
+#include "world.h"
+#include "frame_channel.h"
+
+using namespace std;
+using namespace wingworks;
+
+namespace {
+    // Unique per process, so that concurrent test runs don't collide.
+    string channel_name(const string& suffix) {
+        return "/wingworks_test_" + to_string(::getpid()) + "_" + suffix;
+    }
+
+    void publish(FramePublisher& publisher, const uint64_t step, const size_t n) {
+        publisher.begin_frame(step, n, Vector(step, -double(step)));
+        for (size_t i = 0; i < n; ++i) {
+            publisher.pos_x()[i] = step + i;
+            publisher.pos_y()[i] = i;
+            publisher.vel_x()[i] = -float(i);
+            publisher.vel_y()[i] = step;
+        }
+        publisher.end_frame();
+    }
+}
+
+void test_reads_latest_frame() {
+    FramePublisher publisher(channel_name("latest"), 100, 3);
+    FrameReader reader(publisher.name());
+
+    Frame frame;
+    assert(!reader.read_latest(frame));
+
+    for (uint64_t step = 1; step <= 5; ++step) {
+        publish(publisher, 10 * step, 50 + step);
+    }
+    assert(reader.frames_published() == 5);
+    assert(reader.read_latest(frame));
+    assert(frame.frame == 4);
+    assert(frame.step == 50);
+    assert(frame.force.x() == 50.0);
+    assert(frame.force.y() == -50.0);
+    assert(frame.pos_x.size() == 55);
+    for (size_t i = 0; i < frame.pos_x.size(); ++i) {
+        assert(frame.pos_x[i] == 50 + i);
+        assert(frame.pos_y[i] == i);
+        assert(frame.vel_x[i] == -float(i));
+        assert(frame.vel_y[i] == 50);
+    }
+}
+
+// A reader that takes too long is lapped -- and finds out -- rather
+// than holding up the publisher.
+void test_slow_reader_is_lapped() {
+    const size_t num_slots = 3;
+    FramePublisher publisher(channel_name("lapped"), 10, num_slots);
+    FrameReader reader(publisher.name());
+    publish(publisher, 1, 10);
+
+    FrameReader::View view;
+    assert(reader.latest(view));
+    assert(view.pos_x[3] == 4.0f);
+    assert(reader.intact(view));
+
+    // Until the publisher comes back around to the view's slot, it stays
+    // intact.
+    for (size_t i = 1; i < num_slots; ++i) {
+        publish(publisher, 1 + i, 10);
+        assert(reader.intact(view));
+    }
+    publish(publisher, 1 + num_slots, 10);
+    assert(!reader.intact(view));
+
+    Frame frame;
+    assert(reader.read_latest(frame));
+    assert(frame.step == 1 + num_slots);
+}
+
+void test_bad_channels_rejected() {
+    bool threw = false;
+    try {
+        FrameReader reader(channel_name("missing"));
+    } catch (const std::exception&) {
+        threw = true;
+    }
+    assert(threw);
+
+    FramePublisher publisher(channel_name("small"), 10);
+    threw = false;
+    try {
+        publisher.begin_frame(0, 11, Vector());
+    } catch (const std::invalid_argument&) {
+        threw = true;
+    }
+    assert(threw);
+}
+
+void test_world_publishes_frames() {
+    const double width = 32.0, height = 18.0;
+    WorldOptions options;
+    options.seed = 1234;
+    options.frame_channel = channel_name("world");
+    World world(
+        Airfoil(width / 8.0, height / 2.0, width / 4.0, 10.0 * M_PI / 180.0),
+        width, height, 0.0005, Vector(0.11, 0.0), options);
+    FrameReader reader(options.frame_channel);
+
+    world.step_many(5);
+    world.step_many(3);
+    Frame frame;
+    assert(reader.read_latest(frame));
+    assert(frame.frame == 1);
+    assert(frame.step == 8);
+    assert(frame.pos_x.size() == world.num_particles());
+    assert(frame.force.x() == world.force_on_foil().x());
+    for (size_t id = 0; id < world.num_particles(); ++id) {
+        const Particle& p(world.particle(id));
+        assert(frame.pos_x[id] == float(p.pos_x()));
+        assert(frame.pos_y[id] == float(p.pos_y()));
+        assert(frame.vel_x[id] == float(p.vel().x()));
+        assert(frame.vel_y[id] == float(p.vel().y()));
+    }
+}
+
+// A channel that can't be created fails the World's constructor, before
+// it has allocated anything to leak.
+void test_world_rejects_bad_channel() {
+    const double width = 32.0, height = 18.0;
+    WorldOptions options;
+    // shm_open refuses names with a second slash.
+    options.frame_channel = channel_name("bad") + "/name";
+    bool threw = false;
+    try {
+        World world(
+            Airfoil(width / 8.0, height / 2.0, width / 4.0, 10.0 * M_PI / 180.0),
+            width, height, 0.0005, Vector(0.11, 0.0), options);
+    } catch (const std::exception&) {
+        threw = true;
+    }
+    assert(threw);
+}
+
+int main(int, char**) {
+    test_reads_latest_frame();
+    test_slow_reader_is_lapped();
+    test_bad_channels_rejected();
+    test_world_publishes_frames();
+    test_world_rejects_bad_channel();
+    return 0;
+}
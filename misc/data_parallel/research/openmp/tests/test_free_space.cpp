@@ -0,0 +1,116 @@
+#include <iostream>
+#include <assert.h>
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include "point.h"
+#include "airfoil.h"
+#include "free_space.h"
+#include "world_fixture.h"
+
+using namespace std;
+using namespace wingworks;
+using namespace wingworks::fixture;
+
+namespace {
+    // The free height through x, by testing points along the line.
+    double brute_free_height(const Polygon& shape, const double x) {
+        const size_t n = 100000;
+        size_t num_free = 0;
+        for (size_t k = 0; k < n; ++k) {
+            if (!shape.contains(Point(x, (k + 0.5) * world_height / n))) {
+                num_free += 1;
+            }
+        }
+        return num_free * world_height / n;
+    }
+}
+
+// Free heights agree with the polygon, and sampled points miss it and
+// fill the rest of the line in order.
+void test_free_heights() {
+    const Airfoil foil(make_airfoil());
+    const Polygon& shape(foil.shape());
+    const FreeSpace space(shape, world_width, world_height);
+    for (double x = 0.0; x <= world_width; x += 0.37) {
+        assert(::fabs(space.free_height(x) - brute_free_height(shape, x)) < 1.0e-3);
+        double last = -1.0;
+        for (size_t k = 0; k < 1000; ++k) {
+            const double y = space.sample_y(x, k / 1000.0);
+            assert((last < y) && (y < world_height));
+            assert(!shape.contains(Point(x, y)));
+            last = y;
+        }
+    }
+    assert(space.free_height(0.0) == world_height);
+    assert(space.sample_y(world_width / 2.0, 0.0) == 0.0);
+}
+
+// Points cover the free area uniformly.
+void test_uniform_over_free_area() {
+    const Airfoil foil(make_airfoil());
+    const Polygon& shape(foil.shape());
+    const FreeSpace space(shape, world_width, world_height);
+
+    // Bins of a grid over the foil's bounding box, and how much of each
+    // is free.
+    const BBox& bbox(shape.bbox());
+    const size_t nx = 8, ny = 4;
+    const double bin_w = bbox.width() / nx, bin_h = bbox.height() / ny;
+    vector<double> free_fraction(nx * ny, 0.0);
+    const size_t fine = 50;
+    for (size_t b = 0; b < nx * ny; ++b) {
+        size_t num_free = 0;
+        for (size_t i = 0; i < fine; ++i) {
+            for (size_t j = 0; j < fine; ++j) {
+                const Point p(
+                    bbox.xmin() + (b % nx + (i + 0.5) / fine) * bin_w,
+                    bbox.ymin() + (b / nx + (j + 0.5) / fine) * bin_h);
+                num_free += shape.contains(p) ? 0 : 1;
+            }
+        }
+        free_fraction[b] = double(num_free) / (fine * fine);
+    }
+
+    std::mt19937 gen(42);
+    std::uniform_real_distribution<> urand(0.0, 1.0);
+    const size_t num_points = 2000000;
+    vector<size_t> counts(nx * ny, 0);
+    for (size_t k = 0; k < num_points; ++k) {
+        const double u1 = urand(gen);
+        const double u2 = urand(gen);
+        const Point p(space.sample(u1, u2, urand(gen)));
+        assert(!shape.contains(p));
+        const double fx = (p.x() - bbox.xmin()) / bin_w, fy = (p.y() - bbox.ymin()) / bin_h;
+        if ((0.0 <= fx) && (fx < nx) && (0.0 <= fy) && (fy < ny)) {
+            counts[size_t(fy) * nx + size_t(fx)] += 1;
+        }
+    }
+    // The foil's bounding box is what isn't free.
+    double free_area = world_width * world_height;
+    for (const double f : free_fraction) {
+        free_area -= (1.0 - f) * bin_w * bin_h;
+    }
+    for (size_t b = 0; b < nx * ny; ++b) {
+        const double expected = num_points * free_fraction[b] * bin_w * bin_h / free_area;
+        assert(::fabs(counts[b] - expected) < 5.0 * ::sqrt(expected) + 0.01 * expected + 5.0);
+    }
+}
+
+// An obstacle outside the world leaves it all free.
+void test_obstacle_outside() {
+    const Airfoil foil(10.0 * world_width, world_height / 2.0, 1.0, 0.0);
+    const FreeSpace space(foil.shape(), world_width, world_height);
+    assert(space.free_height(world_width / 3.0) == world_height);
+    assert(space.sample_y(5.0, 0.25) == 0.25 * world_height);
+    const Point p(space.sample(0.5, 0.5, 0.5));
+    assert(::fabs(p.x() - world_width / 2.0) < 1.0e-12 && p.y() == world_height / 2.0);
+}
+
+int main(int, char**) {
+    test_free_heights();
+    test_uniform_over_free_area();
+    test_obstacle_outside();
+    return 0;
+}
@@ -0,0 +1,109 @@
+#include <iostream>
+#include <assert.h>
+#include <cmath>
+
+#include "point.h"
+#include "particle.h"
+#include "airfoil.h"
+#include "world.h"
+#include "world_fixture.h"
+
+using namespace std;
+using namespace wingworks;
+using namespace wingworks::fixture;
+
+namespace {
+    WorldOptions list_options(const bool neighbor_lists) {
+        WorldOptions options(seeded_options());
+        options.collect_cell_stats = true;
+        options.neighbor_lists = neighbor_lists;
+        return options;
+    }
+
+    // Pair collisions happen before anything moves a particle in a
+    // step, so the colliding pairs are those that touch at its start.
+    size_t count_touching(const World& world) {
+        size_t result = 0;
+        for (size_t i = 0; i < world.num_particles(); ++i) {
+            const Particle& p_i(world.particle(i));
+            for (size_t j = i + 1; j < world.num_particles(); ++j) {
+                if (p_i.is_colliding_with(world.particle(j))) {
+                    result += 1;
+                }
+            }
+        }
+        return result;
+    }
+}
+
+// The lists must find every touching pair, strays included, and
+// only once.
+void test_finds_all_pairs() {
+    World world(make_world(list_options(true)));
+    const size_t num_steps = 20;
+    size_t colliding = 0;
+    for (size_t i = 0; i < num_steps; ++i) {
+        const size_t expected = count_touching(world);
+        world.step();
+        const size_t found = world.cell_stats()->pairs_colliding() - colliding;
+        assert(found == expected);
+        colliding += found;
+    }
+    assert(world.neighbor_list_builds() > 0);
+    assert(world.neighbor_list_builds() < num_steps);
+}
+
+void test_tests_fewer_pairs() {
+    World cells(make_world(list_options(false)));
+    World lists(make_world(list_options(true)));
+    const size_t num_steps = 20;
+    cells.step_many(num_steps);
+    lists.step_many(num_steps);
+    const size_t cell_pairs = cells.cell_stats()->pairs_tested();
+    const size_t list_pairs = lists.cell_stats()->pairs_tested();
+    cout << "Pairs tested: cells " << cell_pairs << ", lists " << list_pairs
+         << ", " << lists.neighbor_list_builds() << " builds" << endl;
+    assert(list_pairs < cell_pairs);
+}
+
+// Strays collide in parallel, by color, so thread count mustn't matter.
+void test_thread_count_independent() {
+    WorldOptions options(list_options(true));
+    options.num_threads = 1;
+    World w1(make_world(options));
+    options.num_threads = 4;
+    options.schedule = LoopSchedule::Dynamic;
+    options.chunk_size = 3;
+    World w2(make_world(options));
+    w1.step_many(20);
+    w2.step_many(20);
+    assert(w1.cell_stats()->pairs_colliding() == w2.cell_stats()->pairs_colliding());
+    for (size_t i = 0; i < w1.num_particles(); ++i) {
+        const Particle& p1(w1.particle(i));
+        const Particle& p2(w2.particle(i));
+        assert((p1.pos_x() == p2.pos_x()) && (p1.pos_y() == p2.pos_y()));
+        assert((p1.vel().x() == p2.vel().x()) && (p1.vel().y() == p2.vel().y()));
+    }
+}
+
+void test_needs_phased_executor() {
+    WorldOptions options;
+    options.neighbor_lists = true;
+    options.executor = StepExecutor::Fused;
+    const Airfoil foil(4.0, 4.5, 8.0, 0.0);
+    bool threw = false;
+    try {
+        World world(make_world(foil, world_width, world_height, options));
+    } catch (const invalid_argument&) {
+        threw = true;
+    }
+    assert(threw);
+}
+
+int main(int, char**) {
+    test_finds_all_pairs();
+    test_tests_fewer_pairs();
+    test_thread_count_independent();
+    test_needs_phased_executor();
+    return 0;
+}
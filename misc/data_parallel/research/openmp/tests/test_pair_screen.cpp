@@ -0,0 +1,70 @@
+#include <iostream>
+#include <assert.h>
+#include <random>
+#include <vector>
+
+#include "pair_screen.h"
+#include "particle.h"
+
+using namespace std;
+using namespace wingworks;
+
+namespace {
+    // Particles packed densely enough that about half of all pairs
+    // touch, some of them exactly at touching distance.
+    template <typename Real, typename Species>
+    vector<BasicParticle<Real, Species>> scatter(const size_t num_particles, const unsigned seed) {
+        mt19937 gen(seed);
+        uniform_real_distribution<> rand(0.0, 1.5);
+        vector<BasicParticle<Real, Species>> result(num_particles);
+        for (BasicParticle<Real, Species>& p : result) {
+            p.move_to(rand(gen), rand(gen));
+            p.draw_species(gen);
+        }
+        result[1].move_to(result[0].pos_x() + result[0].radius() + result[1].radius(), result[0].pos_y());
+        return result;
+    }
+}
+
+// The screen finds exactly the pairs is_colliding_with does, in staging
+// order, over any range.
+template <typename Real, typename Species>
+void test_matches_is_colliding_with() {
+    const size_t num_particles = 101;
+    const vector<BasicParticle<Real, Species>> particles(scatter<Real, Species>(num_particles, 42));
+    PairScreen<Real> screen;
+    // Stage twice over, to exercise growing and clearing.
+    for (size_t pass = 0; pass < 2; ++pass) {
+        screen.clear();
+        for (size_t i = 0; i < num_particles; ++i) {
+            screen.stage(particles[i], i);
+        }
+        assert(screen.size() == num_particles);
+    }
+
+    size_t num_touching = 0;
+    for (size_t i = 0; i < num_particles; ++i) {
+        const size_t begin = i / 2;
+        const size_t end = num_particles - i / 3;
+        const size_t num_hits = screen.find_touching(particles[i], begin, end);
+        size_t h = 0;
+        for (size_t j = begin; j < end; ++j) {
+            if (particles[i].is_colliding_with(particles[j])) {
+                assert(h < num_hits);
+                assert(screen.hit(h) == j);
+                h += 1;
+            }
+        }
+        assert(h == num_hits);
+        num_touching += num_hits;
+    }
+    assert(num_touching > 0);
+}
+
+int main(int, char**) {
+    test_matches_is_colliding_with<double, UniformSpecies>();
+    test_matches_is_colliding_with<float, UniformSpecies>();
+    MixedSpecies::set_table({{1.0, 0.5, 0.5}, {4.0, 1.0, 0.5}});
+    test_matches_is_colliding_with<double, MixedSpecies>();
+    return 0;
+}
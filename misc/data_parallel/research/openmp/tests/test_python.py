@@ -0,0 +1,120 @@
+"""Tests for the wingworks Python module.  Run with the module's build
+directory on PYTHONPATH."""
+
+import math
+import threading
+
+import wingworks
+
+
+def make_world(**kwargs):
+    return wingworks.World(32.0, 18.0, seed=1234, **kwargs)
+
+
+def test_views_show_state():
+    world = make_world()
+    n = world.num_particles
+    assert n == 32 * 18 * 10
+    pos = world.positions
+    vel = world.velocities
+    assert pos.shape == (n, 2) and vel.shape == (n, 2)
+    assert pos.format == "d" and pos.readonly
+    assert list(world.ids) == list(range(n))
+
+    momentum = sum(math.hypot(vx, vy) for vx, vy in vel.tolist())
+    assert math.isclose(momentum, world.momentum(), rel_tol=1e-12)
+    for x, y in pos.tolist():
+        assert 0.0 <= x <= 32.0 and 0.0 <= y <= 18.0
+
+
+# Views alias the World: taken before stepping, they show the state
+# after it.
+def test_views_alias_world():
+    world = make_world()
+    pos = world.positions
+    force = world.force_on_foil
+    before = pos.tolist()
+    assert force.tolist() == [0.0, 0.0]
+
+    world.step_many(5)
+    assert world.step_count == 5
+    assert pos.tolist() != before
+    assert pos.tolist() == world.positions.tolist()
+    assert force.tolist() == world.force_on_foil.tolist()
+    assert force.tolist() != [0.0, 0.0]
+    world.reset_force_on_foil()
+    assert force.tolist() == [0.0, 0.0]
+
+    # A view keeps its World alive.
+    del world
+    assert len(pos.tolist()) == 32 * 18 * 10
+
+
+def test_single_precision():
+    world = make_world(single=True)
+    world.step()
+    assert world.positions.format == "f"
+    assert world.velocities.shape == (world.num_particles, 2)
+
+
+def test_reordered_views_follow_ids():
+    plain = make_world()
+    reordered = make_world(reorder_interval=2)
+    plain.step_many(4)
+    reordered.step_many(4)
+    ids = reordered.ids.tolist()
+    assert ids != list(range(reordered.num_particles))
+    pos = reordered.positions.tolist()
+    plain_pos = plain.positions.tolist()
+    for slot, id in enumerate(ids):
+        assert pos[slot] == plain_pos[id]
+
+
+def test_bad_arguments_rejected():
+    for kwargs in ({"executor": "sideways"}, {"balance_cells": True, "neighbor_lists": True}):
+        try:
+            make_world(**kwargs)
+        except ValueError:
+            pass
+        else:
+            assert False, kwargs
+
+
+# Views would dangle if __init__ could replace the World under them.
+def test_reinit_rejected():
+    world = make_world()
+    pos = world.positions
+    try:
+        world.__init__(32.0, 18.0, seed=1234)
+    except RuntimeError:
+        pass
+    else:
+        assert False
+    assert pos.tolist() == world.positions.tolist()
+
+
+# step_many releases the GIL: other threads run meanwhile, but may not
+# touch the World.
+def test_step_many_releases_gil():
+    world = make_world()
+    stepper = threading.Thread(target=world.step_many, args=(200,))
+    turned_away = 0
+    stepper.start()
+    while stepper.is_alive():
+        try:
+            world.step_count
+        except RuntimeError:
+            turned_away += 1
+    stepper.join()
+    assert turned_away > 0
+    assert world.step_count == 200
+
+
+if __name__ == "__main__":
+    test_views_show_state()
+    test_views_alias_world()
+    test_single_precision()
+    test_reordered_views_follow_ids()
+    test_bad_arguments_rejected()
+    test_reinit_rejected()
+    test_step_many_releases_gil()
@@ -0,0 +1,63 @@
+#include <iostream>
+#include <assert.h>
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#include <omp.h>
+
+#include "radix_sort.h"
+
+using namespace std;
+using namespace wingworks;
+
+namespace {
+    vector<uint64_t> random_keys(const size_t num_keys, const unsigned key_bits) {
+        mt19937_64 gen(42);
+        const uint64_t mask = (key_bits < 64) ? (uint64_t(1) << key_bits) - 1 : ~uint64_t(0);
+        vector<uint64_t> result(num_keys);
+        for (uint64_t& key : result) {
+            key = gen() & mask;
+        }
+        return result;
+    }
+}
+
+void test_serial() {
+    const unsigned bits[] = {1, 8, 13, 23, 64};
+    for (const unsigned key_bits : bits) {
+        vector<uint64_t> keys(random_keys(1000, key_bits));
+        vector<uint64_t> expected(keys);
+        sort(expected.begin(), expected.end());
+
+        RadixSorter sorter(keys.size(), 1);
+        sorter.sort(keys.data(), keys.size(), key_bits);
+        assert(keys == expected);
+    }
+}
+
+void test_parallel() {
+    const size_t num_threads = 4;
+    // Sizes that don't divide evenly among the threads, and fewer keys
+    // than threads.
+    const size_t sizes[] = {0, 3, 1001, 50000};
+    for (const size_t num_keys : sizes) {
+        vector<uint64_t> keys(random_keys(num_keys, 23));
+        vector<uint64_t> expected(keys);
+        sort(expected.begin(), expected.end());
+
+        RadixSorter sorter(num_keys, num_threads);
+        #pragma omp parallel num_threads(num_threads)
+        {
+            sorter.first_touch();
+            sorter.sort(keys.data(), num_keys, 23);
+        }
+        assert(keys == expected);
+    }
+}
+
+int main(int, char**) {
+    test_serial();
+    test_parallel();
+    return 0;
+}
@@ -0,0 +1,82 @@
+#include <iostream>
+#include <assert.h>
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include "airfoil.h"
+#include "particle.h"
+#include "sat_poly_batch.h"
+#include "sat_poly_collision.h"
+
+using namespace std;
+using namespace wingworks;
+
+namespace {
+    // Particles scattered over and around the airfoil's bounding box,
+    // plus some right on its vertices.
+    vector<Particle> scatter(const Airfoil& foil, const size_t num_particles, const unsigned seed) {
+        const BBox& bbox(foil.shape().bbox());
+        mt19937 gen(seed);
+        uniform_real_distribution<> xrand(bbox.xmin() - 1.0, bbox.xmin() + bbox.width() + 1.0);
+        uniform_real_distribution<> yrand(bbox.ymin() - 1.0, bbox.ymin() + bbox.height() + 1.0);
+        vector<Particle> result(num_particles);
+        for (Particle& p : result) {
+            p.move_to(xrand(gen), yrand(gen));
+        }
+        const vector<Point>& vertices(foil.shape().vertices());
+        for (size_t i = 0; i < vertices.size(); ++i) {
+            result[i * 7].move_to(vertices[i]);
+        }
+        return result;
+    }
+
+    void check_level(const SimdLevel level) {
+        const Airfoil foil(2.0, 3.0, 20.0, 10.0 * M_PI / 180.0);
+        SATPolyCollision collider(foil.shape());
+        SATPolyBatch batch(foil.shape(), level);
+
+        // An odd count leaves a remainder for the scalar kernel.
+        const size_t num_particles = 1003;
+        for (unsigned seed = 1; seed <= 3; ++seed) {
+            const vector<Particle> particles(scatter(foil, num_particles, seed));
+            vector<size_t> indices;
+            for (size_t i = 0; i < num_particles; ++i) {
+                indices.push_back(num_particles - 1 - i);
+            }
+
+            const size_t num_hits = batch.find_collision_normals(
+                particles.data(), indices.data(), indices.size());
+            size_t h = 0;
+            for (size_t k = 0; k < num_particles; ++k) {
+                Vector expected;
+                if (collider.find_collision_normal(particles[indices[k]], expected)) {
+                    assert(h < num_hits);
+                    assert(batch.hit(h) == k);
+                    assert(batch.normal(h).x() == expected.x());
+                    assert(batch.normal(h).y() == expected.y());
+                    h += 1;
+                }
+            }
+            assert(h == num_hits);
+            // Enough of them collide for the test to mean something.
+            assert(num_hits > 20);
+        }
+    }
+}
+
+void test_matches_one_at_a_time() {
+    check_level(SimdLevel::Scalar);
+    const SimdLevel best = best_simd_level();
+    if (best != SimdLevel::Scalar) {
+        check_level(SimdLevel::AVX2);
+    }
+    if (best == SimdLevel::AVX512) {
+        check_level(SimdLevel::AVX512);
+    }
+}
+
+int main(int, char**) {
+    test_matches_one_at_a_time();
+    return 0;
+}
@@ -0,0 +1,121 @@
+#include <iostream>
+#include <assert.h>
+#include <cmath>
+#include <vector>
+
+#include <mpi.h>
+
+#include "point.h"
+#include "particle.h"
+#include "airfoil.h"
+#include "world.h"
+#include "slab_world.h"
+#include "world_fixture.h"
+
+using namespace std;
+using namespace wingworks;
+using namespace wingworks::fixture;
+
+// Run with any number of ranks, e.g. mpirun -np 4 test_slab_world.
+// Rank 0 steps an ordinary World alongside, and checks that the ranks
+// together compute exactly its particles.
+
+namespace {
+    bool close(const double v1, const double v2, const double eps = 1.0e-9) {
+        const double scale = ::fabs(v1) + ::fabs(v2);
+        return ::fabs(v1 - v2) <= eps * ((scale > 1.0) ? scale : 1.0);
+    }
+
+    template <typename Real>
+    bool same_particles(const BasicWorld<Real>& world, const vector<BasicParticle<Real>>& gathered) {
+        if (world.num_particles() != gathered.size()) {
+            return false;
+        }
+        for (size_t id = 0; id < gathered.size(); ++id) {
+            const BasicParticle<Real>& p1(world.particle(id));
+            const BasicParticle<Real>& p2(gathered[id]);
+            if ((p1.pos_x() != p2.pos_x()) || (p1.pos_y() != p2.pos_y())
+                || (p1.vel().x() != p2.vel().x()) || (p1.vel().y() != p2.vel().y())) {
+                cout << "Particle " << id << " differs: "
+                     << p1.pos().to_str() << " vs. " << p2.pos().to_str() << endl;
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // The world is stepped through a few checkpoints, long enough for
+    // particles to cross slabs and to be recycled.
+    template <typename Real>
+    void check_matches_world(const WorldOptions& options, const size_t max_speed_factor = 1) {
+        const double speed = max_speed * max_speed_factor;
+        const Vector slanted_wind(wind.x() * max_speed_factor, 0.03);
+        BasicSlabWorld<Real> slabs(
+            MPI_COMM_WORLD, make_airfoil(), world_width, world_height, speed, slanted_wind, options);
+
+        const bool root = (slabs.rank() == 0);
+        BasicWorld<Real> *world = root
+            ? new BasicWorld<Real>(
+                make_airfoil(), world_width, world_height, speed, slanted_wind, options)
+            : nullptr;
+
+        const size_t checkpoints[] = {0, 1, 5, 30};
+        size_t done = 0;
+        for (const size_t step : checkpoints) {
+            slabs.step_many(step - done);
+            if (root) {
+                world->step_many(step - done);
+            }
+            done = step;
+
+            const vector<BasicParticle<Real>> gathered(slabs.gather_particles());
+            const Vector force(slabs.force_on_foil());
+            const double momentum = slabs.momentum();
+            if (root) {
+                assert(same_particles(*world, gathered));
+                assert(close(force.x(), world->force_on_foil().x()));
+                assert(close(force.y(), world->force_on_foil().y()));
+                assert(close(momentum, world->momentum()));
+            }
+        }
+        delete world;
+    }
+}
+
+void test_matches_world() {
+    check_matches_world<double>(seeded_options());
+}
+
+void test_single_precision_matches_world() {
+    check_matches_world<float>(seeded_options());
+}
+
+// Fast particles cross slabs every few steps; narrow cells make the
+// search reach, and so the halo, deeper.
+void test_fast_particles_narrow_cells() {
+    WorldOptions options(seeded_options());
+    options.cell_extent = 0.6;
+    check_matches_world<double>(options, 4);
+}
+
+void test_owns_every_particle_once() {
+    SlabWorld slabs(
+        MPI_COMM_WORLD, make_airfoil(), world_width, world_height, max_speed,
+        wind, seeded_options());
+    slabs.step_many(10);
+    unsigned long local = slabs.num_local_particles();
+    unsigned long total = 0;
+    MPI_Allreduce(&local, &total, 1, MPI_UNSIGNED_LONG, MPI_SUM, MPI_COMM_WORLD);
+    assert(total == slabs.num_particles());
+    assert(slabs.end_row() > slabs.first_row());
+}
+
+int main(int argc, char **argv) {
+    MPI_Init(&argc, &argv);
+    test_matches_world();
+    test_single_precision_matches_world();
+    test_fast_particles_narrow_cells();
+    test_owns_every_particle_once();
+    MPI_Finalize();
+    return 0;
+}
@@ -0,0 +1,169 @@
+#include <iostream>
+#include <assert.h>
+#include <cmath>
+
+#include "point.h"
+#include "particle.h"
+#include "species.h"
+#include "airfoil.h"
+#include "world.h"
+
+using namespace std;
+using namespace wingworks;
+
+namespace {
+    using MixedParticle = BasicParticle<double, MixedSpecies>;
+    using MixedWorld = BasicWorld<double, MixedSpecies>;
+
+    const double world_width = 32.0;
+    const double world_height = 18.0;
+
+    bool close(const double v1, const double v2, const double eps = 1.0e-12) {
+        const double scale = ::fabs(v1) + ::fabs(v2);
+        return ::fabs(v1 - v2) <= eps * ((scale > 1.0) ? scale : 1.0);
+    }
+
+    template <typename P>
+    void set_up_pair(P& p1, P& p2) {
+        p1.move_to(1.0, 1.0);
+        p1.set_vel(0.25, -0.125);
+        p2.move_to(1.6, 1.3);
+        p2.set_vel(-0.5, 0.0625);
+    }
+
+    MixedWorld *make_world(const WorldOptions& options) {
+        return new MixedWorld(
+            Airfoil(world_width / 8.0, world_height / 2.0, world_width / 4.0, 10.0 * M_PI / 180.0),
+            world_width, world_height, 0.05, Vector(0.11, 0.0), options);
+    }
+
+    bool same_state(const MixedWorld& w1, const MixedWorld& w2) {
+        for (size_t i = 0; i < w1.num_particles(); ++i) {
+            const MixedParticle& p1(w1.particle(i));
+            const MixedParticle& p2(w2.particle(i));
+            if ((p1.species() != p2.species())
+                || (p1.pos_x() != p2.pos_x()) || (p1.pos_y() != p2.pos_y())
+                || (p1.vel().x() != p2.vel().x()) || (p1.vel().y() != p2.vel().y())) {
+                cout << "Particle " << i << " differs." << endl;
+                return false;
+            }
+        }
+        return true;
+    }
+}
+
+void test_uniform_particles_are_compact() {
+    // Uniform particles store only position and velocity; mixed ones
+    // add a species index.
+    assert(sizeof(Particle) == 4 * sizeof(double));
+    assert(sizeof(BasicParticle<float>) == 4 * sizeof(float));
+    assert(sizeof(MixedParticle) > sizeof(Particle));
+    assert(sizeof(MixedParticle) <= 5 * sizeof(double));
+}
+
+void test_default_table_matches_uniform() {
+    Particle u1, u2;
+    MixedParticle m1, m2;
+    set_up_pair(u1, u2);
+    set_up_pair(m1, m2);
+    assert(u1.is_colliding_with(u2) && m1.is_colliding_with(m2));
+    u1.collide_with(u2);
+    m1.collide_with(m2);
+    assert(u1.vel().x() == m1.vel().x() && u1.vel().y() == m1.vel().y());
+    assert(u2.vel().x() == m2.vel().x() && u2.vel().y() == m2.vel().y());
+}
+
+void test_mixed_collision_conserves() {
+    MixedSpecies::set_table({{1.0, 0.5, 1.0}, {4.0, 1.0, 1.0}});
+    assert(MixedSpecies::max_radius() == 1.0);
+
+    MixedParticle light, heavy;
+    set_up_pair(light, heavy);
+    heavy.set_species(1);
+    heavy.move_to(2.2, 1.5);
+    assert(heavy.mass() == 4.0 && heavy.radius() == 1.0);
+    // Too far apart for two light particles, close enough with a heavy one.
+    assert(light.pos().dist_sqr(heavy.pos()) > 1.0);
+    assert(light.is_colliding_with(heavy));
+
+    const Vector p0(light.vel().scaled(light.mass()).adding(heavy.vel().scaled(heavy.mass())));
+    const double e0 = 0.5 * (light.mass() * light.vel().mag_sqr() + heavy.mass() * heavy.vel().mag_sqr());
+    light.collide_with(heavy);
+    const Vector pf(light.vel().scaled(light.mass()).adding(heavy.vel().scaled(heavy.mass())));
+    const double ef = 0.5 * (light.mass() * light.vel().mag_sqr() + heavy.mass() * heavy.vel().mag_sqr());
+    assert(close(p0.x(), pf.x()) && close(p0.y(), pf.y()));
+    assert(close(e0, ef));
+
+    MixedSpecies::set_table({{1.0, 0.5, 1.0}});
+}
+
+void test_bad_tables_rejected() {
+    const vector<vector<SpeciesInfo>> bad_tables {
+        {},
+        {{0.0, 0.5, 1.0}},
+        {{1.0, -0.5, 1.0}},
+        {{1.0, 0.5, -1.0}, {1.0, 0.5, 2.0}},
+        {{1.0, 0.5, 0.0}},
+        vector<SpeciesInfo>(MixedSpecies::max_species + 1, SpeciesInfo {1.0, 0.5, 1.0}),
+    };
+    for (const vector<SpeciesInfo>& table : bad_tables) {
+        bool threw = false;
+        try {
+            MixedSpecies::set_table(table);
+        } catch (const invalid_argument&) {
+            threw = true;
+        }
+        assert(threw);
+    }
+    // A rejected table leaves the old one in place.
+    assert(MixedSpecies::num_species() == 1);
+
+    bool threw = false;
+    MixedParticle p;
+    try {
+        p.set_species(1);
+    } catch (const invalid_argument&) {
+        threw = true;
+    }
+    assert(threw);
+}
+
+void test_mixed_world() {
+    MixedSpecies::set_table({{1.0, 0.5, 3.0}, {4.0, 1.0, 1.0}});
+    WorldOptions options;
+    options.seed = 1234;
+    MixedWorld *phased = make_world(options);
+    options.executor = StepExecutor::Fused;
+    MixedWorld *fused = make_world(options);
+
+    const size_t n = phased->num_particles();
+    vector<size_t> species(n);
+    size_t num_heavy = 0;
+    for (size_t i = 0; i < n; ++i) {
+        species[i] = phased->particle(i).species();
+        num_heavy += species[i];
+    }
+    // About a quarter of the particles are heavy.
+    assert(::fabs(double(num_heavy) / n - 0.25) < 0.03);
+
+    phased->step_many(10);
+    fused->step_many(10);
+    assert(same_state(*phased, *fused));
+    // Particles keep their species, even when recycled.
+    for (size_t i = 0; i < n; ++i) {
+        assert(phased->particle(i).species() == species[i]);
+    }
+
+    delete fused;
+    delete phased;
+    MixedSpecies::set_table({{1.0, 0.5, 1.0}});
+}
+
+int main(int, char**) {
+    test_uniform_particles_are_compact();
+    test_default_table_matches_uniform();
+    test_mixed_collision_conserves();
+    test_bad_tables_rejected();
+    test_mixed_world();
+    return 0;
+}
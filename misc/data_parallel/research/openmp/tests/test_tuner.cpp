@@ -0,0 +1,142 @@
+#include <iostream>
+#include <assert.h>
+#include <cmath>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <vector>
+
+#include <omp.h>
+
+#include "airfoil.h"
+#include "world.h"
+#include "tuner.h"
+#include "world_fixture.h"
+
+using namespace std;
+using namespace wingworks;
+using namespace wingworks::fixture;
+
+namespace {
+    unique_ptr<World> new_world(const WorldOptions& options) {
+        return unique_ptr<World>(new World(
+            make_airfoil(), world_width, world_height, max_speed, wind, options));
+    }
+
+    struct OpenMPSettings {
+        int max_threads;
+        omp_sched_t kind;
+        int chunk;
+
+        OpenMPSettings() : max_threads(omp_get_max_threads()) {
+            omp_get_schedule(&kind, &chunk);
+        }
+
+        bool operator==(const OpenMPSettings& other) const {
+            return (max_threads == other.max_threads) && (kind == other.kind) && (chunk == other.chunk);
+        }
+    };
+}
+
+// A profile reads back as it was written, and malformed ones throw.
+void test_profile_round_trip() {
+    TuningProfile profile;
+    profile.cell_extent = 1.5;
+    profile.num_threads = 3;
+    profile.schedule = LoopSchedule::Guided;
+    profile.chunk_size = 16;
+    profile.steps_per_second = 41.75;
+
+    stringstream buf;
+    profile.write(buf);
+    const TuningProfile read(TuningProfile::read(buf));
+    assert(read.cell_extent == profile.cell_extent);
+    assert(read.num_threads == profile.num_threads);
+    assert(read.schedule == profile.schedule);
+    assert(read.chunk_size == profile.chunk_size);
+    assert(read.steps_per_second == profile.steps_per_second);
+
+    WorldOptions options;
+    read.apply_to(options);
+    assert(options.cell_extent == 1.5 && options.num_threads == 3);
+    assert(options.schedule == LoopSchedule::Guided && options.chunk_size == 16);
+
+    for (const string bad : {"cell_extent", "bogus=1", "schedule=sometimes", "num_threads=many"}) {
+        istringstream ins(bad + "\n");
+        bool threw = false;
+        try {
+            TuningProfile::read(ins);
+        } catch (const invalid_argument&) {
+            threw = true;
+        }
+        assert(threw);
+    }
+}
+
+// Calibration settles on one of the candidates it was given.
+void test_picks_candidate() {
+    Tuner tuner(new_world, 1, 2);
+    const vector<double> extents {1.0, 2.0};
+    const vector<Tuner::ScheduleChoice> schedules {
+        {LoopSchedule::Static, 0}, {LoopSchedule::Dynamic, 64}};
+    const vector<size_t> thread_counts {1, 2};
+    tuner.set_cell_extents(extents);
+    tuner.set_schedules(schedules);
+    tuner.set_thread_counts(thread_counts);
+
+    WorldOptions base;
+    base.num_threads = 1;
+    ostringstream log;
+    const OpenMPSettings before;
+    const TuningProfile best(tuner.calibrate(base, log));
+    cout << log.str();
+
+    assert(best.steps_per_second > 0.0);
+    assert((best.cell_extent == 1.0) || (best.cell_extent == 2.0));
+    bool known_schedule = false;
+    for (const Tuner::ScheduleChoice& choice : schedules) {
+        known_schedule |= (best.schedule == choice.schedule) && (best.chunk_size == choice.chunk_size);
+    }
+    assert(known_schedule);
+    assert((best.num_threads == 1) || (best.num_threads == 2));
+    assert(OpenMPSettings() == before);
+
+    bool threw = false;
+    try {
+        Tuner(new_world, 1, 2, 2);
+    } catch (const invalid_argument&) {
+        threw = true;
+    }
+    assert(threw);
+}
+
+// A World runs with its own thread count and schedule, without changing
+// the host program's.
+void test_leaves_openmp_settings() {
+    omp_set_schedule(omp_sched_static, 5);
+    const OpenMPSettings before;
+
+    WorldOptions options;
+    options.num_threads = 3;
+    options.schedule = LoopSchedule::Dynamic;
+    options.chunk_size = 7;
+    unique_ptr<World> world(new_world(options));
+    assert(OpenMPSettings() == before);
+    world->step_many(2);
+    assert(OpenMPSettings() == before);
+
+    size_t team_size = 0;
+    #pragma omp parallel
+    {
+        #pragma omp single
+        team_size = omp_get_num_threads();
+    }
+    assert(int(team_size) == before.max_threads);
+}
+
+int main(int, char**) {
+    test_profile_round_trip();
+    test_picks_candidate();
+    test_leaves_openmp_settings();
+    return 0;
+}
@@ -0,0 +1,158 @@
+#include <iostream>
+#include <assert.h>
+#include <atomic>
+#include <cmath>
+#include <new>
+#include <stdexcept>
+#include <vector>
+
+#include "world_cells.h"
+#include "airfoil.h"
+#include "world.h"
+#include "world_fixture.h"
+
+using namespace std;
+using namespace wingworks;
+using namespace wingworks::fixture;
+
+// Count heap allocations made through operator new.
+namespace {
+    atomic<size_t> num_allocations(0);
+}
+
+void *operator new(size_t size) {
+    num_allocations += 1;
+    void *result = malloc(size ? size : 1);
+    if (!result) {
+        throw bad_alloc();
+    }
+    return result;
+}
+
+void operator delete(void *p) noexcept {
+    free(p);
+}
+
+void operator delete(void *p, size_t) noexcept {
+    free(p);
+}
+
+namespace {
+    auto by_index() {
+        return [](const size_t i1, const size_t i2) { return i1 < i2; };
+    }
+
+    bool holds(const WorldCells& cells, const size_t i_cell, const vector<size_t>& expected) {
+        const Cell& cell = cells.cell(i_cell);
+        if (cell.size() != expected.size()) {
+            return false;
+        }
+        for (size_t k = 0; k < cell.size(); ++k) {
+            if (cell[k] != expected[k]) {
+                return false;
+            }
+        }
+        return true;
+    }
+}
+
+void test_hot_cell_overflows() {
+    // 16 cells, 64 particles: 8 slots per cell.
+    WorldCells cells(4.0, 4.0, 1.0, 1.0, 64);
+    assert(cells.slab_capacity() == 8);
+
+    vector<size_t> expected;
+    for (size_t i = 0; i < 40; ++i) {
+        cells.add_to(5, i);
+        expected.push_back(i);
+    }
+    cells.add_to(6, 40);
+    assert(holds(cells, 5, expected));
+    assert(holds(cells, 6, {40}));
+    assert(cells.overflow_used() > 0);
+
+    cells.clear();
+    assert(cells.overflow_used() == 0);
+    for (size_t i = 0; i < cells.size(); ++i) {
+        assert(cells.cell(i).empty());
+    }
+}
+
+void test_moves_compact_overflow() {
+    // Incremental cells are never cleared; moving a crowd back and
+    // forth must not exhaust the overflow area.
+    const size_t num_particles = 64;
+    WorldCells cells(4.0, 4.0, 1.0, 1.0, num_particles);
+    vector<size_t> home(num_particles);
+    for (size_t i = 0; i < num_particles; ++i) {
+        home[i] = i % 2;
+        cells.add_to(home[i], i);
+    }
+    for (size_t round = 0; round < 50; ++round) {
+        const size_t to = 2 + round % 14;
+        for (size_t i = 0; i < num_particles; ++i) {
+            cells.move(i, home[i], to, by_index());
+            home[i] = to;
+        }
+        vector<size_t> expected;
+        for (size_t i = 0; i < num_particles; ++i) {
+            expected.push_back(i);
+        }
+        assert(holds(cells, to, expected));
+    }
+}
+
+void test_too_many_particles_rejected() {
+    WorldCells cells(4.0, 4.0, 1.0, 1.0, 16);
+    bool threw = false;
+    try {
+        for (size_t i = 0; i < 1000; ++i) {
+            cells.add_to(0, i);
+        }
+    } catch (const invalid_argument&) {
+        threw = true;
+    }
+    assert(threw);
+}
+
+void test_steady_state_does_not_allocate() {
+    const StepExecutor executors[] = {StepExecutor::Phased, StepExecutor::Fused};
+    for (const StepExecutor executor : executors) {
+        for (const bool incremental : {false, true}) {
+            WorldOptions options(seeded_options());
+            options.executor = executor;
+            options.incremental_cells = incremental;
+            options.collect_cell_stats = true;
+            World world(make_world(options));
+            // Let per-thread buffers reach their working sizes.
+            world.step_many(8);
+
+            const size_t before = num_allocations;
+            world.step_many(8);
+            assert(num_allocations == before);
+        }
+    }
+}
+
+// Coarsening sorts each merging cell in per-thread scratch, reserved up
+// front.
+void test_coarsening_does_not_allocate() {
+    WorldOptions options(seeded_options());
+    options.coarsen = true;
+    BasicWorld<double, WeightedSpecies> world(
+        make_world<BasicWorld<double, WeightedSpecies>>(options));
+    world.step_many(8);
+
+    const size_t before = num_allocations;
+    world.step_many(4 * options.coarsen_interval);
+    assert(num_allocations == before);
+}
+
+int main(int, char**) {
+    test_hot_cell_overflows();
+    test_moves_compact_overflow();
+    test_too_many_particles_rejected();
+    test_steady_state_does_not_allocate();
+    test_coarsening_does_not_allocate();
+    return 0;
+}
@@ -0,0 +1,229 @@
+#include <iostream>
+#include <assert.h>
+#include <cmath>
+#include <algorithm>
+#include <numeric>
+#include <vector>
+
+#include <omp.h>
+
+#include "point.h"
+#include "particle.h"
+#include "airfoil.h"
+#include "world.h"
+#include "world_fixture.h"
+
+using namespace std;
+using namespace wingworks;
+using namespace wingworks::fixture;
+
+namespace {
+    bool close(const double v1, const double v2, const double eps = 1.0e-9) {
+        const double scale = ::fabs(v1) + ::fabs(v2);
+        return ::fabs(v1 - v2) <= eps * ((scale > 1.0) ? scale : 1.0);
+    }
+
+    // Particle states must match exactly.  The force on the foil is
+    // summed in thread-dependent order, so it need only be close.
+    bool same_state(const World& w1, const World& w2) {
+        if (w1.num_particles() != w2.num_particles()) {
+            return false;
+        }
+        for (size_t i = 0; i < w1.num_particles(); ++i) {
+            const Particle& p1(w1.particle(i));
+            const Particle& p2(w2.particle(i));
+            if ((p1.pos_x() != p2.pos_x()) || (p1.pos_y() != p2.pos_y())
+                || (p1.vel().x() != p2.vel().x()) || (p1.vel().y() != p2.vel().y())) {
+                cout << "Particle " << i << " differs: "
+                     << p1.pos().to_str() << " vs. " << p2.pos().to_str() << endl;
+                return false;
+            }
+        }
+        const Vector& f1(w1.force_on_foil());
+        const Vector& f2(w2.force_on_foil());
+        return close(f1.x(), f2.x()) && close(f1.y(), f2.y());
+    }
+}
+
+void test_step_many_matches_step() {
+    const WorldOptions options(seeded_options());
+    World w1(make_world(options));
+    World w2(make_world(options));
+
+    const size_t num_steps = 10;
+    for (size_t i = 0; i < num_steps; ++i) {
+        w1.step();
+    }
+    w2.step_many(num_steps);
+
+    assert(w1.step_count() == num_steps);
+    assert(w2.step_count() == num_steps);
+    assert(same_state(w1, w2));
+}
+
+void test_thread_count_independent() {
+    WorldOptions options(seeded_options());
+    options.num_threads = 1;
+    World w1(make_world(options));
+    options.num_threads = 4;
+    options.schedule = LoopSchedule::Dynamic;
+    options.chunk_size = 7;
+    World w2(make_world(options));
+
+    w1.step_many(10);
+    w2.step_many(10);
+    assert(same_state(w1, w2));
+}
+
+void test_fused_matches_phased() {
+    const double extents[] = {1.0, 0.5};
+    const size_t tiles[] = {16, 3, 1};
+    const size_t threads[] = {1, 4};
+    for (const double extent : extents) {
+        WorldOptions options(seeded_options());
+        options.cell_extent = extent;
+        World phased(make_world(options));
+        phased.step_many(10);
+
+        options.executor = StepExecutor::Fused;
+        for (const size_t tile : tiles) {
+            for (const size_t num_threads : threads) {
+                options.tile_columns = tile;
+                options.num_threads = num_threads;
+                World fused(make_world(options));
+                fused.step_many(10);
+                assert(same_state(phased, fused));
+            }
+        }
+    }
+}
+
+void test_incremental_cells_match() {
+    const StepExecutor executors[] = {StepExecutor::Phased, StepExecutor::Fused};
+    const size_t threads[] = {1, 4};
+    for (const StepExecutor executor : executors) {
+        WorldOptions options(seeded_options());
+        options.executor = executor;
+        World rebuilt(make_world(options));
+        rebuilt.step_many(20);
+
+        options.incremental_cells = true;
+        for (const size_t num_threads : threads) {
+            options.num_threads = num_threads;
+            World incremental(make_world(options));
+            incremental.step_many(20);
+            assert(same_state(rebuilt, incremental));
+            // Few particles change cells in a step.
+            assert(incremental.cell_migrations() > 0);
+            assert(incremental.cell_migrations() < incremental.num_particles() * 20 / 4);
+        }
+    }
+}
+
+// Reordering storage changes neither results nor particle IDs.
+void test_reordering_matches() {
+    const StepExecutor executors[] = {StepExecutor::Phased, StepExecutor::Fused};
+    const size_t threads[] = {1, 4};
+    for (const StepExecutor executor : executors) {
+        WorldOptions options(seeded_options());
+        options.executor = executor;
+        World plain(make_world(options));
+        plain.step_many(20);
+
+        options.reorder_interval = 7;
+        for (const size_t num_threads : threads) {
+            options.num_threads = num_threads;
+            options.incremental_cells = true;
+            World reordered(make_world(options));
+            reordered.step_many(20);
+            assert(same_state(plain, reordered));
+        }
+    }
+}
+
+void test_balanced_cells_match() {
+    const size_t threads[] = {1, 3, 4};
+    WorldOptions options(seeded_options());
+    World plain(make_world(options));
+    plain.step_many(20);
+
+    options.balance_cells = true;
+    options.balance_interval = 3;
+    for (const size_t num_threads : threads) {
+        options.num_threads = num_threads;
+        World balanced(make_world(options));
+        balanced.step_many(20);
+        assert(same_state(plain, balanced));
+    }
+}
+
+// Huge pages and parallel first touch change only where storage lives.
+void test_huge_pages_match() {
+    const StepExecutor executors[] = {StepExecutor::Phased, StepExecutor::Fused};
+    const size_t threads[] = {1, 4};
+    for (const StepExecutor executor : executors) {
+        WorldOptions options(seeded_options());
+        options.executor = executor;
+        options.reorder_interval = 7;
+        World plain(make_world(options));
+        plain.step_many(20);
+
+        options.huge_pages = true;
+        for (const size_t num_threads : threads) {
+            options.num_threads = num_threads;
+            World huge(make_world(options));
+            huge.step_many(20);
+            assert(same_state(plain, huge));
+        }
+    }
+}
+
+// Particles that leave the world are recycled in a pass of their own,
+// split evenly over the threads however unevenly integration was.  The
+// results match recycling each particle as soon as it leaves, as the
+// Fused executor does.
+void test_recycle_pass() {
+    WorldOptions options(seeded_options());
+    options.executor = StepExecutor::Fused;
+    options.num_threads = 1;
+    World inline_recycled(make_world(options));
+    const size_t num_steps = 30;
+    inline_recycled.step_many(num_steps);
+
+    const LoopSchedule schedules[] = {LoopSchedule::Static, LoopSchedule::Dynamic, LoopSchedule::Guided};
+    const size_t threads[] = {1, 3, 4};
+    for (const LoopSchedule schedule : schedules) {
+        for (const size_t num_threads : threads) {
+            options = seeded_options();
+            options.schedule = schedule;
+            options.chunk_size = 1;
+            options.num_threads = num_threads;
+            World world(make_world(options));
+
+            size_t total = 0;
+            for (size_t step = 0; step < num_steps; ++step) {
+                world.step();
+                const vector<size_t>& split(world.recycled_per_thread());
+                assert(split.size() == num_threads);
+                const size_t least = *min_element(split.begin(), split.end());
+                const size_t most = *max_element(split.begin(), split.end());
+                assert(most - least <= 1);
+                total += accumulate(split.begin(), split.end(), size_t(0));
+            }
+            assert(total > 0);
+            assert(same_state(inline_recycled, world));
+        }
+    }
+}
+
+int main(int, char**) {
+    test_step_many_matches_step();
+    test_thread_count_independent();
+    test_fused_matches_phased();
+    test_incremental_cells_match();
+    test_reordering_matches();
+    test_balanced_cells_match();
+    test_huge_pages_match();
+    test_recycle_pass();
+    return 0;
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+
+#include "airfoil.h"
+#include "vector.h"
+#include "world.h"
+#include "world_options.h"
+
+// The world most tests step: the demo's foil, a quarter of the world's
+// width at 10 degrees, in a 32 x 18 world with the demo's wind.
+namespace wingworks {
+namespace fixture {
+    const double world_width = 32.0;
+    const double world_height = 18.0;
+    const double max_speed = 0.0005;
+    const Vector wind(0.11, 0.0);
+
+    inline Airfoil make_airfoil() {
+        return Airfoil(
+            world_width / 8.0, world_height / 2.0, world_width / 4.0,
+            10.0 * M_PI / 180.0);
+    }
+
+    inline WorldOptions seeded_options(const uint64_t seed = 1234) {
+        WorldOptions options;
+        options.seed = seed;
+        return options;
+    }
+
+    // A world of the given size around foil, in the wind.
+    template <typename W = World>
+    W make_world(
+        const Airfoil& foil, const double width, const double height,
+        const WorldOptions& options, const double speed = max_speed)
+    {
+        return W(foil, width, height, speed, wind, options);
+    }
+
+    template <typename W = World>
+    W make_world(const WorldOptions& options, const double speed = max_speed) {
+        return make_world<W>(make_airfoil(), world_width, world_height, options, speed);
+    }
+}
+}